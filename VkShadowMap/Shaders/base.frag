@@ -21,7 +21,15 @@ struct DirectionalLight
     float shininess;
 };
 
-layout(std140, binding = 1) uniform LightBuffer
+layout(std140, set = 0, binding = 0) uniform TransformBuffer
+{
+    mat4 view;
+    mat4 projection;
+    vec3 cameraPosition;
+    mat4 cameraView;
+} transformBuffer;
+
+layout(std140, set = 0, binding = 1) uniform LightBuffer
 {
     uint numPointLights;
     PointLight pointLights[16];
@@ -30,23 +38,22 @@ layout(std140, binding = 1) uniform LightBuffer
     DirectionalLight directionalLights[16];
 } lightBuffer;
 
-layout(std140, binding = 2) uniform MaterialBuffer
+layout(std140, set = 1, binding = 0) uniform MaterialBuffer
 {
     vec4 ambient;
     vec4 diffuse;
     vec4 specular;
 } materialBuffer;
 
-layout(std140, binding = 3) uniform DebugBuffer
-{
-    bool bAttenuation;
-    bool bGammaCorrection;
-    bool bToneMapping;
-} debugBuffer;
+// Feature toggles are baked into each pipeline permutation, so disabled paths are compiled out.
+layout(constant_id = 0) const bool bAttenuation = false;
+layout(constant_id = 1) const bool bGammaCorrection = false;
+layout(constant_id = 2) const bool bToneMapping = false;
+
+layout(set = 0, binding = 2) uniform sampler2D shadowSampler;
 
-layout(binding = 4) uniform sampler2D baseColorSampler;
-layout(binding = 5) uniform sampler2D normalSampler;
-layout(binding = 6) uniform sampler2D shadowSampler;
+layout(set = 1, binding = 1) uniform sampler2D baseColorSampler;
+layout(set = 1, binding = 2) uniform sampler2D normalSampler;
 
 layout(location = 0) in vec4 inPosition;
 layout(location = 1) in vec3 inNormal;
@@ -88,14 +95,15 @@ void main()
     for (int i = 0; i < lightBuffer.numPointLights; ++i)
     {
 		PointLight light = lightBuffer.pointLights[i];
+		vec3 lightPosition = vec3(transformBuffer.cameraView * vec4(light.position, 1.0));
 
-		vec3 L = normalize(light.position.xyz - inPosition.xyz);
+		vec3 L = normalize(lightPosition - inPosition.xyz);
 		vec3 H = normalize(L + V);
 		
-		float d = length(light.position - inPosition.xyz);
+		float d = length(lightPosition - inPosition.xyz);
 		float denom = light.attenuation.x + light.attenuation.y * d + light.attenuation.z * d * d;
 
-        if (!debugBuffer.bAttenuation)
+        if (!bAttenuation)
         {
             denom = 1.0;
         }
@@ -109,7 +117,7 @@ void main()
     {
         DirectionalLight light = lightBuffer.directionalLights[i];
 
-        vec3 L = normalize(light.direction);
+        vec3 L = normalize(mat3(transformBuffer.cameraView) * light.direction);
         vec3 H = normalize(L + V);
 
         ambient += materialBuffer.ambient * light.ambient;
@@ -119,12 +127,12 @@ void main()
 
     outColor = (ambient + diffuse + specular) * texture(baseColorSampler, inTexCoord);
 
-    if (debugBuffer.bGammaCorrection)
+    if (bGammaCorrection)
     {
 		outColor = gammaCorrection(outColor);
     }
 
-    if (debugBuffer.bToneMapping)
+    if (bToneMapping)
     {
 		outColor = hdrToneMapping(outColor);
     }
@@ -0,0 +1,15 @@
+mat3 getNormalMatrix(mat3 modelView)
+{
+    // A rotation with uniform scale only differs from its inverse transpose by a scale factor, which the
+    // normalization of every transformed direction removes. That needs columns of equal length that are
+    // also mutually orthogonal; equal lengths alone still admit shears.
+    vec3 scaleSq = vec3(dot(modelView[0], modelView[0]), dot(modelView[1], modelView[1]), dot(modelView[2], modelView[2]));
+    vec3 skew = vec3(dot(modelView[0], modelView[1]), dot(modelView[0], modelView[2]), dot(modelView[1], modelView[2]));
+    vec3 tolerance = vec3(scaleSq.x * 1e-4);
+    if (all(lessThan(abs(scaleSq - scaleSq.x), tolerance)) && all(lessThan(abs(skew), tolerance)))
+    {
+        return modelView;
+    }
+
+    return transpose(inverse(modelView));
+}
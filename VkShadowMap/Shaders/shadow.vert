@@ -1,10 +1,11 @@
 #version 450
 
-layout(std140, binding = 0) uniform TransformBuffer
+layout(std140, set = 0, binding = 0) uniform TransformBuffer
 {
     mat4 view;
     mat4 projection;
     vec3 cameraPosition;
+    mat4 cameraView;
 } transformBuffer;
 
 layout(location = 0) in vec3 inPosition;
@@ -12,16 +13,21 @@ layout(location = 1) in vec3 inNormal;
 layout(location = 2) in vec2 inTexCoord;
 layout(location = 3) in vec3 inTangent;
 
-layout(location = 4) in mat4 inModel;
-layout(location = 8) in mat4 inModelView;
-layout(location = 12) in mat4 inNormalMatrix;
+layout(location = 4) in vec4 inModelRow0;
+layout(location = 5) in vec4 inModelRow1;
+layout(location = 6) in vec4 inModelRow2;
 
 layout(location = 0) out vec4 outPosition;
 layout(location = 1) out vec3 outNormal;
 layout(location = 2) out vec2 outTexCoord;
 layout(location = 3) out mat3 outTBN;
 
+mat4 getModelMatrix()
+{
+    return transpose(mat4(inModelRow0, inModelRow1, inModelRow2, vec4(0.0, 0.0, 0.0, 1.0)));
+}
+
 void main()
 {
-    gl_Position = transformBuffer.projection * transformBuffer.view * inModel * vec4(inPosition, 1.0);
+    gl_Position = transformBuffer.projection * transformBuffer.view * getModelMatrix() * vec4(inPosition, 1.0);
 }
\ No newline at end of file
@@ -1,4 +1,5 @@
 #version 450
+#extension GL_GOOGLE_include_directive : require
 
 struct Light
 {
@@ -10,11 +11,12 @@ struct Light
     float shininess;
 };
 
-layout(std140, binding = 0) uniform TransformBufferObject
+layout(std140, set = 0, binding = 0) uniform TransformBufferObject
 {
     mat4 view;
     mat4 projection;
     vec3 cameraPosition;
+    mat4 cameraView;
 } transformBuffer;
 
 layout(location = 0) in vec3 inPosition;
@@ -22,19 +24,27 @@ layout(location = 1) in vec3 inNormal;
 layout(location = 2) in vec2 inTexCoord;
 layout(location = 3) in vec3 inTangent;
 
-layout(location = 4) in mat4 inModel;
-layout(location = 8) in mat4 inModelView;
-layout(location = 12) in mat4 inNormalMatrix;
+layout(location = 4) in vec4 inModelRow0;
+layout(location = 5) in vec4 inModelRow1;
+layout(location = 6) in vec4 inModelRow2;
 
 layout(location = 0) out vec3 outNormal;
 layout(location = 1) out vec3 outTangent;
 layout(location = 2) out vec3 outBitangent;
 
+mat4 getModelMatrix()
+{
+    return transpose(mat4(inModelRow0, inModelRow1, inModelRow2, vec4(0.0, 0.0, 0.0, 1.0)));
+}
+
+#include "normalMatrix.glsl"
+
 void main()
 {
-    mat3 normalMatrix = mat3(inNormalMatrix);
+    mat4 modelView = transformBuffer.cameraView * getModelMatrix();
+    mat3 normalMatrix = getNormalMatrix(mat3(modelView));
 
-    vec4 position = inModelView * vec4(inPosition, 1.0);
+    vec4 position = modelView * vec4(inPosition, 1.0);
     gl_Position = transformBuffer.projection * position;
 
     outNormal = normalize(vec3(transformBuffer.projection * transformBuffer.view * vec4(normalMatrix * inNormal, 0.0)));
@@ -5,12 +5,22 @@
 #include "Texture2D.h"
 #include "TextureCube.h"
 #include "Widget.h"
+#include "CpuProfiler.h"
 
 #include "VulkanContext.h"
 #include "VulkanModel.h"
 #include "VulkanScene.h"
 #include "VulkanMeshRenderer.h"
 #include "VulkanUIRenderer.h"
+#include "VulkanNullBackend.h"
+#include "VulkanReadback.h"
+#include "VulkanGpuProfiler.h"
+#include "VulkanViewport.h"
+#include "VulkanLatency.h"
+#include "VulkanPipelineCache.h"
+#include "VulkanPipelineLibrary.h"
+#include "VulkanShaderCache.h"
+#include "VulkanSamplerCache.h"
 
 #include "Engine.h"
 #include "World.h"
@@ -22,8 +32,6 @@
 #include "SkyActor.h"
 
 #include <ctime>
-#include <chrono>
-#include <thread>
 #include <iostream>
 #include <stdexcept>
 #include <cstdlib>
@@ -104,6 +112,36 @@ void FMainWidget::Draw()
 		bInitialized = true;
 	}
 
+	FFrameStats FrameStats = GEngine->GetFrameStats();
+	ImGui::Text("Frame: %.2f ms avg, %.2f ms p99 (%.0f fps)", FrameStats.AverageFrameMs, FrameStats.P99FrameMs, FrameStats.GetAverageFPS());
+
+	FVulkanViewport* Viewport = GEngine->GetRenderContext()->GetViewport();
+
+	const char* PresentProfileNames[static_cast<uint32_t>(EPresentProfile::Num)];
+	for (uint32_t Idx = 0; Idx < static_cast<uint32_t>(EPresentProfile::Num); ++Idx)
+	{
+		PresentProfileNames[Idx] = FVulkanViewport::GetPresentProfileName(static_cast<EPresentProfile>(Idx));
+	}
+
+	int32_t PresentProfile = static_cast<int32_t>(Viewport->GetPresentProfile());
+	if (ImGui::Combo("Present Profile", &PresentProfile, PresentProfileNames, static_cast<int32_t>(EPresentProfile::Num)))
+	{
+		Viewport->SetPresentProfile(static_cast<EPresentProfile>(PresentProfile));
+	}
+
+	FVulkanLatencyTracker* LatencyTracker = GEngine->GetRenderContext()->GetLatencyTracker();
+	if (LatencyTracker->IsEnabled())
+	{
+		for (uint32_t Idx = 0; Idx < static_cast<uint32_t>(EPresentProfile::Num); ++Idx)
+		{
+			FLatencyStats LatencyStats = LatencyTracker->GetStats(static_cast<EPresentProfile>(Idx));
+			if (LatencyStats.NumSamples > 0)
+			{
+				ImGui::Text("Latency (%s): %.2f ms input to submit, %.2f ms submit to present", PresentProfileNames[Idx], LatencyStats.AverageInputToSubmitMs, LatencyStats.AverageSubmitToPresentMs);
+			}
+		}
+	}
+
 	ImGui::Text("Point Light");
 
 	ImGui::InputFloat3("Point Position", &PointLightPosition[0]);
@@ -164,6 +202,26 @@ void FMainWidget::Draw()
 	ImGui::End();
 }
 
+// Run once with --pipeline-cache-cold and once without to compare startup pipeline creation cold and warm.
+static void PrintCacheStats(FVulkanContext* InContext)
+{
+	FPipelineCacheStats PipelineCacheStats = InContext->GetPipelineCache()->GetStats();
+	FPipelineLibraryStats PipelineLibraryStats = InContext->GetPipelineLibrary()->GetStats();
+	FShaderCacheStats ShaderCacheStats = InContext->GetShaderCache()->GetStats();
+	FSamplerCacheStats SamplerCacheStats = InContext->GetSamplerCache()->GetStats();
+
+	std::cout << "Caches" << std::endl;
+	std::cout << "  Pipeline cache (" << (PipelineCacheStats.bWarm ? "warm, " + std::to_string(PipelineCacheStats.LoadedBytes) + " bytes loaded" : "cold") << "): "
+		<< PipelineCacheStats.NumPipelines << " pipelines created in " << PipelineCacheStats.CreateMs << " ms" << std::endl;
+	std::cout << "  Pipeline library: " << PipelineLibraryStats.NumPipelines << " graphics pipelines, "
+		<< PipelineLibraryStats.NumHits << " hits, " << PipelineLibraryStats.NumMisses << " misses, "
+		<< PipelineLibraryStats.NumPending << " still compiling" << std::endl;
+	std::cout << "  Shader cache: " << ShaderCacheStats.NumModules << " modules, "
+		<< ShaderCacheStats.NumHits << " hits, " << ShaderCacheStats.NumMisses << " misses" << std::endl;
+	std::cout << "  Sampler cache: " << SamplerCacheStats.NumSamplers << " samplers, "
+		<< SamplerCacheStats.NumHits << " hits, " << SamplerCacheStats.NumMisses << " misses" << std::endl;
+}
+
 void Run(int argc, char** argv)
 {
 	srand(static_cast<unsigned int>(time(NULL)));
@@ -178,23 +236,120 @@ void Run(int argc, char** argv)
 	GConfig->Set("WindowWidth", 800);
 	GConfig->Set("WindowHeight", 600);
 	GConfig->Set("TargetFPS", 60.0f);
+	GConfig->Set("FramePacing", "sleep");
+	GConfig->Set("FrameSpinMicroseconds", 2000);
+	GConfig->Set("FrameStatsWindow", 240);
 	GConfig->Set("MaxConcurrentFrames", 2);
+	GConfig->Set("DescriptorPoolSets", 256);
+	GConfig->Set("PipelineCachePath", "pipeline_cache.bin");
+	GConfig->Set("PipelineCacheCold", false);
+	GConfig->Set("PipelineCompileThreads", 2);
 	GConfig->Set("MouseSensitivity", 0.5f);
 	GConfig->Set("CameraMoveSpeed", 1.0f);
+	GConfig->Set("LateLatchCamera", true);
+	GConfig->Set("LateLatchGuardBand", 5.0f);
+	GConfig->Set("LatencyMode", false);
+	GConfig->Set("LatencyStatsWindow", 240);
+	GConfig->Set("PresentProfile", "smooth");
 	GConfig->Set("ShaderDirectory", ProjectDirectory + "shaders/");
+	GConfig->Set("ShaderDebugInfo", true);
+	GConfig->Set("ShaderCompileThreads", 0);
 	GConfig->Set("ImageDirectory", SolutionDirectory + "resources/images/");
 	GConfig->Set("MeshDirectory", SolutionDirectory + "resources/meshes/");
+	GConfig->Set("Headless", false);
+	GConfig->Set("HeadlessFrameCount", 1000);
+	GConfig->Set("OffscreenImageCount", 3);
+	GConfig->Set("ShadowMapSize", 2048);
+	GConfig->Set("GpuCulling", true);
+	GConfig->Set("CaptureDirectory", "");
+	GConfig->Set("CaptureFormat", "png");
+	GConfig->Set("CaptureQueueLimit", 8);
+	GConfig->Set("GpuProfilerEnabled", true);
+	GConfig->Set("GpuProfilerMaxScopes", 64);
+	GConfig->Set("GpuProfilerHistory", 240);
+	GConfig->Set("GpuProfileExportPath", "gpu_profile.json");
+	GConfig->Set("GpuProfileExportOnExit", false);
+	GConfig->Set("CpuProfileExportPath", "cpu_trace.json");
+	GConfig->Set("CpuProfileExportOnExit", false);
+	GConfig->Set("PrintStats", false);
+
+	for (int Idx = 1; Idx < argc; ++Idx)
+	{
+		std::string Arg = argv[Idx];
+		if (Arg == "--headless")
+		{
+			GConfig->Set("Headless", true);
+		}
+		else if (Arg == "--frames" && Idx + 1 < argc)
+		{
+			GConfig->Set("HeadlessFrameCount", atoi(argv[++Idx]));
+		}
+		else if (Arg == "--capture" && Idx + 1 < argc)
+		{
+			GConfig->Set("CaptureDirectory", argv[++Idx]);
+		}
+		else if (Arg == "--capture-format" && Idx + 1 < argc)
+		{
+			GConfig->Set("CaptureFormat", argv[++Idx]);
+		}
+		else if (Arg == "--gpu-profile" && Idx + 1 < argc)
+		{
+			GConfig->Set("GpuProfileExportPath", argv[++Idx]);
+			GConfig->Set("GpuProfileExportOnExit", true);
+		}
+		else if (Arg == "--latency")
+		{
+			GConfig->Set("LatencyMode", true);
+		}
+		else if (Arg == "--present-profile" && Idx + 1 < argc)
+		{
+			GConfig->Set("PresentProfile", argv[++Idx]);
+		}
+		else if (Arg == "--cpu-culling")
+		{
+			GConfig->Set("GpuCulling", false);
+		}
+		else if (Arg == "--no-late-latch")
+		{
+			GConfig->Set("LateLatchCamera", false);
+		}
+		else if (Arg == "--pipeline-cache-cold")
+		{
+			GConfig->Set("PipelineCacheCold", true);
+		}
+		else if (Arg == "--pipeline-threads" && Idx + 1 < argc)
+		{
+			GConfig->Set("PipelineCompileThreads", atoi(argv[++Idx]));
+		}
+		else if (Arg == "--shader-release")
+		{
+			GConfig->Set("ShaderDebugInfo", false);
+		}
+		else if (Arg == "--stats")
+		{
+			GConfig->Set("PrintStats", true);
+		}
+		else if (Arg == "--cpu-profile" && Idx + 1 < argc)
+		{
+			GConfig->Set("CpuProfileExportPath", argv[++Idx]);
+			GConfig->Set("CpuProfileExportOnExit", true);
+		}
+	}
 
 	FEngine::Init();
 
-	GLFWwindow* Window = GEngine->GetWindow();
-
 	FVulkanContext* RenderContext = GEngine->GetRenderContext();
 	FVulkanUIRenderer* UIRenderer = RenderContext->GetUIRenderer();
 
 	std::shared_ptr<FWidget> MainWidget = std::make_shared<FMainWidget>();
 	UIRenderer->AddWidget(MainWidget);
 
+	std::shared_ptr<FWidget> GpuProfilerWidget = std::make_shared<FGpuProfilerWidget>(RenderContext->GetGpuProfiler());
+	UIRenderer->AddWidget(GpuProfilerWidget);
+
+	std::shared_ptr<FWidget> CpuProfilerWidget = std::make_shared<FCpuProfilerWidget>();
+	UIRenderer->AddWidget(CpuProfilerWidget);
+
 	std::string MeshDirectory;
 	GConfig->Get("MeshDirectory", MeshDirectory);
 
@@ -394,40 +549,86 @@ void Run(int argc, char** argv)
 	ASkyActor* SkyActor = World->GetSky();
 	SkyActor->SetMesh(SkyMesh);
 
-	float TargetFPS;
-	GConfig->Get("TargetFPS", TargetFPS);
+	GEngine->Run();
 
-	clock_t PreviousFrameTime = clock();
-	float MaxFrameTime = 1000.0f / TargetFPS;
-
-	float TotalFrameTime = 0.0f;
-	int TotalFrameCount = 0;
+	RenderContext->WaitIdle();
 
-	while (!glfwWindowShouldClose(Window))
+	FVulkanReadback* Readback = RenderContext->GetReadback();
+	if (Readback->IsEnabled())
 	{
-		clock_t CurrentFrameTime = clock();
-		float DeltaTime = static_cast<float>(CurrentFrameTime - PreviousFrameTime) / CLOCKS_PER_SEC;
+		Readback->Poll();
+		std::cout << "Captured " << Readback->GetNumCaptured() << " frames, dropped " << Readback->GetNumDropped() << std::endl;
+	}
 
-		glfwPollEvents();
+	bool bPrintStats = false;
+	GConfig->Get("PrintStats", bPrintStats);
 
-		GEngine->Tick(DeltaTime);
+	bool bHeadless = false;
+	GConfig->Get("Headless", bHeadless);
 
-		PreviousFrameTime = CurrentFrameTime;
+	if (bPrintStats || bHeadless)
+	{
+		PrintCacheStats(RenderContext);
+	}
 
-		TotalFrameTime += DeltaTime;
-		++TotalFrameCount;
+	FVulkanLatencyTracker* LatencyTracker = RenderContext->GetLatencyTracker();
+	if (LatencyTracker->IsEnabled())
+	{
+		for (uint32_t Idx = 0; Idx < static_cast<uint32_t>(EPresentProfile::Num); ++Idx)
+		{
+			const EPresentProfile PresentProfile = static_cast<EPresentProfile>(Idx);
+
+			FLatencyStats Stats = LatencyTracker->GetStats(PresentProfile);
+			if (Stats.NumSamples == 0)
+			{
+				continue;
+			}
+
+			std::cout << "Latency (" << FVulkanViewport::GetPresentProfileName(PresentProfile) << "), " << Stats.NumSamples << " frames" << std::endl;
+			std::cout << "  Input to submit: " << Stats.AverageInputToSubmitMs << " ms avg, " << Stats.P99InputToSubmitMs << " ms p99, " << Stats.MaxInputToSubmitMs << " ms max" << std::endl;
+			std::cout << "  Submit to present: " << Stats.AverageSubmitToPresentMs << " ms avg, " << Stats.P99SubmitToPresentMs << " ms p99, " << Stats.MaxSubmitToPresentMs << " ms max" << std::endl;
+		}
+	}
 
-		if (TotalFrameTime >= 5.0f)
+	bool bGpuProfileExportOnExit = false;
+	GConfig->Get("GpuProfileExportOnExit", bGpuProfileExportOnExit);
+	if (bGpuProfileExportOnExit)
+	{
+		std::string GpuProfileExportPath;
+		GConfig->Get("GpuProfileExportPath", GpuProfileExportPath);
+		if (RenderContext->GetGpuProfiler()->ExportJSON(GpuProfileExportPath) == false)
 		{
-			std::cout << "Average Frame: " << TotalFrameCount / TotalFrameTime << std::endl;
-			TotalFrameTime = 0.0f;
-			TotalFrameCount = 0;
+			std::cerr << "Failed to write " << GpuProfileExportPath << std::endl;
 		}
+	}
 
-		std::this_thread::sleep_for(std::chrono::milliseconds((int)(MaxFrameTime)));
+	bool bCpuProfileExportOnExit = false;
+	GConfig->Get("CpuProfileExportOnExit", bCpuProfileExportOnExit);
+	if (bCpuProfileExportOnExit)
+	{
+		std::string CpuProfileExportPath;
+		GConfig->Get("CpuProfileExportPath", CpuProfileExportPath);
+		if (CpuProfiler::ExportChromeTrace(CpuProfileExportPath) == false)
+		{
+			std::cerr << "Failed to write " << CpuProfileExportPath << std::endl;
+		}
 	}
 
-	RenderContext->WaitIdle();
+	const uint64_t FrameNumber = GEngine->GetFrameCount();
+	if (VkNull::IsEnabled() && FrameNumber > 0)
+	{
+		FVulkanNullStats Stats = VkNull::GetStats();
+		std::cout << "Null backend, " << FrameNumber << " frames" << std::endl;
+		std::cout << "  Direct draws/frame: " << Stats.NumDraws / FrameNumber << std::endl;
+		std::cout << "  Indirect draw slots/frame: " << Stats.NumIndirectDrawSlots / FrameNumber << " (" << Stats.NumIndirectDraws / FrameNumber << " commands)" << std::endl;
+		std::cout << "  Dispatches/frame: " << Stats.NumDispatches / FrameNumber << std::endl;
+		std::cout << "  Pipeline binds/frame: " << Stats.NumPipelineBinds / FrameNumber << std::endl;
+		std::cout << "  Descriptor set binds/frame: " << Stats.NumDescriptorSetBinds / FrameNumber << std::endl;
+		std::cout << "  Copies/frame: " << Stats.NumCopies / FrameNumber << std::endl;
+		std::cout << "  Submits: " << Stats.NumSubmits << std::endl;
+		std::cout << "  Memory: " << Stats.AllocatedBytes << " bytes in " << Stats.NumAllocations << " allocations (peak " << Stats.PeakAllocatedBytes << ")" << std::endl;
+		std::cout << "  Live objects: " << Stats.NumLiveObjects << std::endl;
+	}
 
 	FEngine::Exit();
 	FConfig::Shutdown();
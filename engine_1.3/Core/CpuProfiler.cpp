@@ -0,0 +1,341 @@
+#include "CpuProfiler.h"
+#include "Config.h"
+
+#include "imgui/imgui.h"
+
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <fstream>
+#include <iomanip>
+#include <algorithm>
+
+static const uint64_t CpuProfilerEventsPerThread = 1 << 16;
+static const uint64_t CpuProfilerFrameHistory = 256;
+
+struct FCpuProfilerThreadBuffer
+{
+	std::vector<FCpuProfileEvent> Events;
+	std::atomic<uint64_t> NumWritten{ 0 };
+	uint32_t Depth = 0;
+	uint32_t ThreadId = 0;
+	std::string ThreadName;
+};
+
+static std::mutex GCpuProfilerMutex;
+static std::vector<std::unique_ptr<FCpuProfilerThreadBuffer>> GCpuProfilerThreads;
+static thread_local FCpuProfilerThreadBuffer* GCpuProfilerThreadBuffer = nullptr;
+
+static uint64_t GCpuProfilerFrameStarts[CpuProfilerFrameHistory];
+static uint64_t GCpuProfilerNumFrames = 0;
+
+static FCpuProfilerThreadBuffer* GetThreadBuffer()
+{
+	if (GCpuProfilerThreadBuffer == nullptr)
+	{
+		// Buffers outlive their threads so late readers and the export still see what they recorded.
+		std::unique_ptr<FCpuProfilerThreadBuffer> Buffer = std::make_unique<FCpuProfilerThreadBuffer>();
+		Buffer->Events.resize(CpuProfilerEventsPerThread);
+
+		std::lock_guard<std::mutex> Lock(GCpuProfilerMutex);
+		Buffer->ThreadId = static_cast<uint32_t>(GCpuProfilerThreads.size());
+		Buffer->ThreadName = "Thread " + std::to_string(Buffer->ThreadId);
+
+		GCpuProfilerThreadBuffer = Buffer.get();
+		GCpuProfilerThreads.push_back(std::move(Buffer));
+	}
+
+	return GCpuProfilerThreadBuffer;
+}
+
+static void WriteEscaped(std::ostream& InStream, const std::string& InString)
+{
+	for (char Char : InString)
+	{
+		if (Char == '"' || Char == '\\')
+		{
+			InStream << '\\';
+		}
+		InStream << Char;
+	}
+}
+
+namespace CpuProfiler
+{
+	uint64_t Now()
+	{
+		return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count());
+	}
+
+	uint32_t BeginScope()
+	{
+		return GetThreadBuffer()->Depth++;
+	}
+
+	void EndScope(const char* InName, uint64_t InStart, uint32_t InDepth)
+	{
+		const uint64_t End = Now();
+
+		FCpuProfilerThreadBuffer* Buffer = GetThreadBuffer();
+		--Buffer->Depth;
+
+		// Only this thread writes the ring, so a relaxed load is enough; the release store publishes the event.
+		const uint64_t Index = Buffer->NumWritten.load(std::memory_order_relaxed);
+
+		FCpuProfileEvent& Event = Buffer->Events[Index % CpuProfilerEventsPerThread];
+		Event.Name = InName;
+		Event.Start = InStart;
+		Event.End = End;
+		Event.Depth = InDepth;
+
+		Buffer->NumWritten.store(Index + 1, std::memory_order_release);
+	}
+
+	void SetThreadName(const char* InName)
+	{
+		FCpuProfilerThreadBuffer* Buffer = GetThreadBuffer();
+
+		std::lock_guard<std::mutex> Lock(GCpuProfilerMutex);
+		Buffer->ThreadName = InName;
+	}
+
+	void MarkFrame()
+	{
+		GCpuProfilerFrameStarts[GCpuProfilerNumFrames % CpuProfilerFrameHistory] = Now();
+		++GCpuProfilerNumFrames;
+	}
+
+	bool GetLastFrame(uint64_t& OutStart, uint64_t& OutEnd)
+	{
+		if (GCpuProfilerNumFrames < 2)
+		{
+			return false;
+		}
+
+		OutStart = GCpuProfilerFrameStarts[(GCpuProfilerNumFrames - 2) % CpuProfilerFrameHistory];
+		OutEnd = GCpuProfilerFrameStarts[(GCpuProfilerNumFrames - 1) % CpuProfilerFrameHistory];
+		return true;
+	}
+
+	void GetEvents(std::vector<FCpuProfileThread>& OutThreads, uint64_t InSince)
+	{
+		std::lock_guard<std::mutex> Lock(GCpuProfilerMutex);
+
+		OutThreads.resize(GCpuProfilerThreads.size());
+
+		for (size_t ThreadIdx = 0; ThreadIdx < GCpuProfilerThreads.size(); ++ThreadIdx)
+		{
+			const FCpuProfilerThreadBuffer& Buffer = *GCpuProfilerThreads[ThreadIdx];
+
+			FCpuProfileThread& Thread = OutThreads[ThreadIdx];
+			Thread.ThreadId = Buffer.ThreadId;
+			Thread.ThreadName = Buffer.ThreadName;
+			Thread.Events.clear();
+
+			const uint64_t NumWritten = Buffer.NumWritten.load(std::memory_order_acquire);
+			const uint64_t First = NumWritten > CpuProfilerEventsPerThread ? NumWritten - CpuProfilerEventsPerThread : 0;
+
+			// Events are stored in the order they ended, so walk back from the newest until they get too old.
+			uint64_t Index = NumWritten;
+			while (Index > First)
+			{
+				const FCpuProfileEvent& Event = Buffer.Events[(Index - 1) % CpuProfilerEventsPerThread];
+				if (Event.End < InSince)
+				{
+					break;
+				}
+				--Index;
+			}
+			Thread.Events.assign(NumWritten - Index, FCpuProfileEvent());
+			for (uint64_t Idx = Index; Idx < NumWritten; ++Idx)
+			{
+				Thread.Events[Idx - Index] = Buffer.Events[Idx % CpuProfilerEventsPerThread];
+			}
+
+			// The owning thread kept recording while we copied; drop anything it may have overwritten meanwhile.
+			// Event NumWrittenAfter may be half written right now, and it shares its slot with the oldest event
+			// still counted in the ring, so that one is dropped as well.
+			const uint64_t NumWrittenAfter = Buffer.NumWritten.load(std::memory_order_acquire);
+			if (NumWrittenAfter >= CpuProfilerEventsPerThread)
+			{
+				const uint64_t FirstValid = NumWrittenAfter - CpuProfilerEventsPerThread + 1;
+				if (FirstValid > Index)
+				{
+					const size_t NumOverwritten = static_cast<size_t>(std::min(FirstValid - Index, NumWritten - Index));
+					Thread.Events.erase(Thread.Events.begin(), Thread.Events.begin() + NumOverwritten);
+				}
+			}
+		}
+	}
+
+	bool ExportChromeTrace(const std::string& InFilename)
+	{
+		std::vector<FCpuProfileThread> Threads;
+		GetEvents(Threads);
+
+		uint64_t Origin = UINT64_MAX;
+		for (const FCpuProfileThread& Thread : Threads)
+		{
+			for (const FCpuProfileEvent& Event : Thread.Events)
+			{
+				Origin = std::min(Origin, Event.Start);
+			}
+		}
+
+		std::ofstream File(InFilename, std::ios::trunc);
+		if (File.is_open() == false)
+		{
+			return false;
+		}
+
+		File << std::fixed << std::setprecision(3);
+		File << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+		bool bFirst = true;
+		for (const FCpuProfileThread& Thread : Threads)
+		{
+			File << (bFirst ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << Thread.ThreadId << ",\"args\":{\"name\":\"";
+			WriteEscaped(File, Thread.ThreadName);
+			File << "\"}}";
+			bFirst = false;
+
+			for (const FCpuProfileEvent& Event : Thread.Events)
+			{
+				File << ",\n{\"name\":\"";
+				WriteEscaped(File, Event.Name);
+				File << "\",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":1,\"tid\":" << Thread.ThreadId
+					<< ",\"ts\":" << static_cast<double>(Event.Start - Origin) / 1000.0
+					<< ",\"dur\":" << static_cast<double>(Event.End - Event.Start) / 1000.0 << "}";
+			}
+		}
+
+		File << "\n]}\n";
+
+		return File.good();
+	}
+}
+
+FCpuProfilerWidget::FCpuProfilerWidget()
+	: bInitialized(false)
+	, bPaused(false)
+	, FrameStart(0)
+	, FrameEnd(0)
+{
+}
+
+void FCpuProfilerWidget::Draw()
+{
+	ImGui::Begin("CPU Profiler");
+
+	if (bInitialized == false)
+	{
+		ImGui::SetWindowPos(ImVec2(20, 340));
+		ImGui::SetWindowSize(ImVec2(740, 240));
+		bInitialized = true;
+	}
+
+	if (CpuProfiler::IsEnabled() == false)
+	{
+		ImGui::Text("The CPU profiler is compiled out (ENABLE_CPU_PROFILER=0).");
+		ImGui::End();
+		return;
+	}
+
+	ImGui::Checkbox("Pause", &bPaused);
+	ImGui::SameLine();
+	if (ImGui::Button("Export Trace"))
+	{
+		std::string ExportPath = "cpu_trace.json";
+		GConfig->Get("CpuProfileExportPath", ExportPath);
+
+		ExportStatus = CpuProfiler::ExportChromeTrace(ExportPath) ? "Wrote " + ExportPath : "Failed to write " + ExportPath;
+	}
+
+	if (ExportStatus.empty() == false)
+	{
+		ImGui::SameLine();
+		ImGui::TextUnformatted(ExportStatus.c_str());
+	}
+
+	if (bPaused == false && CpuProfiler::GetLastFrame(FrameStart, FrameEnd))
+	{
+		CpuProfiler::GetEvents(Threads, FrameStart);
+	}
+
+	if (FrameEnd <= FrameStart)
+	{
+		ImGui::Text("Waiting for a complete frame...");
+		ImGui::End();
+		return;
+	}
+
+	const double FrameMs = static_cast<double>(FrameEnd - FrameStart) / 1000000.0;
+	ImGui::Text("Frame: %.3f ms", FrameMs);
+
+	const float RowHeight = ImGui::GetTextLineHeightWithSpacing();
+	const float Width = ImGui::GetContentRegionAvail().x;
+	const double Scale = Width / static_cast<double>(FrameEnd - FrameStart);
+
+	ImDrawList* DrawList = ImGui::GetWindowDrawList();
+
+	for (const FCpuProfileThread& Thread : Threads)
+	{
+		uint32_t MaxDepth = 0;
+		bool bHasEvents = false;
+		for (const FCpuProfileEvent& Event : Thread.Events)
+		{
+			if (Event.End >= FrameStart && Event.Start <= FrameEnd)
+			{
+				MaxDepth = std::max(MaxDepth, Event.Depth);
+				bHasEvents = true;
+			}
+		}
+
+		if (bHasEvents == false)
+		{
+			continue;
+		}
+
+		ImGui::TextUnformatted(Thread.ThreadName.c_str());
+
+		const ImVec2 Origin = ImGui::GetCursorScreenPos();
+
+		for (const FCpuProfileEvent& Event : Thread.Events)
+		{
+			if (Event.End < FrameStart || Event.Start > FrameEnd)
+			{
+				continue;
+			}
+
+			const uint64_t Start = std::max(Event.Start, FrameStart);
+			const uint64_t End = std::min(Event.End, FrameEnd);
+
+			const ImVec2 Min(Origin.x + static_cast<float>((Start - FrameStart) * Scale), Origin.y + Event.Depth * RowHeight);
+			const ImVec2 Max(std::max(Min.x + 1.0f, Origin.x + static_cast<float>((End - FrameStart) * Scale)), Min.y + RowHeight - 1.0f);
+
+			// Hash the name pointer so a scope keeps its color from frame to frame.
+			const size_t Hash = std::hash<const void*>()(Event.Name);
+			const ImU32 Color = ImGui::GetColorU32(ImVec4(
+				0.35f + 0.1f * (Hash % 5),
+				0.35f + 0.1f * ((Hash / 5) % 5),
+				0.35f + 0.1f * ((Hash / 25) % 5),
+				1.0f));
+
+			DrawList->AddRectFilled(Min, Max, Color);
+			DrawList->PushClipRect(Min, Max, true);
+			DrawList->AddText(ImVec2(Min.x + 2.0f, Min.y), IM_COL32_BLACK, Event.Name);
+			DrawList->PopClipRect();
+
+			if (ImGui::IsMouseHoveringRect(Min, Max))
+			{
+				ImGui::SetTooltip("%s\n%.3f ms", Event.Name, static_cast<double>(Event.End - Event.Start) / 1000000.0);
+			}
+		}
+
+		ImGui::Dummy(ImVec2(Width, (MaxDepth + 1) * RowHeight));
+	}
+
+	ImGui::End();
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "Widget.h"
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// Building with ENABLE_CPU_PROFILER=0 turns every macro below into nothing.
+#ifndef ENABLE_CPU_PROFILER
+#define ENABLE_CPU_PROFILER 1
+#endif
+
+struct FCpuProfileEvent
+{
+	// Must point at storage that outlives the profiler; string literals are expected.
+	const char* Name = nullptr;
+	uint64_t Start = 0;
+	uint64_t End = 0;
+	uint32_t Depth = 0;
+};
+
+struct FCpuProfileThread
+{
+	uint32_t ThreadId = 0;
+	std::string ThreadName;
+	std::vector<FCpuProfileEvent> Events;
+};
+
+// Each thread appends finished scopes to its own fixed-size ring buffer, so recording takes no locks and
+// never allocates once a thread's buffer exists. Timestamps come from std::chrono::steady_clock and are
+// stored in nanoseconds.
+namespace CpuProfiler
+{
+	constexpr bool IsEnabled()
+	{
+		return ENABLE_CPU_PROFILER != 0;
+	}
+
+	uint64_t Now();
+
+	uint32_t BeginScope();
+	void EndScope(const char* InName, uint64_t InStart, uint32_t InDepth);
+
+	void SetThreadName(const char* InName);
+
+	// Called once per frame on the game thread; the flame view shows the last complete frame.
+	void MarkFrame();
+	bool GetLastFrame(uint64_t& OutStart, uint64_t& OutEnd);
+
+	// Copies the events still in every thread's ring that ended at or after InSince. Safe to call while
+	// other threads keep recording.
+	void GetEvents(std::vector<FCpuProfileThread>& OutThreads, uint64_t InSince = 0);
+
+	// Writes the Trace Event Format read by chrome://tracing and ui.perfetto.dev.
+	bool ExportChromeTrace(const std::string& InFilename);
+}
+
+class FCpuProfileScope
+{
+public:
+	FCpuProfileScope(const char* InName)
+		: Name(InName)
+		, Depth(CpuProfiler::BeginScope())
+		, Start(CpuProfiler::Now())
+	{
+	}
+
+	~FCpuProfileScope()
+	{
+		CpuProfiler::EndScope(Name, Start, Depth);
+	}
+
+private:
+	const char* Name;
+	uint32_t Depth;
+	uint64_t Start;
+};
+
+#if ENABLE_CPU_PROFILER
+#define CPU_PROFILE_CONCAT_INNER(A, B) A##B
+#define CPU_PROFILE_CONCAT(A, B) CPU_PROFILE_CONCAT_INNER(A, B)
+#define CPU_PROFILE_SCOPE(Name) FCpuProfileScope CPU_PROFILE_CONCAT(CpuProfileScope, __LINE__)(Name)
+#define CPU_PROFILE_THREAD(Name) CpuProfiler::SetThreadName(Name)
+#define CPU_PROFILE_FRAME() CpuProfiler::MarkFrame()
+#else
+#define CPU_PROFILE_SCOPE(Name)
+#define CPU_PROFILE_THREAD(Name)
+#define CPU_PROFILE_FRAME()
+#endif
+
+class FCpuProfilerWidget : public FWidget
+{
+public:
+	FCpuProfilerWidget();
+	virtual ~FCpuProfilerWidget() { }
+
+	virtual void Draw() override;
+
+private:
+	bool bInitialized;
+	bool bPaused;
+
+	std::vector<FCpuProfileThread> Threads;
+	uint64_t FrameStart;
+	uint64_t FrameEnd;
+
+	std::string ExportStatus;
+};
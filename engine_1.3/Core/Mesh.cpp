@@ -1,5 +1,6 @@
 #include "Mesh.h"
 #include "Engine.h"
+#include "CpuProfiler.h"
 
 #include "VulkanContext.h"
 #include "VulkanMesh.h"
@@ -54,6 +55,8 @@ static aiMesh* FindFirstMesh(const aiScene* InScene, const aiNode* InNode)
 
 bool UMesh::Load(const std::string& InFilename)
 {
+	CPU_PROFILE_SCOPE("UMesh::Load");
+
 	Assimp::Importer Importer;
 	const aiScene* Scene = Importer.ReadFile(InFilename, aiProcess_Triangulate | aiProcess_FlipUVs);
 	if (Scene == nullptr)
@@ -141,6 +144,8 @@ bool UMesh::Load(const std::string& InFilename)
 		}
 	}
 
+	ComputeBounds();
+
 	CreateRenderMesh();
 
 	return true;
@@ -150,11 +155,42 @@ void UMesh::Unload()
 {
 	Vertices.clear();
 	Indices.clear();
+	Bounds = FMeshBounds();
 	Material = nullptr;
 
 	DestroyRenderMesh();
 }
 
+void UMesh::ComputeBounds()
+{
+	Bounds = FMeshBounds();
+
+	if (Vertices.empty())
+	{
+		return;
+	}
+
+	Bounds.Min = Vertices[0].Position;
+	Bounds.Max = Vertices[0].Position;
+
+	for (const FVertex& Vertex : Vertices)
+	{
+		Bounds.Min = glm::min(Bounds.Min, Vertex.Position);
+		Bounds.Max = glm::max(Bounds.Max, Vertex.Position);
+	}
+
+	Bounds.Center = (Bounds.Min + Bounds.Max) * 0.5f;
+
+	float MaxDistanceSq = 0.0f;
+	for (const FVertex& Vertex : Vertices)
+	{
+		glm::vec3 Delta = Vertex.Position - Bounds.Center;
+		MaxDistanceSq = glm::max(MaxDistanceSq, glm::dot(Delta, Delta));
+	}
+
+	Bounds.Radius = glm::sqrt(MaxDistanceSq);
+}
+
 void UMesh::SetMaterial(UMaterial* InMaterial)
 {
 	Material = InMaterial;
@@ -6,6 +6,14 @@
 
 #include <string>
 
+struct FMeshBounds
+{
+	glm::vec3 Min = glm::vec3(0.0f);
+	glm::vec3 Max = glm::vec3(0.0f);
+	glm::vec3 Center = glm::vec3(0.0f);
+	float Radius = 0.0f;
+};
+
 class UMesh : public UAsset
 {
 public:
@@ -16,10 +24,13 @@ public:
 
 	const std::vector<FVertex>& GetVertices() const { return Vertices; }
 	const std::vector<uint32_t>& GetIndices() const { return Indices; }
+	const FMeshBounds& GetBounds() const { return Bounds; }
 
 	virtual bool Load(const std::string& InFilename);
 	void Unload();
 
+	void ComputeBounds();
+
 	UMaterial* GetMaterial() const { return Material; }
 	void SetMaterial(UMaterial* InMaterial);
 
@@ -31,6 +42,8 @@ protected:
 	std::vector<FVertex> Vertices;
 	std::vector<uint32_t> Indices;
 
+	FMeshBounds Bounds;
+
 	UMaterial* Material;
 
 	class FVulkanMesh* RenderMesh;
@@ -0,0 +1,227 @@
+#include "ShaderCompiler.h"
+#include "Config.h"
+#include "Utils.h"
+#include "CpuProfiler.h"
+
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+#include <filesystem>
+
+static const char* ShaderManifestName = "spirv_cache.manifest";
+
+static const std::vector<std::string> ShaderExtensions = { ".vert", ".frag", ".geom", ".comp" };
+
+// FNV-1a, which unlike std::hash is the same on every run and platform, so the manifest stays valid.
+static uint64_t HashBytes(const char* InData, size_t InSize, uint64_t InSeed)
+{
+	uint64_t Hash = InSeed;
+	for (size_t Idx = 0; Idx < InSize; ++Idx)
+	{
+		Hash ^= static_cast<uint8_t>(InData[Idx]);
+		Hash *= 1099511628211ULL;
+	}
+
+	return Hash;
+}
+
+static const uint64_t HashSeed = 14695981039346656037ULL;
+
+FShaderCompiler::FShaderCompiler(const std::string& InDirectory)
+	: Directory(InDirectory)
+	, bDebugInfo(true)
+	, NumThreads(0)
+{
+	ManifestPath = (std::filesystem::path(Directory) / ShaderManifestName).string();
+
+	GConfig->Get("ShaderDebugInfo", bDebugInfo);
+
+	int32_t ConfigThreads = 0;
+	GConfig->Get("ShaderCompileThreads", ConfigThreads);
+	NumThreads = ConfigThreads > 0 ? static_cast<uint32_t>(ConfigThreads) : std::max(std::thread::hardware_concurrency(), 1U);
+}
+
+std::string FShaderCompiler::GetOptions() const
+{
+	// -g0 strips names and other debug instructions as well, for the smallest modules.
+	return bDebugInfo ? "-g -V" : "-g0 -V";
+}
+
+uint64_t FShaderCompiler::GetSourceHash(const std::string& InFilename, std::unordered_set<std::string>& InOutVisited) const
+{
+	const std::string Canonical = std::filesystem::weakly_canonical(InFilename).string();
+	if (InOutVisited.insert(Canonical).second == false)
+	{
+		return 0;
+	}
+
+	std::vector<char> Source;
+	if (ReadFile(InFilename, Source) == false)
+	{
+		// A missing include still has to change the key, otherwise adding it later would go unnoticed.
+		return HashBytes(InFilename.data(), InFilename.size(), HashSeed);
+	}
+
+	uint64_t Hash = HashBytes(Source.data(), Source.size(), HashSeed);
+
+	// Only quoted includes resolve relative to the including file, which is all these shaders use.
+	std::istringstream Lines(std::string(Source.begin(), Source.end()));
+	std::string Line;
+	while (std::getline(Lines, Line))
+	{
+		const size_t Directive = Line.find("#include");
+		const size_t Open = Line.find('"', Directive);
+		const size_t Close = Open == std::string::npos ? std::string::npos : Line.find('"', Open + 1);
+		if (Directive == std::string::npos || Close == std::string::npos)
+		{
+			continue;
+		}
+
+		const std::filesystem::path IncludePath = std::filesystem::path(InFilename).parent_path() / Line.substr(Open + 1, Close - Open - 1);
+		const uint64_t IncludeHash = GetSourceHash(IncludePath.string(), InOutVisited);
+		Hash = HashBytes(reinterpret_cast<const char*>(&IncludeHash), sizeof(IncludeHash), Hash);
+	}
+
+	return Hash;
+}
+
+bool FShaderCompiler::Compile(const std::string& InFilename) const
+{
+	CPU_PROFILE_SCOPE("FShaderCompiler::Compile");
+
+	std::string Command = "glslang " + GetOptions() + " \"";
+	Command += InFilename;
+	Command += "\" -o \"";
+	Command += InFilename + ".spv\"";
+
+	return system(Command.c_str()) == 0;
+}
+
+void FShaderCompiler::LoadManifest()
+{
+	std::ifstream File(ManifestPath);
+	if (File.is_open() == false)
+	{
+		return;
+	}
+
+	uint64_t Hash = 0;
+	std::string Name;
+	while (File >> std::hex >> Hash && std::getline(File >> std::ws, Name))
+	{
+		Manifest[Name] = Hash;
+	}
+}
+
+void FShaderCompiler::SaveManifest() const
+{
+	std::ostringstream Stream;
+	for (const auto& Pair : Manifest)
+	{
+		Stream << std::hex << Pair.second << ' ' << Pair.first << '\n';
+	}
+
+	const std::string Data = Stream.str();
+	if (WriteFile(ManifestPath, Data.data(), Data.size()) == false)
+	{
+		std::cerr << "Failed to write " << ManifestPath << std::endl;
+	}
+}
+
+FShaderCompileStats FShaderCompiler::CompileAll()
+{
+	CPU_PROFILE_SCOPE("FShaderCompiler::CompileAll");
+
+	const auto Start = std::chrono::steady_clock::now();
+
+	FShaderCompileStats Stats;
+
+	LoadManifest();
+
+	const std::string Options = GetOptions();
+
+	struct FCompileJob
+	{
+		std::string Filename;
+		std::string OutputName;
+		uint64_t Hash = 0;
+		bool bSucceeded = false;
+	};
+
+	std::vector<FCompileJob> Jobs;
+	for (const auto& Entry : std::filesystem::directory_iterator(Directory))
+	{
+		const std::string Extension = Entry.path().extension().string();
+		if (std::find(ShaderExtensions.begin(), ShaderExtensions.end(), Extension) == ShaderExtensions.end())
+		{
+			continue;
+		}
+
+		FCompileJob Job;
+		Job.Filename = Entry.path().string();
+		Job.OutputName = Entry.path().filename().string() + ".spv";
+
+		std::unordered_set<std::string> Visited;
+		Job.Hash = HashBytes(Options.data(), Options.size(), GetSourceHash(Job.Filename, Visited));
+
+		auto Iter = Manifest.find(Job.OutputName);
+		if (Iter != Manifest.end() && Iter->second == Job.Hash && std::filesystem::exists(Job.Filename + ".spv"))
+		{
+			++Stats.NumUpToDate;
+			continue;
+		}
+
+		Jobs.push_back(Job);
+	}
+
+	// Each compile is a separate process, so the workers only hand out jobs and wait on them.
+	std::atomic<size_t> NextJob(0);
+	auto Worker = [this, &Jobs, &NextJob]()
+	{
+		for (size_t Idx = NextJob++; Idx < Jobs.size(); Idx = NextJob++)
+		{
+			Jobs[Idx].bSucceeded = Compile(Jobs[Idx].Filename);
+		}
+	};
+
+	std::vector<std::thread> Workers;
+	const size_t NumWorkers = std::min(static_cast<size_t>(NumThreads), Jobs.size());
+	for (size_t Idx = 0; Idx < NumWorkers; ++Idx)
+	{
+		Workers.emplace_back(Worker);
+	}
+
+	for (std::thread& Thread : Workers)
+	{
+		Thread.join();
+	}
+
+	for (const FCompileJob& Job : Jobs)
+	{
+		if (Job.bSucceeded)
+		{
+			Manifest[Job.OutputName] = Job.Hash;
+			++Stats.NumCompiled;
+		}
+		else
+		{
+			// A failed compile may have left a partial output behind, so make sure the next run compiles it again.
+			Manifest.erase(Job.OutputName);
+			std::cerr << "Failed to compile " << Job.Filename << std::endl;
+			++Stats.NumFailed;
+		}
+	}
+
+	if (Jobs.empty() == false)
+	{
+		SaveManifest();
+	}
+
+	Stats.Ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - Start).count();
+
+	return Stats;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+
+struct FShaderCompileStats
+{
+	uint32_t NumCompiled = 0;
+	uint32_t NumUpToDate = 0;
+	uint32_t NumFailed = 0;
+	double Ms = 0.0;
+};
+
+// Compiles the GLSL sources of a directory to SPIR-V next to them. Every source is keyed by a hash of its text,
+// the files it includes and the compile options, kept in a manifest alongside the outputs, so a source is only
+// recompiled when something that affects its SPIR-V changed. Outdated sources compile in parallel.
+class FShaderCompiler
+{
+public:
+	FShaderCompiler(const std::string& InDirectory);
+
+	FShaderCompileStats CompileAll();
+
+protected:
+	std::string GetOptions() const;
+	uint64_t GetSourceHash(const std::string& InFilename, std::unordered_set<std::string>& InOutVisited) const;
+	bool Compile(const std::string& InFilename) const;
+
+	void LoadManifest();
+	void SaveManifest() const;
+
+protected:
+	std::string Directory;
+	std::string ManifestPath;
+
+	bool bDebugInfo;
+	uint32_t NumThreads;
+
+	// Output file name to the source hash it was last compiled from.
+	std::unordered_map<std::string, uint64_t> Manifest;
+};
@@ -1,6 +1,7 @@
 #include "Texture2D.h"
 
 #include "Engine.h"
+#include "CpuProfiler.h"
 
 #include "VulkanContext.h"
 #include "VulkanTexture.h"
@@ -29,6 +30,8 @@ UTexture2D::~UTexture2D()
 
 bool UTexture2D::Load(const std::string& InFilename, bool InbIsNormal)
 {
+	CPU_PROFILE_SCOPE("UTexture2D::Load");
+
 	int OutWidth, OutHeight, OutNumChannels;
 
 	stbi_set_flip_vertically_on_load(true);
@@ -1,6 +1,7 @@
 #include "TextureCube.h"
 
 #include "Engine.h"
+#include "CpuProfiler.h"
 
 #include "VulkanContext.h"
 #include "VulkanTexture.h"
@@ -24,6 +25,8 @@ UTextureCube::~UTextureCube()
 
 bool UTextureCube::Load(const std::vector<std::string>& InFilenames)
 {
+	CPU_PROFILE_SCOPE("UTextureCube::Load");
+
 	if (InFilenames.size() != 6)
 	{
 		return false;
@@ -2,6 +2,8 @@
 
 #include <iostream>
 #include <fstream>
+#include <algorithm>
+#include <array>
 
 bool ReadFile(const std::string& InFilename, std::vector<char>& OutBytes)
 {
@@ -22,3 +24,125 @@ bool ReadFile(const std::string& InFilename, std::vector<char>& OutBytes)
 	return true;
 }
 
+
+bool WriteFile(const std::string& InFilename, const void* InData, size_t InSize)
+{
+	std::ofstream File(InFilename, std::ios::binary | std::ios::trunc);
+	if (File.is_open() == false)
+	{
+		return false;
+	}
+
+	File.write(static_cast<const char*>(InData), InSize);
+
+	return File.good();
+}
+
+static uint32_t UpdateCrc32(uint32_t InCrc, const uint8_t* InData, size_t InSize)
+{
+	static const std::array<uint32_t, 256> Table = []()
+	{
+		std::array<uint32_t, 256> Result;
+		for (uint32_t Idx = 0; Idx < 256; ++Idx)
+		{
+			uint32_t Value = Idx;
+			for (int Bit = 0; Bit < 8; ++Bit)
+			{
+				Value = (Value & 1) ? 0xEDB88320u ^ (Value >> 1) : Value >> 1;
+			}
+			Result[Idx] = Value;
+		}
+		return Result;
+	}();
+
+	uint32_t Crc = InCrc ^ 0xFFFFFFFFu;
+	for (size_t Idx = 0; Idx < InSize; ++Idx)
+	{
+		Crc = Table[(Crc ^ InData[Idx]) & 0xFF] ^ (Crc >> 8);
+	}
+	return Crc ^ 0xFFFFFFFFu;
+}
+
+static void AppendBigEndian(std::vector<uint8_t>& OutBytes, uint32_t InValue)
+{
+	OutBytes.push_back(static_cast<uint8_t>(InValue >> 24));
+	OutBytes.push_back(static_cast<uint8_t>(InValue >> 16));
+	OutBytes.push_back(static_cast<uint8_t>(InValue >> 8));
+	OutBytes.push_back(static_cast<uint8_t>(InValue));
+}
+
+static void AppendChunk(std::vector<uint8_t>& OutBytes, const char* InType, const std::vector<uint8_t>& InData)
+{
+	AppendBigEndian(OutBytes, static_cast<uint32_t>(InData.size()));
+
+	const size_t TypeOffset = OutBytes.size();
+	OutBytes.insert(OutBytes.end(), InType, InType + 4);
+	OutBytes.insert(OutBytes.end(), InData.begin(), InData.end());
+
+	AppendBigEndian(OutBytes, UpdateCrc32(0, OutBytes.data() + TypeOffset, OutBytes.size() - TypeOffset));
+}
+
+bool WritePNG(const std::string& InFilename, uint32_t InWidth, uint32_t InHeight, const uint8_t* InRGBA)
+{
+	static const uint8_t Signature[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	static const size_t MaxStoredBlockSize = 65535;
+
+	std::vector<uint8_t> Bytes(Signature, Signature + sizeof(Signature));
+
+	std::vector<uint8_t> Header;
+	AppendBigEndian(Header, InWidth);
+	AppendBigEndian(Header, InHeight);
+	Header.push_back(8);	// Bit depth
+	Header.push_back(6);	// RGBA
+	Header.push_back(0);	// Deflate
+	Header.push_back(0);	// Adaptive filtering
+	Header.push_back(0);	// No interlace
+	AppendChunk(Bytes, "IHDR", Header);
+
+	// Every scanline starts with filter type 0.
+	const size_t RowSize = static_cast<size_t>(InWidth) * 4;
+	std::vector<uint8_t> Scanlines;
+	Scanlines.reserve((RowSize + 1) * InHeight);
+	for (uint32_t Row = 0; Row < InHeight; ++Row)
+	{
+		Scanlines.push_back(0);
+		Scanlines.insert(Scanlines.end(), InRGBA + Row * RowSize, InRGBA + (Row + 1) * RowSize);
+	}
+
+	std::vector<uint8_t> Compressed;
+	Compressed.reserve(Scanlines.size() + Scanlines.size() / MaxStoredBlockSize * 5 + 16);
+	Compressed.push_back(0x78);
+	Compressed.push_back(0x01);
+
+	uint32_t AdlerA = 1;
+	uint32_t AdlerB = 0;
+
+	size_t Offset = 0;
+	do
+	{
+		const size_t BlockSize = std::min(Scanlines.size() - Offset, MaxStoredBlockSize);
+		const bool bFinal = Offset + BlockSize == Scanlines.size();
+
+		Compressed.push_back(bFinal ? 1 : 0);
+		Compressed.push_back(static_cast<uint8_t>(BlockSize));
+		Compressed.push_back(static_cast<uint8_t>(BlockSize >> 8));
+		Compressed.push_back(static_cast<uint8_t>(~BlockSize));
+		Compressed.push_back(static_cast<uint8_t>(~BlockSize >> 8));
+		Compressed.insert(Compressed.end(), Scanlines.begin() + Offset, Scanlines.begin() + Offset + BlockSize);
+
+		for (size_t Idx = Offset; Idx < Offset + BlockSize; ++Idx)
+		{
+			AdlerA = (AdlerA + Scanlines[Idx]) % 65521;
+			AdlerB = (AdlerB + AdlerA) % 65521;
+		}
+
+		Offset += BlockSize;
+	}
+	while (Offset < Scanlines.size());
+
+	AppendBigEndian(Compressed, (AdlerB << 16) | AdlerA);
+	AppendChunk(Bytes, "IDAT", Compressed);
+	AppendChunk(Bytes, "IEND", {});
+
+	return WriteFile(InFilename, Bytes.data(), Bytes.size());
+}
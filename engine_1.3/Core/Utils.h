@@ -3,10 +3,15 @@
 #include <string>
 #include <vector>
 #include <type_traits>
+#include <cstdint>
 
 #include "stb_image.h"
 
 bool ReadFile(const std::string& InFilename, std::vector<char>& OutBytes);
+bool WriteFile(const std::string& InFilename, const void* InData, size_t InSize);
+
+// Writes 8-bit RGBA pixels as an uncompressed (stored deflate) PNG. Cheap enough to run every frame.
+bool WritePNG(const std::string& InFilename, uint32_t InWidth, uint32_t InHeight, const uint8_t* InRGBA);
 
 template <typename T>
 inline void CombineHash(std::size_t& InSeed, const T& V)
@@ -6,6 +6,7 @@ AActor::AActor()
 	, Transform()
 	, CachedModelMatrix(1.0)
 	, bVisible(true)
+	, bModelMatrixDirty(true)
 {
 
 }
@@ -81,4 +82,5 @@ void AActor::UpdateModelMatrix()
 {
 	static const glm::mat4 IdentityMatrix(1.0f);
 	CachedModelMatrix = glm::translate(IdentityMatrix, Transform.GetTranslation()) * glm::toMat4(Transform.GetRotation()) * glm::scale(IdentityMatrix, Transform.GetScale());
+	bModelMatrixDirty = true;
 }
@@ -58,6 +58,9 @@ public:
 
 	glm::mat4 GetCachedModelMatrix() const { return CachedModelMatrix; }
 
+	bool IsModelMatrixDirty() const { return bModelMatrixDirty; }
+	void ClearModelMatrixDirty() { bModelMatrixDirty = false; }
+
 protected:
 	void UpdateModelMatrix();
 
@@ -68,5 +71,6 @@ protected:
 	glm::mat4 CachedModelMatrix;
 
 	bool bVisible;
+	bool bModelMatrixDirty;
 };
 
@@ -15,11 +15,16 @@ ACameraActor::ACameraActor()
 	, PrevMouseX(0.0f)
 	, PrevMouseY(0.0f)
 	, RelativeMoveDelta(0.0f)
+	, AbsoluteMoveDelta(0.0f)
+	, LastDeltaTime(0.0f)
 {
 }
 
 void ACameraActor::Tick(float InDeltaTime)
 {
+	InputSampleTime = std::chrono::steady_clock::now();
+	LastDeltaTime = InDeltaTime;
+
 	GLFWwindow* Window = GEngine->GetWindow();
 	if (Window == nullptr)
 	{
@@ -37,10 +42,53 @@ void ACameraActor::Tick(float InDeltaTime)
 		return;
 	}
 
-	glm::vec3 RotationDelta(0.0f);
+	ApplyMouseLook(InDeltaTime);
+
+	glm::mat4 RotationMatrix = glm::toMat4(GetRotation());
+
+	float CameraMoveSpeed;
+	GConfig->Get("CameraMoveSpeed", CameraMoveSpeed);
+
+	glm::vec4 RelativeMoveVector = RotationMatrix * glm::vec4(glm::normalize(RelativeMoveDelta), 1.0f);
+	glm::vec3 FinalRelativeMoveDelta(RelativeMoveVector);
+	FinalRelativeMoveDelta = glm::normalize(FinalRelativeMoveDelta);
+
+	if (glm::length(FinalRelativeMoveDelta) > FLT_EPSILON)
+	{
+		AddOffset(FinalRelativeMoveDelta * CameraMoveSpeed * InDeltaTime);
+	}
+
+	glm::vec3 FinalAbsoluteMoveDelta = glm::normalize(AbsoluteMoveDelta);
+
+	if (glm::length(FinalAbsoluteMoveDelta) > FLT_EPSILON)
+	{
+		AddOffset(FinalAbsoluteMoveDelta * CameraMoveSpeed * InDeltaTime);
+	}
+}
+
+void ACameraActor::LateUpdate()
+{
+	InputSampleTime = std::chrono::steady_clock::now();
+
+	GLFWwindow* Window = GEngine->GetWindow();
+	if (Window == nullptr)
+	{
+		return;
+	}
+
+	if (glfwGetMouseButton(Window, GLFW_MOUSE_BUTTON_RIGHT) != GLFW_PRESS)
+	{
+		return;
+	}
+
+	// Movement is integrated over the whole frame in Tick; only the look direction is worth re-sampling.
+	ApplyMouseLook(LastDeltaTime);
+}
 
+void ACameraActor::ApplyMouseLook(float InDeltaTime)
+{
 	double MouseX, MouseY;
-	glfwGetCursorPos(Window, &MouseX, &MouseY);
+	glfwGetCursorPos(GEngine->GetWindow(), &MouseX, &MouseY);
 
 	double MouseDeltaX = MouseX - PrevMouseX;
 	double MouseDeltaY = MouseY - PrevMouseY;
@@ -61,27 +109,6 @@ void ACameraActor::Tick(float InDeltaTime)
 
 	PrevMouseX = MouseX;
 	PrevMouseY = MouseY;
-
-	glm::mat4 RotationMatrix = glm::toMat4(GetRotation());
-
-	float CameraMoveSpeed;
-	GConfig->Get("CameraMoveSpeed", CameraMoveSpeed);
-
-	glm::vec4 RelativeMoveVector = RotationMatrix * glm::vec4(glm::normalize(RelativeMoveDelta), 1.0f);
-	glm::vec3 FinalRelativeMoveDelta(RelativeMoveVector);
-	FinalRelativeMoveDelta = glm::normalize(FinalRelativeMoveDelta);
-
-	if (glm::length(FinalRelativeMoveDelta) > FLT_EPSILON)
-	{
-		AddOffset(FinalRelativeMoveDelta * CameraMoveSpeed * InDeltaTime);
-	}
-
-	glm::vec3 FinalAbsoluteMoveDelta = glm::normalize(AbsoluteMoveDelta);
-
-	if (glm::length(FinalAbsoluteMoveDelta) > FLT_EPSILON)
-	{
-		AddOffset(FinalAbsoluteMoveDelta * CameraMoveSpeed * InDeltaTime);
-	}
 }
 
 void ACameraActor::OnMouseButtonDown(int InButton, int InMods)
@@ -5,6 +5,8 @@
 
 #include "glm/glm.hpp"
 
+#include <chrono>
+
 class ACameraActor : public AActor
 {
 public:
@@ -23,6 +25,9 @@ public:
 	
 	virtual void Tick(float InDeltaTime) override;
 
+	// Applies the mouse movement since the last Tick, so a view taken right before submit sees the newest input.
+	void LateUpdate();
+
 	virtual void OnMouseButtonDown(int InButton, int InMods) override;
 	virtual void OnMouseButtonUp(int InButton, int InMods) override;
 	virtual void OnMouseWheel(double InXOffset, double InYOffset) override;
@@ -31,6 +36,11 @@ public:
 
 	glm::mat4 GetViewMatrix() const;
 
+	std::chrono::steady_clock::time_point GetInputSampleTime() const { return InputSampleTime; }
+
+protected:
+	void ApplyMouseLook(float InDeltaTime);
+
 protected:
 	float Near;
 	float Far;
@@ -41,4 +51,7 @@ protected:
 	glm::vec3 RelativeMoveDelta;
 	glm::vec3 AbsoluteMoveDelta;
 
+	float LastDeltaTime;
+	std::chrono::steady_clock::time_point InputSampleTime;
+
 };
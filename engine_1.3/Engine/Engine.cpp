@@ -2,6 +2,8 @@
 #include "Config.h"
 #include "AssetManager.h"
 #include "Utils.h"
+#include "CpuProfiler.h"
+#include "ShaderCompiler.h"
 #include "World.h"
 #include "LightActor.h"
 #include "MeshActor.h" 
@@ -9,15 +11,52 @@
 #include "VulkanContext.h"
 #include "VulkanMeshRenderer.h"
 #include "VulkanUIRenderer.h"
+#include "VulkanViewport.h"
+#include "VulkanLatency.h"
+#include "VulkanNullBackend.h"
 
 #include "glfw/glfw3.h"
 #include "imgui/imgui.h"
 #include "imgui/imgui_impl_vulkan.h"
 #include "imgui/imgui_impl_glfw.h"
 
+#include <thread>
+#include <iostream>
 #include <stdexcept>
 #include <cassert>
-#include <filesystem>
+#include <algorithm>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <timeapi.h>
+#pragma comment(lib, "winmm.lib")
+#endif
+
+using FFrameClock = std::chrono::steady_clock;
+
+static const int32_t DefaultFrameStatsWindow = 240;
+
+// How long a single glfwPollEvents has to stay blocked before it is taken for a modal resize or move loop.
+static const std::chrono::milliseconds ModalPollThreshold(50);
+static const int32_t DefaultFrameSpinMicroseconds = 2000;
+static const double FrameReportInterval = 5.0;
+
+// Sleeping is only as precise as the scheduler tick, so sleep until shortly before the deadline and spin the rest.
+static void WaitUntil(FFrameClock::time_point InDeadline, FFrameClock::duration InSpinThreshold)
+{
+	if (InDeadline - FFrameClock::now() > InSpinThreshold)
+	{
+		std::this_thread::sleep_until(InDeadline - InSpinThreshold);
+	}
+
+	while (FFrameClock::now() < InDeadline)
+	{
+		std::this_thread::yield();
+	}
+}
 
 FEngine* GEngine;
 
@@ -39,6 +78,13 @@ FEngine::FEngine()
 	: Window(nullptr)
 	, World(nullptr)
 	, RenderContext(nullptr)
+	, bHeadless(false)
+	, bTicking(false)
+	, bPollingEvents(false)
+	, FramePacing(EFramePacing::Sleep)
+	, TargetFrameTime(FFrameClock::duration::zero())
+	, SpinThreshold(std::chrono::microseconds(DefaultFrameSpinMicroseconds))
+	, NumFrames(0)
 {
 }
 
@@ -49,18 +95,59 @@ FEngine::~FEngine()
 
 	delete RenderContext;
 
-	glfwDestroyWindow(Window);
-	glfwTerminate();
+	if (Window != nullptr)
+	{
+		glfwDestroyWindow(Window);
+		glfwTerminate();
+	}
 }
 
 void FEngine::Initialize()
 {
-	InitializeGLFW();
-	CreateGLFWWindow();
+	CPU_PROFILE_THREAD("Main");
+
+	GConfig->Get("Headless", bHeadless);
+
+	// The null backend has no surfaces to present to.
+	if (VkNull::IsEnabled())
+	{
+		bHeadless = true;
+	}
+
+	// Headless runs render into an offscreen swapchain, so no window system is needed at all.
+	if (bHeadless == false)
+	{
+		InitializeGLFW();
+		CreateGLFWWindow();
+	}
 	CompileShaders();
 
+	float TargetFPS = 0.0f;
+	GConfig->Get("TargetFPS", TargetFPS);
+	SetTargetFPS(TargetFPS);
+
+	std::string ConfigFramePacing = "sleep";
+	GConfig->Get("FramePacing", ConfigFramePacing);
+	FramePacing = ConfigFramePacing == "present" ? EFramePacing::Present : ConfigFramePacing == "none" ? EFramePacing::None : EFramePacing::Sleep;
+
+	// Headless runs are for measurement, so they render back to back.
+	if (bHeadless)
+	{
+		FramePacing = EFramePacing::None;
+	}
+
+	int32_t SpinMicroseconds = DefaultFrameSpinMicroseconds;
+	GConfig->Get("FrameSpinMicroseconds", SpinMicroseconds);
+	SpinThreshold = std::chrono::microseconds(std::max(SpinMicroseconds, 0));
+
+	int32_t FrameStatsWindow = DefaultFrameStatsWindow;
+	GConfig->Get("FrameStatsWindow", FrameStatsWindow);
+	FrameTimes.assign(static_cast<size_t>(std::max(FrameStatsWindow, 1)), 0.0);
+	WorkTimes.assign(FrameTimes.size(), 0.0);
+
 	World = new FWorld();
 	RenderContext = new FVulkanContext(Window);
+	RenderContext->SetViewLatch([this]() { return LatchCamera(); });
 
 	FAssetManager::Startup();
 }
@@ -92,6 +179,11 @@ FVulkanUIRenderer* FEngine::GetUIRenderer() const
 
 void FEngine::Tick(float DeltaTime)
 {
+	CPU_PROFILE_FRAME();
+	CPU_PROFILE_SCOPE("FEngine::Tick");
+
+	bTicking = true;
+
 	if (World != nullptr)
 	{
 		World->Tick(DeltaTime);
@@ -100,6 +192,154 @@ void FEngine::Tick(float DeltaTime)
 
 	assert(RenderContext != nullptr);
 	RenderContext->Render();
+
+	bTicking = false;
+}
+
+void FEngine::Run()
+{
+	int32_t HeadlessFrameCount = 0;
+	GConfig->Get("HeadlessFrameCount", HeadlessFrameCount);
+
+	auto ShouldExit = [&]()
+	{
+		return bHeadless ? NumFrames >= static_cast<uint64_t>(std::max(HeadlessFrameCount, 0)) : glfwWindowShouldClose(Window) != 0;
+	};
+
+#ifdef _WIN32
+	// Lets the sleep in WaitUntil wake within a millisecond instead of a whole scheduler tick.
+	timeBeginPeriod(1);
+#endif
+
+	FFrameClock::time_point PreviousFrameStart = FFrameClock::now();
+	FFrameClock::time_point FrameDeadline = PreviousFrameStart;
+	double TimeSinceReport = 0.0;
+
+	while (ShouldExit() == false)
+	{
+		const FFrameClock::time_point FrameStart = FFrameClock::now();
+		const double DeltaTime = std::chrono::duration<double>(FrameStart - PreviousFrameStart).count();
+		PreviousFrameStart = FrameStart;
+
+		if (bHeadless == false)
+		{
+			bPollingEvents = true;
+			PollStartTime = FFrameClock::now();
+			glfwPollEvents();
+			bPollingEvents = false;
+		}
+
+		Tick(static_cast<float>(DeltaTime));
+
+		const FFrameClock::time_point WorkEnd = FFrameClock::now();
+
+		if (FramePacing == EFramePacing::Sleep && TargetFrameTime > FFrameClock::duration::zero())
+		{
+			// Deadlines advance by whole budgets so small overshoots do not accumulate into drift.
+			FrameDeadline += TargetFrameTime;
+
+			// After a hitch, restart the schedule instead of rushing frames out to catch up.
+			if (FrameDeadline < WorkEnd)
+			{
+				FrameDeadline = WorkEnd;
+			}
+			else
+			{
+				WaitUntil(FrameDeadline, SpinThreshold);
+			}
+		}
+
+		// The first frame has nothing to measure against.
+		if (NumFrames > 0)
+		{
+			RecordFrameTime(DeltaTime * 1000.0, std::chrono::duration<double, std::milli>(WorkEnd - FrameStart).count());
+		}
+		++NumFrames;
+
+		TimeSinceReport += DeltaTime;
+		if (TimeSinceReport >= FrameReportInterval)
+		{
+			FFrameStats Stats = GetFrameStats();
+			std::cout << "Frame: " << Stats.AverageFrameMs << " ms avg (" << Stats.GetAverageFPS() << " fps), "
+				<< Stats.P99FrameMs << " ms p99, " << Stats.AverageWorkMs << " ms work" << std::endl;
+
+			FVulkanLatencyTracker* LatencyTracker = RenderContext->GetLatencyTracker();
+			if (LatencyTracker->IsEnabled())
+			{
+				FLatencyStats Latency = LatencyTracker->GetStats();
+				std::cout << "Latency (" << FVulkanViewport::GetPresentProfileName(RenderContext->GetViewport()->GetPresentProfile()) << "): " << Latency.AverageInputToSubmitMs << " ms input to submit (" << Latency.P99InputToSubmitMs << " p99), "
+					<< Latency.AverageSubmitToPresentMs << " ms submit to present (" << Latency.P99SubmitToPresentMs << " p99)" << std::endl;
+			}
+			TimeSinceReport = 0.0;
+		}
+	}
+
+#ifdef _WIN32
+	timeEndPeriod(1);
+#endif
+}
+
+void FEngine::SetTargetFPS(float InTargetFPS)
+{
+	TargetFrameTime = InTargetFPS > 0.0f
+		? std::chrono::duration_cast<FFrameClock::duration>(std::chrono::duration<double>(1.0 / InTargetFPS))
+		: FFrameClock::duration::zero();
+}
+
+void FEngine::RecordFrameTime(double InFrameMs, double InWorkMs)
+{
+	const size_t Index = static_cast<size_t>(NumFrames % FrameTimes.size());
+	FrameTimes[Index] = InFrameMs;
+	WorkTimes[Index] = InWorkMs;
+}
+
+FFrameStats FEngine::GetFrameStats() const
+{
+	FFrameStats Stats;
+	Stats.NumFrames = NumFrames;
+
+	// Frame 0 is never recorded.
+	const size_t NumSamples = static_cast<size_t>(std::min<uint64_t>(NumFrames > 0 ? NumFrames - 1 : 0, FrameTimes.size()));
+	if (NumSamples == 0)
+	{
+		return Stats;
+	}
+
+	std::vector<double> Sorted;
+	Sorted.reserve(NumSamples);
+
+	double TotalWork = 0.0;
+	for (uint64_t Frame = NumFrames - NumSamples; Frame < NumFrames; ++Frame)
+	{
+		const size_t Index = static_cast<size_t>(Frame % FrameTimes.size());
+		Sorted.push_back(FrameTimes[Index]);
+		TotalWork += WorkTimes[Index];
+	}
+
+	Stats.LastFrameMs = FrameTimes[static_cast<size_t>((NumFrames - 1) % FrameTimes.size())];
+	Stats.AverageWorkMs = TotalWork / NumSamples;
+
+	std::sort(Sorted.begin(), Sorted.end());
+
+	double Total = 0.0;
+	for (double FrameMs : Sorted)
+	{
+		Total += FrameMs;
+	}
+
+	Stats.AverageFrameMs = Total / NumSamples;
+	Stats.MinFrameMs = Sorted.front();
+	Stats.MaxFrameMs = Sorted.back();
+	Stats.P99FrameMs = Sorted[std::min(NumSamples - 1, static_cast<size_t>(NumSamples * 0.99))];
+
+	return Stats;
+}
+
+bool FEngine::LatchCamera()
+{
+	// No event poll here: callbacks would run against a half-recorded frame, and glfwGetCursorPos already
+	// queries the cursor as it is now.
+	return World != nullptr && World->LatchCamera();
 }
 
 void FEngine::InitializeGLFW()
@@ -131,6 +371,7 @@ void FEngine::CreateGLFWWindow()
 	glfwSetMouseButtonCallback(Window, OnMouseButtonEvent);
 	glfwSetScrollCallback(Window, OnMouseWheelEvent);
 	glfwSetKeyCallback(Window, OnKeyEvent);
+	glfwSetWindowRefreshCallback(Window, OnWindowRefreshEvent);
 }
 
 void FEngine::CompileShaders()
@@ -138,20 +379,15 @@ void FEngine::CompileShaders()
 	std::string ShaderDirectory;
 	GConfig->Get("ShaderDirectory", ShaderDirectory);
 
-	for (const auto& Entry : std::filesystem::directory_iterator(ShaderDirectory))
-	{
-		std::string Filename = Entry.path().string();
-		std::string Extension = Entry.path().extension().string();
-		if (Extension == ".vert" || Extension == ".frag" || Extension == ".geom")
-		{
-			std::string Command = "glslang -g -V ";
-			Command += Filename;
-			Command += " -o ";
-			Command += Filename + ".spv";
+	FShaderCompiler ShaderCompiler(ShaderDirectory);
+	FShaderCompileStats Stats = ShaderCompiler.CompileAll();
 
-			system(Command.c_str());
-		}
+	std::cout << "Shaders: " << Stats.NumCompiled << " compiled, " << Stats.NumUpToDate << " up to date";
+	if (Stats.NumFailed > 0)
+	{
+		std::cout << ", " << Stats.NumFailed << " failed";
 	}
+	std::cout << " (" << Stats.Ms << " ms)" << std::endl;
 }
 
 void FEngine::OnMouseButtonEvent(GLFWwindow* InWindow, int InButton, int InAction, int InMods)
@@ -212,3 +448,23 @@ void FEngine::OnKeyEvent(GLFWwindow* InWindow, int InKey, int InScanCode, int In
 		}
 	}
 }
+
+void FEngine::OnWindowRefreshEvent(GLFWwindow* InWindow)
+{
+	assert(GEngine != nullptr);
+
+	if (GEngine->bTicking || GEngine->RenderContext == nullptr)
+	{
+		return;
+	}
+
+	// While the user drags the window border, Win32 runs a modal loop inside glfwPollEvents and only calls back
+	// for repaints, so frames have to come from here to keep the window updating. A refresh from an ordinary
+	// poll is followed by the frame Run ticks anyway and must not render an extra one.
+	if (GEngine->bPollingEvents == false || FFrameClock::now() - GEngine->PollStartTime < ModalPollThreshold)
+	{
+		return;
+	}
+
+	GEngine->Tick(0.0f);
+}
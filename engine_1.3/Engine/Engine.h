@@ -1,5 +1,34 @@
 #pragma once
 
+#include <chrono>
+#include <vector>
+#include <cstdint>
+
+enum class EFramePacing
+{
+	// Sleep away the rest of the frame budget, then spin for the last stretch.
+	Sleep,
+	// Let a FIFO swapchain block in present; the CPU never waits on its own.
+	Present,
+	// Render back to back.
+	None
+};
+
+struct FFrameStats
+{
+	uint64_t NumFrames = 0;
+	double LastFrameMs = 0.0;
+	double AverageFrameMs = 0.0;
+	double MinFrameMs = 0.0;
+	double MaxFrameMs = 0.0;
+	double P99FrameMs = 0.0;
+
+	// Time spent ticking and rendering, without the pacing wait.
+	double AverageWorkMs = 0.0;
+
+	double GetAverageFPS() const { return AverageFrameMs > 0.0 ? 1000.0 / AverageFrameMs : 0.0; }
+};
+
 class FEngine
 {
 public:
@@ -10,6 +39,7 @@ public:
 	virtual ~FEngine();
 
 	struct GLFWwindow* GetWindow() const;
+	bool IsHeadless() const { return bHeadless; }
 	class FWorld* GetWorld() const;
 	class FVulkanContext* GetRenderContext() const;
 	class FVulkanMeshRenderer* GetMeshRenderer() const;
@@ -17,6 +47,16 @@ public:
 
 	void Tick(float DeltaTime);
 
+	// Ticks until the window closes, or for HeadlessFrameCount frames when headless.
+	void Run();
+
+	EFramePacing GetFramePacing() const { return FramePacing; }
+	void SetFramePacing(EFramePacing InFramePacing) { FramePacing = InFramePacing; }
+	void SetTargetFPS(float InTargetFPS);
+
+	uint64_t GetFrameCount() const { return NumFrames; }
+	FFrameStats GetFrameStats() const;
+
 private:
 	void Initialize();
 
@@ -24,14 +64,35 @@ private:
 	void CreateGLFWWindow();
 	void CompileShaders();
 
+	void RecordFrameTime(double InFrameMs, double InWorkMs);
+
+	bool LatchCamera();
+
 	static void OnMouseButtonEvent(GLFWwindow* InWindow, int InButton, int InAction, int InMods);
 	static void OnMouseWheelEvent(GLFWwindow* InWindow, double InXOffset, double InYOffset);
 	static void OnKeyEvent(GLFWwindow* InWindow, int InKey, int InScanCode, int InAction, int InMods);
+	static void OnWindowRefreshEvent(GLFWwindow* InWindow);
 
 private:
 	struct GLFWwindow* Window;
 	class FWorld* World;
 	class FVulkanContext* RenderContext;
+
+	bool bHeadless;
+	bool bTicking;
+
+	// Set while Run is inside glfwPollEvents, which on Win32 does not return during a live resize or move.
+	bool bPollingEvents;
+	std::chrono::steady_clock::time_point PollStartTime;
+
+	EFramePacing FramePacing;
+	std::chrono::steady_clock::duration TargetFrameTime;
+	std::chrono::steady_clock::duration SpinThreshold;
+
+	// Rolling window of the most recent frames, indexed by frame number.
+	std::vector<double> FrameTimes;
+	std::vector<double> WorkTimes;
+	uint64_t NumFrames;
 };
 
 extern FEngine* GEngine;
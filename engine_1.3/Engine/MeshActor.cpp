@@ -54,5 +54,11 @@ void AMeshActor::UpdateRenderModel()
 		CreateRenderModel();
 	}
 
+	if (IsModelMatrixDirty() == false)
+	{
+		return;
+	}
+
 	RenderModel->SetModelMatrix(GetCachedModelMatrix());
+	ClearModelMatrixDirty();
 }
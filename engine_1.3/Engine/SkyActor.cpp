@@ -42,5 +42,11 @@ void ASkyActor::UpdateRenderModel()
 		CreateRenderModel();
 	}
 
+	if (IsModelMatrixDirty() == false)
+	{
+		return;
+	}
+
 	RenderModel->SetModelMatrix(GetCachedModelMatrix());
+	ClearModelMatrixDirty();
 }
@@ -8,6 +8,8 @@
 #include "SkyActor.h"
 #include "MeshActor.h"
 
+#include "CpuProfiler.h"
+
 #include "VulkanContext.h"
 #include "VulkanScene.h"
 #include "VulkanModel.h"
@@ -53,6 +55,8 @@ void FWorld::DestroyActor(AActor* InActor)
 
 void FWorld::Tick(float DeltaTime)
 {
+	CPU_PROFILE_SCOPE("FWorld::Tick");
+
 	if (RenderScene == nullptr)
 	{
 		GenerateRenderScene();
@@ -91,6 +95,21 @@ FVulkanScene* FWorld::GetRenderScene() const
 	return RenderScene;
 }
 
+bool FWorld::LatchCamera()
+{
+	CPU_PROFILE_SCOPE("FWorld::LatchCamera");
+
+	if (CameraActor == nullptr || RenderScene == nullptr)
+	{
+		return false;
+	}
+
+	CameraActor->LateUpdate();
+	UpdateRenderCamera();
+
+	return true;
+}
+
 void FWorld::GenerateRenderScene()
 {
 	assert(GEngine != nullptr);
@@ -146,6 +165,8 @@ void FWorld::GenerateRenderScene()
 
 void FWorld::UpdateRenderScene()
 {	
+	CPU_PROFILE_SCOPE("FWorld::UpdateRenderScene");
+
 	assert(GEngine != nullptr);
 
 	if (RenderScene == nullptr)
@@ -156,18 +177,7 @@ void FWorld::UpdateRenderScene()
 	std::vector<FVulkanPointLight> PointLights;
 	std::vector<FVulkanDirectionalLight> DirectionalLights;
 
-	if (CameraActor != nullptr)
-	{
-		FVulkanCamera Camera;
-		Camera.Position = CameraActor->GetLocation();
-		Camera.Rotation = CameraActor->GetRotation();
-		Camera.FOV = CameraActor->GetFOV();
-		Camera.Far = CameraActor->GetFar();
-		Camera.Near = CameraActor->GetNear();
-		Camera.View = CameraActor->GetViewMatrix();
-
-		RenderScene->SetCamera(Camera);
-	}
+	UpdateRenderCamera();
 
 	for (AActor* Actor : Actors)
 	{
@@ -223,3 +233,22 @@ void FWorld::UpdateRenderScene()
 		SkyActor->UpdateRenderModel();
 	}
 }
+
+void FWorld::UpdateRenderCamera()
+{
+	if (CameraActor == nullptr)
+	{
+		return;
+	}
+
+	FVulkanCamera Camera;
+	Camera.Position = CameraActor->GetLocation();
+	Camera.Rotation = CameraActor->GetRotation();
+	Camera.FOV = CameraActor->GetFOV();
+	Camera.Far = CameraActor->GetFar();
+	Camera.Near = CameraActor->GetNear();
+	Camera.View = CameraActor->GetViewMatrix();
+	Camera.InputSampleTime = CameraActor->GetInputSampleTime();
+
+	RenderScene->SetCamera(Camera);
+}
@@ -32,9 +32,14 @@ public:
 
 	class FVulkanScene* GetRenderScene() const;
 
+	// Re-samples the camera input and pushes the resulting view into the render scene. Returns false if
+	// there is no camera or render scene to update.
+	bool LatchCamera();
+
 private:
 	void GenerateRenderScene();
 	void UpdateRenderScene();
+	void UpdateRenderCamera();
 
 private:
 	std::vector<class AActor*> Actors;
@@ -72,9 +72,9 @@ void FVulkanBuffer::Unload()
 	Unallocate();
 }
 
-bool FVulkanBuffer::Copy(uint8_t* InData, VkDeviceSize InBufferSize)
+bool FVulkanBuffer::Copy(uint8_t* InData, VkDeviceSize InBufferSize, VkDeviceSize InDstOffset)
 {
-	if (AllocatedSize != InBufferSize)
+	if (InDstOffset + InBufferSize > AllocatedSize)
 	{
 		return false;
 	}
@@ -100,7 +100,7 @@ bool FVulkanBuffer::Copy(uint8_t* InData, VkDeviceSize InBufferSize)
 	memcpy(MappedMemory, InData, static_cast<size_t>(InBufferSize));
 	vkUnmapMemory(Device, StagingBufferMemory);
 
-	Vk::CopyBuffer(Device, CommandPool, GfxQueue, StagingBuffer, Buffer, InBufferSize);
+	Vk::CopyBuffer(Device, CommandPool, GfxQueue, StagingBuffer, Buffer, InBufferSize, InDstOffset);
 
 	vkDestroyBuffer(Device, StagingBuffer, nullptr);
 	vkFreeMemory(Device, StagingBufferMemory, nullptr);
@@ -26,11 +26,13 @@ public:
 	void Load(uint8_t* InData, VkDeviceSize InBufferSize);
 	void Unload();
 
-	bool Copy(uint8_t* InData, VkDeviceSize InBufferSize);
+	bool Copy(uint8_t* InData, VkDeviceSize InBufferSize, VkDeviceSize InDstOffset = 0);
 
 	void Map();
 	void Unmap();
 
+	VkDeviceSize GetAllocatedSize() const { return AllocatedSize; }
+
 protected:
 	VkBuffer Buffer;
 	VkDeviceMemory Memory;
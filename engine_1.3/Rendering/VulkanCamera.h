@@ -3,6 +3,8 @@
 #include "glm/glm.hpp"
 #include "glm/gtc/quaternion.hpp"
 
+#include <chrono>
+
 struct FVulkanCamera
 {
 	glm::vec3 Position;
@@ -12,4 +14,7 @@ struct FVulkanCamera
 	float FOV;
 	float Near;
 	float Far;
+
+	// When the input this view was derived from was read.
+	std::chrono::steady_clock::time_point InputSampleTime;
 };
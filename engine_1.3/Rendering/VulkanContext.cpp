@@ -5,12 +5,23 @@
 #include "VulkanViewport.h"
 #include "VulkanFramebuffer.h"
 #include "VulkanRenderPass.h"
+#include "VulkanDescriptorAllocator.h"
+#include "VulkanShaderCache.h"
+#include "VulkanSamplerCache.h"
+#include "VulkanPipelineCache.h"
+#include "VulkanPipelineLibrary.h"
+#include "VulkanGeometryPool.h"
+#include "VulkanReadback.h"
+#include "VulkanGpuProfiler.h"
+#include "VulkanLatency.h"
+#include "VulkanScene.h"
 #include "VulkanRenderer.h"
 #include "VulkanMeshRenderer.h"
 #include "VulkanSkyRenderer.h"
 #include "VulkanUIRenderer.h"
 
 #include "Config.h"
+#include "CpuProfiler.h"
 
 #include <array>
 #include <vector>
@@ -30,12 +41,17 @@ static std::vector<const char*> DeviceExtensions =
 	VK_KHR_SWAPCHAIN_EXTENSION_NAME
 };
 
-#ifdef NDEBUG
+static std::vector<const char*> HeadlessDeviceExtensions;
+
+#if defined(NDEBUG) || defined(VK_NULL_BACKEND)
 static const bool GEnableValidationLayers = false;
 #else
 static const bool GEnableValidationLayers = true;
 #endif
 
+static const int32_t MinConcurrentFrames = 1;
+static const int32_t MaxSupportedConcurrentFrames = 4;
+
 static std::unordered_map<GLFWwindow*, FVulkanContext*> RenderContextMap;
 
 void FramebufferResizeCallback(GLFWwindow* InWindow, int InWidth, int InHeight)
@@ -73,13 +89,38 @@ FVulkanContext::FVulkanContext(GLFWwindow* InWindow)
 	, Surface(VK_NULL_HANDLE)
 	, PhysicalDevice(VK_NULL_HANDLE)
 	, Device(VK_NULL_HANDLE)
+	, EnabledFeatures{}
+	, DescriptorPool(VK_NULL_HANDLE)
+	, DescriptorAllocator(nullptr)
+	, ShaderCache(nullptr)
+	, SamplerCache(nullptr)
+	, PipelineCache(nullptr)
+	, PipelineLibrary(nullptr)
+	, GeometryPool(nullptr)
+	, Readback(nullptr)
+	, GpuProfiler(nullptr)
+	, LatencyTracker(nullptr)
+	, bLateLatchCamera(false)
 	, MeshRenderer(nullptr)
 	, SkyRenderer(nullptr)
 	, UIRenderer(nullptr)
+	, FrameTimeline(VK_NULL_HANDLE)
+	, FrameTimelineValue(0)
+	, CurrentFrame(0)
+	, MaxConcurrentFrames(2)
 {
-	RenderContextMap[InWindow] = this;
+	int32_t ConfigConcurrentFrames = static_cast<int32_t>(MaxConcurrentFrames);
+	GConfig->Get("MaxConcurrentFrames", ConfigConcurrentFrames);
+	MaxConcurrentFrames = static_cast<uint32_t>(std::clamp(ConfigConcurrentFrames, MinConcurrentFrames, MaxSupportedConcurrentFrames));
+
+	GConfig->Get("LateLatchCamera", bLateLatchCamera);
+
+	if (Window != nullptr)
+	{
+		RenderContextMap[InWindow] = this;
 
-	glfwSetFramebufferSizeCallback(Window, FramebufferResizeCallback);
+		glfwSetFramebufferSizeCallback(Window, FramebufferResizeCallback);
+	}
 
 	CreateInstance();
 	SetupDebugMessenger();
@@ -90,24 +131,40 @@ FVulkanContext::FVulkanContext(GLFWwindow* InWindow)
 	CreateCommandBuffers();
 	CreateSyncObjects();
 	CreateDescriptorPool();
+	CreateDescriptorAllocator();
+	CreateShaderCache();
+	CreateSamplerCache();
+	CreatePipelineCache();
+	CreatePipelineLibrary();
+	CreateGeometryPool();
 	CreateViewport();
+	CreateReadback();
+	CreateGpuProfiler();
+	CreateLatencyTracker();
 	CreateRenderers();
 }
 
 FVulkanContext::~FVulkanContext()
 {
-	RenderContextMap.erase(Window);
+	if (Window != nullptr)
+	{
+		RenderContextMap.erase(Window);
+	}
+
+	// Stop the pipeline compile workers before anything they may still be reading from goes away.
+	DestroyObject(PipelineLibrary);
+
+	std::vector<FVulkanObject*> LiveObjects;
+	ObjectRegistry.GetLiveObjects(LiveObjects);
 
-	for (int Idx = 0; Idx < LiveObjects.size(); ++Idx)
+	for (FVulkanObject* LiveObject : LiveObjects)
 	{
-		if (LiveObjects[Idx] != nullptr)
-		{
-			LiveObjects[Idx]->Destroy();
-			delete LiveObjects[Idx];
-			LiveObjects[Idx] = nullptr;
-		}
+		DestroyObject(LiveObject);
 	}
 
+	delete ShaderCache;
+	delete SamplerCache;
+	delete DescriptorAllocator;
 	vkDestroyDescriptorPool(Device, DescriptorPool, nullptr);
 	vkDestroyCommandPool(Device, CommandPool, nullptr);
 
@@ -115,8 +172,8 @@ FVulkanContext::~FVulkanContext()
 	{
 		vkDestroySemaphore(Device, ImageAcquiredSemaphores[Idx], nullptr);
 		vkDestroySemaphore(Device, RenderFinishedSemaphores[Idx], nullptr);
-		vkDestroyFence(Device, Fences[Idx], nullptr);
 	}
+	vkDestroySemaphore(Device, FrameTimeline, nullptr);
 
 	vkDestroyDevice(Device, nullptr);
 
@@ -129,7 +186,10 @@ FVulkanContext::~FVulkanContext()
 		}
 	}
 
-	vkDestroySurfaceKHR(Instance, Surface, nullptr);
+	if (Surface != VK_NULL_HANDLE)
+	{
+		vkDestroySurfaceKHR(Instance, Surface, nullptr);
+	}
 	vkDestroyInstance(Instance, nullptr);
 }
 
@@ -138,34 +198,92 @@ void FVulkanContext::WaitIdle()
 	vkDeviceWaitIdle(Device);
 }
 
+uint64_t FVulkanContext::GetCompletedTimelineValue() const
+{
+	uint64_t Value = 0;
+	VK_ASSERT(vkGetSemaphoreCounterValue(Device, FrameTimeline, &Value));
+	return Value;
+}
+
+void FVulkanContext::WaitForTimelineValue(uint64_t InValue) const
+{
+	if (InValue == 0)
+	{
+		return;
+	}
+
+	VkSemaphoreWaitInfo WaitInfo{};
+	WaitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+	WaitInfo.semaphoreCount = 1;
+	WaitInfo.pSemaphores = &FrameTimeline;
+	WaitInfo.pValues = &InValue;
+
+	VK_ASSERT(vkWaitSemaphores(Device, &WaitInfo, UINT64_MAX));
+}
+
 void FVulkanContext::DestroyObject(FVulkanObject* InObject)
 {
-	if (IsValidObject(InObject) == false)
+	// Unregistering claims the object, so when several threads destroy it only one of them gets past here.
+	if (ObjectRegistry.Unregister(InObject) == false)
 	{
 		return;
 	}
 
 	InObject->Destroy();
+	delete InObject;
+}
+
+const std::vector<const char*>& FVulkanContext::GetRequiredDeviceExtensions() const
+{
+	return IsHeadless() ? HeadlessDeviceExtensions : DeviceExtensions;
+}
 
-	for (int Idx = 0; Idx < LiveObjects.size(); ++Idx)
+void FVulkanContext::RetireObject(FVulkanObject* InObject)
+{
+	if (IsValidObject(InObject) == false)
 	{
-		if (InObject == LiveObjects[Idx])
-		{
-			LiveObjects[Idx] = nullptr;
-			delete InObject;
-			break;
-		}
+		return;
 	}
+
+	// Swapchain recreation happens either after the frame was submitted or before its recording began, so
+	// nothing newer than the last submission can reference the object.
+	RetiredObjects.push_back({ InObject->GetObjectHandle(), FrameTimelineValue });
 }
 
-bool FVulkanContext::IsValidObject(FVulkanObject* InObject)
+void FVulkanContext::DestroyRetiredObjects()
 {
-	if (InObject == nullptr)
+	if (RetiredObjects.empty())
 	{
-		return false;
+		return;
 	}
 
-	return std::find(LiveObjects.begin(), LiveObjects.end(), InObject) != LiveObjects.end();
+	const uint64_t CompletedValue = GetCompletedTimelineValue();
+
+	auto Iter = std::remove_if(RetiredObjects.begin(), RetiredObjects.end(), [this, CompletedValue](const FRetiredObject& InRetired)
+	{
+		if (InRetired.TimelineValue > CompletedValue)
+		{
+			return false;
+		}
+
+		FVulkanObject* Object = ResolveObject(InRetired.Object);
+		if (Object != nullptr)
+		{
+			DestroyObject(Object);
+		}
+		return true;
+	});
+	RetiredObjects.erase(Iter, RetiredObjects.end());
+}
+
+bool FVulkanContext::IsValidObject(FVulkanObject* InObject) const
+{
+	return ObjectRegistry.Contains(InObject);
+}
+
+bool FVulkanContext::IsValidObject(FVulkanObjectHandle InHandle) const
+{
+	return ObjectRegistry.IsValid(InHandle);
 }
 
 void FVulkanContext::CreateInstance()
@@ -186,13 +304,21 @@ void FVulkanContext::CreateInstance()
 	ApplicationInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
 	ApplicationInfo.pEngineName = EngineName.c_str();
 	ApplicationInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-	ApplicationInfo.apiVersion = VK_API_VERSION_1_0;
+	ApplicationInfo.apiVersion = VK_API_VERSION_1_2;
 
-	uint32_t GLFWExtensionCount = 0;
-	const char** GLFWExtensions = glfwGetRequiredInstanceExtensions(&GLFWExtensionCount);
+	std::vector<const char*> Extensions;
+	if (IsHeadless() == false)
+	{
+		uint32_t GLFWExtensionCount = 0;
+		const char** GLFWExtensions = glfwGetRequiredInstanceExtensions(&GLFWExtensionCount);
+
+		Extensions.assign(GLFWExtensions, GLFWExtensions + GLFWExtensionCount);
+	}
 
-	std::vector<const char*> Extensions(GLFWExtensions, GLFWExtensions + GLFWExtensionCount);
-	Extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+	if (GEnableValidationLayers)
+	{
+		Extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+	}
 
 	VkInstanceCreateInfo InstanceCI{};
 	InstanceCI.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -246,6 +372,11 @@ void FVulkanContext::SetupDebugMessenger()
 
 void FVulkanContext::CreateSurface()
 {
+	if (IsHeadless())
+	{
+		return;
+	}
+
 	if (glfwCreateWindowSurface(Instance, Window, nullptr, &Surface) != VK_SUCCESS)
 	{
 		throw std::runtime_error("Failed to create window surface.");
@@ -267,7 +398,7 @@ void FVulkanContext::PickPhysicalDevice()
 
 	for (VkPhysicalDevice Device : Devices)
 	{
-		if (Vk::IsDeviceSuitable(Device, Surface, DeviceExtensions))
+		if (Vk::IsDeviceSuitable(Device, Surface, GetRequiredDeviceExtensions()))
 		{
 			PhysicalDevice = Device;
 			break;
@@ -301,20 +432,51 @@ void FVulkanContext::CreateLogicalDevice()
 		QueueCIs.push_back(QueueCI);
 	}
 
+	VkPhysicalDeviceFeatures SupportedFeatures{};
+	vkGetPhysicalDeviceFeatures(PhysicalDevice, &SupportedFeatures);
+
+	if (SupportedFeatures.drawIndirectFirstInstance == VK_FALSE)
+	{
+		throw std::runtime_error("GPU does not support drawIndirectFirstInstance.");
+	}
+
+	VkPhysicalDeviceTimelineSemaphoreFeatures SupportedTimelineFeatures{};
+	SupportedTimelineFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+
+	VkPhysicalDeviceFeatures2 SupportedFeatures2{};
+	SupportedFeatures2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+	SupportedFeatures2.pNext = &SupportedTimelineFeatures;
+	vkGetPhysicalDeviceFeatures2(PhysicalDevice, &SupportedFeatures2);
+
+	if (SupportedTimelineFeatures.timelineSemaphore == VK_FALSE)
+	{
+		throw std::runtime_error("GPU does not support timeline semaphores.");
+	}
+
 	VkPhysicalDeviceFeatures DeviceFeatures{};
 	DeviceFeatures.samplerAnisotropy = VK_TRUE;
 	DeviceFeatures.geometryShader = VK_TRUE;
+	DeviceFeatures.drawIndirectFirstInstance = VK_TRUE;
+	DeviceFeatures.multiDrawIndirect = SupportedFeatures.multiDrawIndirect;
+
+	EnabledFeatures = DeviceFeatures;
+
+	VkPhysicalDeviceTimelineSemaphoreFeatures TimelineFeatures{};
+	TimelineFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+	TimelineFeatures.timelineSemaphore = VK_TRUE;
 
 	VkDeviceCreateInfo DeviceCI{};
 	DeviceCI.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+	DeviceCI.pNext = &TimelineFeatures;
 
 	DeviceCI.queueCreateInfoCount = static_cast<uint32_t>(QueueCIs.size());
 	DeviceCI.pQueueCreateInfos = QueueCIs.data();
 
 	DeviceCI.pEnabledFeatures = &DeviceFeatures;
 
-	DeviceCI.enabledExtensionCount = static_cast<uint32_t>(DeviceExtensions.size());
-	DeviceCI.ppEnabledExtensionNames = DeviceExtensions.data();
+	const std::vector<const char*>& RequiredExtensions = GetRequiredDeviceExtensions();
+	DeviceCI.enabledExtensionCount = static_cast<uint32_t>(RequiredExtensions.size());
+	DeviceCI.ppEnabledExtensionNames = RequiredExtensions.data();
 
 	if (GEnableValidationLayers)
 	{
@@ -372,28 +534,35 @@ void FVulkanContext::CreateCommandBuffers()
 
 void FVulkanContext::CreateSyncObjects()
 {
-	uint32_t MaxConcurrentFrames = GetMaxConcurrentFrames();
-
 	ImageAcquiredSemaphores.resize(MaxConcurrentFrames);
 	RenderFinishedSemaphores.resize(MaxConcurrentFrames);
-	Fences.resize(MaxConcurrentFrames);
+	FrameSlotTimelineValues.assign(MaxConcurrentFrames, 0);
 
 	VkSemaphoreCreateInfo SemaphoreCI{};
 	SemaphoreCI.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
-	VkFenceCreateInfo FenceCI{};
-	FenceCI.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-	FenceCI.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-
 	for (size_t Idx = 0; Idx < MaxConcurrentFrames; ++Idx)
 	{
 		if (vkCreateSemaphore(Device, &SemaphoreCI, nullptr, &ImageAcquiredSemaphores[Idx]) != VK_SUCCESS ||
-			vkCreateSemaphore(Device, &SemaphoreCI, nullptr, &RenderFinishedSemaphores[Idx]) != VK_SUCCESS ||
-			vkCreateFence(Device, &FenceCI, nullptr, &Fences[Idx]) != VK_SUCCESS)
+			vkCreateSemaphore(Device, &SemaphoreCI, nullptr, &RenderFinishedSemaphores[Idx]) != VK_SUCCESS)
 		{
 			throw std::runtime_error("Failed to create synchronization objects for a frame.");
 		}
 	}
+
+	VkSemaphoreTypeCreateInfo TimelineCI{};
+	TimelineCI.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+	TimelineCI.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+	TimelineCI.initialValue = 0;
+
+	VkSemaphoreCreateInfo FrameTimelineCI{};
+	FrameTimelineCI.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+	FrameTimelineCI.pNext = &TimelineCI;
+
+	if (vkCreateSemaphore(Device, &FrameTimelineCI, nullptr, &FrameTimeline) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create the frame timeline semaphore.");
+	}
 }
 
 void FVulkanContext::CreateDescriptorPool()
@@ -423,24 +592,84 @@ void FVulkanContext::CreateDescriptorPool()
 	VK_ASSERT(vkCreateDescriptorPool(Device, &DescriptorPoolCI, nullptr, &DescriptorPool));
 }
 
+void FVulkanContext::CreateDescriptorAllocator()
+{
+	DescriptorAllocator = new FVulkanDescriptorAllocator(this);
+}
+
+void FVulkanContext::CreateShaderCache()
+{
+	ShaderCache = new FVulkanShaderCache(this);
+}
+
+void FVulkanContext::CreateSamplerCache()
+{
+	SamplerCache = new FVulkanSamplerCache(this);
+}
+
+void FVulkanContext::CreatePipelineCache()
+{
+	PipelineCache = CreateObject<FVulkanPipelineCache>();
+}
+
+void FVulkanContext::CreatePipelineLibrary()
+{
+	PipelineLibrary = CreateObject<FVulkanPipelineLibrary>();
+}
+
+void FVulkanContext::CreateGeometryPool()
+{
+	GeometryPool = CreateObject<FVulkanGeometryPool>();
+}
+
 void FVulkanContext::CreateViewport()
 {
 	Viewport = FVulkanViewport::Create(this, Window);
 }
 
-void FVulkanContext::RecreateSwapchain()
+void FVulkanContext::CreateReadback()
 {
-	int Width = 0, Height = 0;
-	glfwGetFramebufferSize(Window, &Width, &Height);
+	Readback = CreateObject<FVulkanReadback>();
 
-	while (Width == 0 || Height == 0)
+	std::string CaptureDirectory;
+	GConfig->Get("CaptureDirectory", CaptureDirectory);
+	if (CaptureDirectory.empty() == false)
 	{
-		glfwGetFramebufferSize(Window, &Width, &Height);
-		glfwWaitEvents();
+		std::string CaptureFormat = "png";
+		GConfig->Get("CaptureFormat", CaptureFormat);
+
+		Readback->StartCapture(CaptureDirectory, CaptureFormat == "raw" ? EReadbackFileFormat::Raw : EReadbackFileFormat::PNG);
 	}
+}
 
-	vkDeviceWaitIdle(Device);
+void FVulkanContext::CreateGpuProfiler()
+{
+	GpuProfiler = CreateObject<FVulkanGpuProfiler>();
+}
+
+void FVulkanContext::CreateLatencyTracker()
+{
+	LatencyTracker = CreateObject<FVulkanLatencyTracker>();
+}
+
+bool FVulkanContext::RecreateSwapchain()
+{
+	CPU_PROFILE_SCOPE("FVulkanContext::RecreateSwapchain");
 
+	// A minimized window has no surface area; keep the old swapchain and skip frames until it comes back.
+	if (IsHeadless() == false)
+	{
+		int Width = 0, Height = 0;
+		glfwGetFramebufferSize(Window, &Width, &Height);
+
+		if (Width == 0 || Height == 0)
+		{
+			return false;
+		}
+	}
+
+	// The old swapchain and everything built on it are retired rather than destroyed, so frames still in
+	// flight finish undisturbed and nothing here waits on the GPU.
 	Viewport->Recreate();
 
 	for (FVulkanRenderer* Renderer : Renderers)
@@ -450,16 +679,22 @@ void FVulkanContext::RecreateSwapchain()
 			Renderer->OnRecreateSwapchain();
 		}
 	}
+
+	return true;
 }
 
 void FVulkanContext::Render()
 {
-	BeginRender();
+	if (BeginRender() == false)
+	{
+		return;
+	}
 
 	for (FVulkanRenderer* Renderer : Renderers)
 	{
 		if (Renderer != nullptr)
 		{
+			FVulkanGpuScope Scope(this, GetCommandBuffer(), Renderer->GetName());
 			Renderer->Render();
 		}
 	}
@@ -467,9 +702,18 @@ void FVulkanContext::Render()
 	EndRender();
 }
 
-void FVulkanContext::BeginRender()
+bool FVulkanContext::BeginRender()
 {
-	vkWaitForFences(Device, 1, &Fences[CurrentFrame], VK_TRUE, UINT64_MAX);
+	CPU_PROFILE_SCOPE("FVulkanContext::BeginRender");
+
+	WaitForTimelineValue(FrameSlotTimelineValues[CurrentFrame]);
+
+	DestroyRetiredObjects();
+
+	// The slot's previous frame has finished, so nothing can still be reading its transient descriptor sets.
+	DescriptorAllocator->ResetFrame(CurrentFrame);
+
+	Readback->Poll();
 
 	FVulkanSwapchain* Swapchain = Viewport->GetSwapchain();
 	assert(Swapchain != nullptr);
@@ -477,16 +721,25 @@ void FVulkanContext::BeginRender()
 	VkResult AcquireResult = Swapchain->AcquireNextImage(ImageAcquiredSemaphores[CurrentFrame]);
 	if (AcquireResult == VK_ERROR_OUT_OF_DATE_KHR)
 	{
-		RecreateSwapchain();
-		return;
+		// A failed acquire leaves the semaphore unsignaled, so it can be reused on the new swapchain.
+		if (RecreateSwapchain() == false)
+		{
+			return false;
+		}
+
+		Swapchain = Viewport->GetSwapchain();
+		AcquireResult = Swapchain->AcquireNextImage(ImageAcquiredSemaphores[CurrentFrame]);
+		if (AcquireResult == VK_ERROR_OUT_OF_DATE_KHR)
+		{
+			return false;
+		}
 	}
-	else if (AcquireResult != VK_SUCCESS && AcquireResult != VK_SUBOPTIMAL_KHR)
+
+	if (AcquireResult != VK_SUCCESS && AcquireResult != VK_SUBOPTIMAL_KHR)
 	{
 		throw std::runtime_error("Failed to acquire swap chain image.");
 	}
 
-	vkResetFences(Device, 1, &Fences[CurrentFrame]);
-
 	VkCommandBuffer CommandBuffer = CommandBuffers[CurrentFrame];
 
 	vkResetCommandBuffer(CommandBuffer, 0);
@@ -495,44 +748,99 @@ void FVulkanContext::BeginRender()
 	CommandBufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
 
 	VK_ASSERT(vkBeginCommandBuffer(CommandBuffer, &CommandBufferBeginInfo));
+
+	GpuProfiler->BeginFrame(CommandBuffer);
+	GpuProfiler->BeginScope(CommandBuffer, "Frame");
+
+	return true;
 }
 
 void FVulkanContext::EndRender()
 {
+	CPU_PROFILE_SCOPE("FVulkanContext::EndRender");
+
 	VkCommandBuffer CommandBuffer = CommandBuffers[CurrentFrame];
 
+	Readback->RecordCopy(CommandBuffer);
+
+	GpuProfiler->EndFrame(CommandBuffer);
+
 	VK_ASSERT(vkEndCommandBuffer(CommandBuffer));
 
+	// The recorded commands only read the view-dependent uniforms once the GPU runs them, so patching the
+	// mapped buffers here shows the newest camera without re-recording anything.
+	if (bLateLatchCamera && ViewLatch && ViewLatch())
+	{
+		for (FVulkanRenderer* Renderer : Renderers)
+		{
+			if (Renderer != nullptr)
+			{
+				Renderer->LatchView();
+			}
+		}
+	}
+
+	FVulkanSwapchain* Swapchain = Viewport->GetSwapchain();
+	assert(Swapchain != nullptr);
+
+	// An offscreen swapchain neither signals the acquire semaphore nor waits on the present one.
+	const bool bPresents = Swapchain->IsOffscreen() == false;
+
 	VkSemaphore WaitSemaphores[] = { ImageAcquiredSemaphores[CurrentFrame] };
 	VkPipelineStageFlags WaitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
 
-	VkSemaphore SignalSemaphores[] = { RenderFinishedSemaphores[CurrentFrame] };
+	VkSemaphore SignalSemaphores[] = { FrameTimeline, RenderFinishedSemaphores[CurrentFrame] };
+
+	const uint64_t SignalValue = GetRecordingTimelineValue();
+
+	// Binary semaphores ignore their entry in the value arrays.
+	uint64_t WaitValues[] = { 0 };
+	uint64_t SignalValues[] = { SignalValue, 0 };
+
+	const uint32_t WaitSemaphoreCount = bPresents ? 1 : 0;
+	const uint32_t SignalSemaphoreCount = bPresents ? 2 : 1;
+
+	VkTimelineSemaphoreSubmitInfo TimelineSubmitInfo{};
+	TimelineSubmitInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+	TimelineSubmitInfo.waitSemaphoreValueCount = WaitSemaphoreCount;
+	TimelineSubmitInfo.pWaitSemaphoreValues = WaitValues;
+	TimelineSubmitInfo.signalSemaphoreValueCount = SignalSemaphoreCount;
+	TimelineSubmitInfo.pSignalSemaphoreValues = SignalValues;
 
 	VkSubmitInfo SubmitInfo{};
 	SubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-	SubmitInfo.waitSemaphoreCount = 1;
+	SubmitInfo.pNext = &TimelineSubmitInfo;
+	SubmitInfo.waitSemaphoreCount = WaitSemaphoreCount;
 	SubmitInfo.pWaitSemaphores = WaitSemaphores;
 	SubmitInfo.pWaitDstStageMask = WaitStages;
 	SubmitInfo.commandBufferCount = 1;
 	SubmitInfo.pCommandBuffers = &CommandBuffer;
-	SubmitInfo.signalSemaphoreCount = 1;
+	SubmitInfo.signalSemaphoreCount = SignalSemaphoreCount;
 	SubmitInfo.pSignalSemaphores = SignalSemaphores;
 
-	VK_ASSERT(vkQueueSubmit(GfxQueue, 1, &SubmitInfo, Fences[CurrentFrame]));
+	const FVulkanLatencyTracker::FClock::time_point SubmitTime = FVulkanLatencyTracker::FClock::now();
 
-	FVulkanSwapchain* Swapchain = Viewport->GetSwapchain();
-	assert(Swapchain != nullptr);
+	VK_ASSERT(vkQueueSubmit(GfxQueue, 1, &SubmitInfo, VK_NULL_HANDLE));
+
+	FVulkanScene* Scene = MeshRenderer->GetScene();
+	if (Scene != nullptr && LatencyTracker->IsEnabled())
+	{
+		LatencyTracker->RecordSubmit(SignalValue, Scene->GetCamera().InputSampleTime, SubmitTime, Viewport->GetPresentProfile());
+	}
+
+	FrameTimelineValue = SignalValue;
+	FrameSlotTimelineValues[CurrentFrame] = SignalValue;
 
 	VkResult PresentResult = Swapchain->Present(GfxQueue, PresentQueue, RenderFinishedSemaphores[CurrentFrame]);
-	if (PresentResult == VK_ERROR_OUT_OF_DATE_KHR || PresentResult == VK_SUBOPTIMAL_KHR || bFramebufferResized)
+	// A present profile switch only needs a new swapchain, so it takes the same path as a resize.
+	if (PresentResult == VK_ERROR_OUT_OF_DATE_KHR || PresentResult == VK_SUBOPTIMAL_KHR || bFramebufferResized || Viewport->IsPresentProfilePending())
 	{
-		bFramebufferResized = false;
-		RecreateSwapchain();
+		bFramebufferResized = RecreateSwapchain() == false;
 	}
 	else if (PresentResult != VK_SUCCESS)
 	{
 		throw std::runtime_error("Failed to present swap chain image.");
 	}
 
-	CurrentFrame = (CurrentFrame + 1) % GetMaxConcurrentFrames();
+	CurrentFrame = (CurrentFrame + 1) % MaxConcurrentFrames;
 }
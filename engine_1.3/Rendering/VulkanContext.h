@@ -4,10 +4,13 @@
 #include "glfw/glfw3.h"
 
 #include <vector>
+#include <functional>
 
 #include "VulkanObject.h"
+#include "VulkanObjectRegistry.h"
 
-#define MAX_CONCURRENT_FRAME 2
+// Re-samples the camera into the render scene right before submit. Returns false when nothing was latched.
+using FViewLatchCallback = std::function<bool()>;
 
 class FVulkanContext
 {
@@ -16,10 +19,12 @@ public:
 	virtual ~FVulkanContext();
 
 	GLFWwindow* GetWindow() const { return Window; }
+	bool IsHeadless() const { return Window == nullptr; }
 	VkInstance GetInstance() const { return Instance; }
 	VkSurfaceKHR GetSurface() const { return Surface; }
 	VkPhysicalDevice GetPhysicalDevice() const { return PhysicalDevice; }
 	VkDevice GetDevice() const { return Device; }
+	const VkPhysicalDeviceFeatures& GetEnabledFeatures() const { return EnabledFeatures; }
 	VkQueue GetGfxQueue() const { return GfxQueue; }
 	VkQueue GetPresentQueue() const { return PresentQueue; }
 	class FVulkanViewport* GetViewport() const { return Viewport; }
@@ -27,8 +32,27 @@ public:
 	const std::vector<VkCommandBuffer>& GetCommandBuffers() const { return CommandBuffers; }
 	VkCommandBuffer GetCommandBuffer() const { return CommandBuffers[CurrentFrame]; }
 	VkDescriptorPool GetDescriptorPool() const { return DescriptorPool; }
+	class FVulkanDescriptorAllocator* GetDescriptorAllocator() const { return DescriptorAllocator; }
+	class FVulkanShaderCache* GetShaderCache() const { return ShaderCache; }
+	class FVulkanSamplerCache* GetSamplerCache() const { return SamplerCache; }
+	class FVulkanPipelineCache* GetPipelineCache() const { return PipelineCache; }
+	class FVulkanPipelineLibrary* GetPipelineLibrary() const { return PipelineLibrary; }
+	class FVulkanGeometryPool* GetGeometryPool() const { return GeometryPool; }
+	class FVulkanReadback* GetReadback() const { return Readback; }
+	class FVulkanGpuProfiler* GetGpuProfiler() const { return GpuProfiler; }
+	class FVulkanLatencyTracker* GetLatencyTracker() const { return LatencyTracker; }
 	uint32_t GetCurrentFrame() const { return CurrentFrame; }
-	uint32_t GetMaxConcurrentFrames() const { return MAX_CONCURRENT_FRAME; }
+	uint32_t GetMaxConcurrentFrames() const { return MaxConcurrentFrames; }
+
+	// Frames are numbered by the value the frame timeline semaphore reaches once the GPU has finished them.
+	VkSemaphore GetFrameTimeline() const { return FrameTimeline; }
+	uint64_t GetFrameTimelineValue() const { return FrameTimelineValue; }
+	uint64_t GetRecordingTimelineValue() const { return FrameTimelineValue + 1; }
+	uint64_t GetCompletedTimelineValue() const;
+	void WaitForTimelineValue(uint64_t InValue) const;
+
+	bool IsLateLatchEnabled() const { return bLateLatchCamera; }
+	void SetViewLatch(const FViewLatchCallback& InViewLatch) { ViewLatch = InViewLatch; }
 
 	bool IsFramebufferResized() const { return bFramebufferResized; }
 	void SetFramebufferResized(bool InbFramebufferResized) { bFramebufferResized = InbFramebufferResized; }
@@ -42,18 +66,33 @@ public:
 	T* CreateObject()
 	{
 		T* NewObject = new T(this);
-		LiveObjects.push_back(static_cast<FVulkanObject*>(NewObject));
+		ObjectRegistry.Register(static_cast<FVulkanObject*>(NewObject));
 		return NewObject;
 	}
 	void DestroyObject(FVulkanObject* InObject);
-	bool IsValidObject(FVulkanObject* InObject);
+
+	// Destroys InObject once every frame submitted so far has finished on the GPU, for objects that
+	// in-flight command buffers may still reference.
+	void RetireObject(FVulkanObject* InObject);
+	bool IsValidObject(FVulkanObject* InObject) const;
+	bool IsValidObject(FVulkanObjectHandle InHandle) const;
+
+	template<typename T = FVulkanObject>
+	T* ResolveObject(FVulkanObjectHandle InHandle) const
+	{
+		return static_cast<T*>(ObjectRegistry.Resolve(InHandle));
+	}
 
 public:
 	void Render();
-	void BeginRender();
+
+	// Returns false when there is no swapchain image to render into, e.g. while the window is minimized.
+	bool BeginRender();
 	void EndRender();
 
 protected:
+	const std::vector<const char*>& GetRequiredDeviceExtensions() const;
+
 	void CreateInstance();
 	void SetupDebugMessenger();
 	void CreateSurface();
@@ -63,12 +102,22 @@ protected:
 	void CreateCommandBuffers();
 	void CreateSyncObjects();
 	void CreateDescriptorPool();
+	void CreateDescriptorAllocator();
+	void CreateShaderCache();
+	void CreateSamplerCache();
+	void CreatePipelineCache();
+	void CreatePipelineLibrary();
+	void CreateGeometryPool();
 	void CreateViewport();
+	void CreateReadback();
+	void CreateGpuProfiler();
+	void CreateLatencyTracker();
 	void CreateRenderers();
 
 	void CreateFramebuffers();
 
-	void RecreateSwapchain();
+	bool RecreateSwapchain();
+	void DestroyRetiredObjects();
 
 protected:
 	GLFWwindow* Window;
@@ -79,6 +128,7 @@ protected:
 
 	VkPhysicalDevice PhysicalDevice;
 	VkDevice Device;
+	VkPhysicalDeviceFeatures EnabledFeatures;
 
 	VkQueue GfxQueue;
 	VkQueue PresentQueue;
@@ -95,15 +145,44 @@ protected:
 
 	std::vector<VkCommandBuffer> CommandBuffers;
 
+	// Only ImGui still allocates from this pool; the renderers go through the descriptor allocator.
 	VkDescriptorPool DescriptorPool;
+	class FVulkanDescriptorAllocator* DescriptorAllocator;
+
+	class FVulkanShaderCache* ShaderCache;
+	class FVulkanSamplerCache* SamplerCache;
+	class FVulkanPipelineCache* PipelineCache;
+	class FVulkanPipelineLibrary* PipelineLibrary;
+
+	class FVulkanGeometryPool* GeometryPool;
+	class FVulkanReadback* Readback;
+	class FVulkanGpuProfiler* GpuProfiler;
+	class FVulkanLatencyTracker* LatencyTracker;
+
+	bool bLateLatchCamera;
+	FViewLatchCallback ViewLatch;
 
 	std::vector<VkSemaphore> ImageAcquiredSemaphores;
 	std::vector<VkSemaphore> RenderFinishedSemaphores;
-	std::vector<VkFence> Fences;
+
+	// A single timeline semaphore replaces the per-frame fences. Each frame slot remembers the value its
+	// last submission signals, so the CPU only waits for the one frame whose resources it is about to reuse.
+	VkSemaphore FrameTimeline;
+	uint64_t FrameTimelineValue;
+	std::vector<uint64_t> FrameSlotTimelineValues;
 
 	uint32_t CurrentFrame;
+	uint32_t MaxConcurrentFrames;
 
 	bool bFramebufferResized = false;
 
-	std::vector<FVulkanObject*> LiveObjects;
+	// Held by handle, so an object destroyed some other way meanwhile (e.g. at teardown) is skipped.
+	struct FRetiredObject
+	{
+		FVulkanObjectHandle Object;
+		uint64_t TimelineValue;
+	};
+	std::vector<FRetiredObject> RetiredObjects;
+
+	FVulkanObjectRegistry ObjectRegistry;
 };
@@ -0,0 +1,748 @@
+#include "VulkanCullingPass.h"
+#include "VulkanContext.h"
+#include "VulkanHelpers.h"
+#include "VulkanDescriptorAllocator.h"
+#include "VulkanBuffer.h"
+#include "VulkanPipeline.h"
+#include "VulkanShader.h"
+#include "VulkanShaderCache.h"
+
+#include "VulkanNullBackend.h"
+
+#include "Config.h"
+
+#include <array>
+#include <algorithm>
+#include <vector>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+static const uint32_t CullingGroupSize = 64;
+static const uint32_t ScatterGroupSize = 64;
+static const uint32_t MinDeltaCapacity = 64;
+
+static const std::vector<VkDescriptorType> CullingDescriptorTypes =
+{
+	VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+	VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+	VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+	VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+	VK_DESCRIPTOR_TYPE_STORAGE_BUFFER
+};
+
+static const std::vector<VkDescriptorType> ScatterDescriptorTypes =
+{
+	VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+	VK_DESCRIPTOR_TYPE_STORAGE_BUFFER
+};
+
+struct FCullingObject
+{
+	alignas(16) glm::vec4 ModelRows[3];
+	alignas(4) uint32_t MeshIndex;
+	alignas(4) uint32_t Padding[3];
+};
+
+struct FCullingMeshInfo
+{
+	alignas(16) glm::vec4 BoundingSphere;
+	alignas(16) glm::vec4 LodDistances;
+	alignas(4) uint32_t FirstCommand;
+	alignas(4) uint32_t NumLods;
+	alignas(4) uint32_t Padding[2];
+};
+
+struct FCullingBufferObject
+{
+	alignas(16) glm::vec4 CameraPosition;
+	alignas(16) glm::vec4 FrustumPlanes[static_cast<uint32_t>(ECullingView::Count) * 6];
+	alignas(4) uint32_t NumObjects;
+	alignas(4) uint32_t NumCommandsPerView;
+};
+
+struct FScatterPushConstants
+{
+	uint32_t NumDeltas;
+};
+
+static void PackModelRows(const glm::mat4& InModel, glm::vec4 OutRows[3])
+{
+	for (uint32_t Row = 0; Row < 3; ++Row)
+	{
+		OutRows[Row] = glm::vec4(InModel[0][Row], InModel[1][Row], InModel[2][Row], InModel[3][Row]);
+	}
+}
+
+FVulkanCullingPass::FVulkanCullingPass(FVulkanContext* InContext)
+	: FVulkanObject(InContext)
+	, DescriptorSetLayout(VK_NULL_HANDLE)
+	, DescriptorUpdateTemplate(VK_NULL_HANDLE)
+	, Pipeline(nullptr)
+	, ScatterDescriptorSetLayout(VK_NULL_HANDLE)
+	, ScatterDescriptorUpdateTemplate(VK_NULL_HANDLE)
+	, ScatterPipeline(nullptr)
+	, SceneBuffer(nullptr)
+	, MeshInfoBuffer(nullptr)
+	, CommandTemplateBuffer(nullptr)
+	, bGpuCulling(true)
+	, NumObjects(0)
+	, NumInstanceSlots(0)
+	, NumCommandsPerView(0)
+{
+	GConfig->Get("GpuCulling", bGpuCulling);
+	if (VkNull::IsEnabled())
+	{
+		bGpuCulling = false;
+	}
+
+	if (bGpuCulling == false)
+	{
+		return;
+	}
+
+	DescriptorSetLayout = CreateDescriptorSetLayout(CullingDescriptorTypes);
+	DescriptorUpdateTemplate = CreateDescriptorUpdateTemplate(DescriptorSetLayout, CullingDescriptorTypes);
+	Pipeline = CreatePipeline("cull.comp.spv", DescriptorSetLayout, 0);
+
+	ScatterDescriptorSetLayout = CreateDescriptorSetLayout(ScatterDescriptorTypes);
+	ScatterDescriptorUpdateTemplate = CreateDescriptorUpdateTemplate(ScatterDescriptorSetLayout, ScatterDescriptorTypes);
+	ScatterPipeline = CreatePipeline("scatter.comp.spv", ScatterDescriptorSetLayout, sizeof(FScatterPushConstants));
+}
+
+void FVulkanCullingPass::Destroy()
+{
+	VkDevice Device = Context->GetDevice();
+
+	DestroyFrameResources();
+
+	for (FVulkanPipeline** ComputePipeline : { &Pipeline, &ScatterPipeline })
+	{
+		if (*ComputePipeline != nullptr)
+		{
+			Context->GetShaderCache()->Release((*ComputePipeline)->GetComputeShader());
+			Context->DestroyObject(*ComputePipeline);
+			*ComputePipeline = nullptr;
+		}
+	}
+
+	for (VkDescriptorUpdateTemplate* UpdateTemplate : { &DescriptorUpdateTemplate, &ScatterDescriptorUpdateTemplate })
+	{
+		if (*UpdateTemplate != VK_NULL_HANDLE)
+		{
+			vkDestroyDescriptorUpdateTemplate(Device, *UpdateTemplate, nullptr);
+			*UpdateTemplate = VK_NULL_HANDLE;
+		}
+	}
+
+	for (VkDescriptorSetLayout* Layout : { &DescriptorSetLayout, &ScatterDescriptorSetLayout })
+	{
+		if (*Layout != VK_NULL_HANDLE)
+		{
+			vkDestroyDescriptorSetLayout(Device, *Layout, nullptr);
+			*Layout = VK_NULL_HANDLE;
+		}
+	}
+}
+
+VkDescriptorSetLayout FVulkanCullingPass::CreateDescriptorSetLayout(const std::vector<VkDescriptorType>& InDescriptorTypes)
+{
+	VkDevice Device = Context->GetDevice();
+
+	std::vector<VkDescriptorSetLayoutBinding> Bindings(InDescriptorTypes.size());
+	for (uint32_t Idx = 0; Idx < Bindings.size(); ++Idx)
+	{
+		Bindings[Idx].binding = Idx;
+		Bindings[Idx].descriptorCount = 1;
+		Bindings[Idx].descriptorType = InDescriptorTypes[Idx];
+		Bindings[Idx].pImmutableSamplers = nullptr;
+		Bindings[Idx].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	}
+
+	VkDescriptorSetLayoutCreateInfo DescriptorSetLayoutCI{};
+	DescriptorSetLayoutCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	DescriptorSetLayoutCI.bindingCount = static_cast<uint32_t>(Bindings.size());
+	DescriptorSetLayoutCI.pBindings = Bindings.data();
+
+	VkDescriptorSetLayout Layout = VK_NULL_HANDLE;
+	VK_ASSERT(vkCreateDescriptorSetLayout(Device, &DescriptorSetLayoutCI, nullptr, &Layout));
+
+	return Layout;
+}
+
+VkDescriptorUpdateTemplate FVulkanCullingPass::CreateDescriptorUpdateTemplate(VkDescriptorSetLayout InLayout, const std::vector<VkDescriptorType>& InDescriptorTypes)
+{
+	// Every binding is a single buffer, so the template reads a tightly packed array of buffer infos.
+	std::vector<VkDescriptorUpdateTemplateEntry> Entries(InDescriptorTypes.size());
+	for (uint32_t Idx = 0; Idx < Entries.size(); ++Idx)
+	{
+		Entries[Idx] = Vk::GetDescriptorUpdateTemplateEntry(Idx, InDescriptorTypes[Idx], Idx * sizeof(VkDescriptorBufferInfo));
+	}
+
+	return Vk::CreateDescriptorUpdateTemplate(Context->GetDevice(), InLayout, Entries);
+}
+
+FVulkanPipeline* FVulkanCullingPass::CreatePipeline(const std::string& InShaderName, VkDescriptorSetLayout InDescriptorSetLayout, uint32_t InPushConstantSize)
+{
+	std::string ShaderDirectory;
+	GConfig->Get("ShaderDirectory", ShaderDirectory);
+
+	FVulkanShader* CS = Context->GetShaderCache()->Acquire(ShaderDirectory + InShaderName);
+
+	FVulkanPipeline* ComputePipeline = Context->CreateObject<FVulkanPipeline>();
+	ComputePipeline->SetComputeShader(CS);
+
+	VkPushConstantRange PushConstantRange{};
+	PushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	PushConstantRange.offset = 0;
+	PushConstantRange.size = InPushConstantSize;
+
+	VkPipelineLayoutCreateInfo PipelineLayoutCI{};
+	PipelineLayoutCI.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	PipelineLayoutCI.setLayoutCount = 1;
+	PipelineLayoutCI.pSetLayouts = &InDescriptorSetLayout;
+	PipelineLayoutCI.pushConstantRangeCount = InPushConstantSize > 0 ? 1 : 0;
+	PipelineLayoutCI.pPushConstantRanges = InPushConstantSize > 0 ? &PushConstantRange : nullptr;
+
+	ComputePipeline->CreateLayout(PipelineLayoutCI);
+
+	VkComputePipelineCreateInfo PipelineCI{};
+	PipelineCI.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	PipelineCI.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	PipelineCI.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	PipelineCI.stage.module = CS->GetModule();
+	PipelineCI.stage.pName = "main";
+	PipelineCI.layout = ComputePipeline->GetLayout();
+	PipelineCI.basePipelineHandle = VK_NULL_HANDLE;
+
+	ComputePipeline->CreatePipeline(PipelineCI);
+
+	return ComputePipeline;
+}
+
+void FVulkanCullingPass::Build(const std::vector<FCullingMeshDesc>& InMeshes)
+{
+	DestroyFrameResources();
+
+	Meshes.resize(InMeshes.size());
+
+	NumObjects = 0;
+	NumInstanceSlots = 0;
+	NumCommandsPerView = 0;
+
+	PendingDeltas.clear();
+	PendingDeltaSlots.clear();
+
+	std::vector<FCullingMeshInfo> MeshInfos(InMeshes.size());
+	std::vector<FCullingObject> Objects;
+
+	for (uint32_t MeshIdx = 0; MeshIdx < InMeshes.size(); ++MeshIdx)
+	{
+		const FCullingMeshDesc& Desc = InMeshes[MeshIdx];
+		if (Desc.Lods.size() > MaxLods)
+		{
+			throw std::runtime_error("Too many levels of detail for culling.");
+		}
+
+		FMeshEntry& Entry = Meshes[MeshIdx];
+		Entry.FirstObject = NumObjects;
+		Entry.FirstCommand = NumCommandsPerView;
+		Entry.NumLods = static_cast<uint32_t>(Desc.Lods.size());
+		Entry.BoundingSphere = Desc.BoundingSphere;
+		Entry.LodDistances = Desc.LodDistances;
+
+		FCullingMeshInfo& MeshInfo = MeshInfos[MeshIdx];
+		MeshInfo.BoundingSphere = Desc.BoundingSphere;
+		MeshInfo.LodDistances = Desc.LodDistances;
+		MeshInfo.FirstCommand = Entry.FirstCommand;
+		MeshInfo.NumLods = Entry.NumLods;
+
+		for (uint32_t Idx = 0; Idx < Desc.NumInstances; ++Idx)
+		{
+			FCullingObject Object{};
+			PackModelRows(glm::mat4(1.0f), Object.ModelRows);
+			Object.MeshIndex = MeshIdx;
+			Objects.push_back(Object);
+		}
+
+		NumObjects += Desc.NumInstances;
+		NumCommandsPerView += Entry.NumLods;
+	}
+
+	// Every (view, mesh, lod) triple owns a region large enough for all instances of the mesh,
+	// so the compute shader can append into it without overflowing into its neighbours.
+	const uint32_t NumViews = static_cast<uint32_t>(ECullingView::Count);
+
+	std::vector<VkDrawIndexedIndirectCommand> Commands(NumViews * NumCommandsPerView);
+
+	uint32_t FirstInstance = 0;
+	for (uint32_t View = 0; View < NumViews; ++View)
+	{
+		for (uint32_t MeshIdx = 0; MeshIdx < InMeshes.size(); ++MeshIdx)
+		{
+			const FCullingMeshDesc& Desc = InMeshes[MeshIdx];
+
+			for (uint32_t LodIdx = 0; LodIdx < Desc.Lods.size(); ++LodIdx)
+			{
+				VkDrawIndexedIndirectCommand& Command = Commands[View * NumCommandsPerView + Meshes[MeshIdx].FirstCommand + LodIdx];
+				Command.indexCount = Desc.Lods[LodIdx].IndexCount;
+				Command.instanceCount = 0;
+				Command.firstIndex = Desc.Lods[LodIdx].FirstIndex;
+				Command.vertexOffset = Desc.Lods[LodIdx].VertexOffset;
+				Command.firstInstance = FirstInstance;
+
+				FirstInstance += Desc.NumInstances;
+			}
+		}
+	}
+	NumInstanceSlots = FirstInstance;
+
+	if (NumObjects == 0)
+	{
+		return;
+	}
+
+	if (bGpuCulling == false)
+	{
+		ObjectMeshes.resize(NumObjects);
+		ObjectInstances.resize(NumObjects);
+		ObjectSpheres.Resize(NumObjects);
+		for (uint32_t ObjectIdx = 0; ObjectIdx < NumObjects; ++ObjectIdx)
+		{
+			ObjectMeshes[ObjectIdx] = Objects[ObjectIdx].MeshIndex;
+			std::copy(std::begin(Objects[ObjectIdx].ModelRows), std::end(Objects[ObjectIdx].ModelRows), ObjectInstances[ObjectIdx].ModelRows);
+			UpdateObjectSphere(ObjectIdx);
+		}
+
+		CommandTemplates = std::move(Commands);
+
+		CreateFrameResources();
+		return;
+	}
+
+	SceneBuffer = Context->CreateObject<FVulkanBuffer>();
+	SceneBuffer->SetUsage(VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+	SceneBuffer->SetProperties(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	SceneBuffer->Load((uint8_t*)Objects.data(), sizeof(FCullingObject) * Objects.size());
+
+	PendingDeltaSlots.resize(NumObjects, UINT32_MAX);
+
+	MeshInfoBuffer = Context->CreateObject<FVulkanBuffer>();
+	MeshInfoBuffer->SetUsage(VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+	MeshInfoBuffer->SetProperties(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	MeshInfoBuffer->Load((uint8_t*)MeshInfos.data(), sizeof(FCullingMeshInfo) * MeshInfos.size());
+
+	CommandTemplateBuffer = Context->CreateObject<FVulkanBuffer>();
+	CommandTemplateBuffer->SetUsage(VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
+	CommandTemplateBuffer->SetProperties(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	CommandTemplateBuffer->Load((uint8_t*)Commands.data(), sizeof(VkDrawIndexedIndirectCommand) * Commands.size());
+
+	CreateFrameResources();
+	UpdateDescriptorSets();
+}
+
+void FVulkanCullingPass::CreateFrameResources()
+{
+	FVulkanDescriptorAllocator* DescriptorAllocator = Context->GetDescriptorAllocator();
+
+	const uint32_t MaxConcurrentFrames = Context->GetMaxConcurrentFrames();
+	const uint32_t NumCommands = NumCommandsPerView * static_cast<uint32_t>(ECullingView::Count);
+
+	FrameResources.resize(MaxConcurrentFrames);
+
+	if (bGpuCulling == false)
+	{
+		// The CPU culler writes each frame's commands and instances in place; the frame's fence has been
+		// waited on by then, so nothing on the GPU still reads them.
+		for (FFrameResources& Frame : FrameResources)
+		{
+			Frame.IndirectBuffer = Context->CreateObject<FVulkanBuffer>();
+			Frame.IndirectBuffer->SetUsage(VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT);
+			Frame.IndirectBuffer->SetProperties(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+			Frame.IndirectBuffer->Allocate(sizeof(VkDrawIndexedIndirectCommand) * NumCommands);
+			Frame.IndirectBuffer->Map();
+
+			Frame.InstanceBuffer = Context->CreateObject<FVulkanBuffer>();
+			Frame.InstanceBuffer->SetUsage(VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+			Frame.InstanceBuffer->SetProperties(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+			Frame.InstanceBuffer->Allocate(sizeof(FInstanceBuffer) * NumInstanceSlots);
+			Frame.InstanceBuffer->Map();
+		}
+		return;
+	}
+
+	for (FFrameResources& Frame : FrameResources)
+	{
+		Frame.UniformBuffer = Context->CreateObject<FVulkanBuffer>();
+		Frame.UniformBuffer->SetUsage(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
+		Frame.UniformBuffer->SetProperties(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		Frame.UniformBuffer->Allocate(sizeof(FCullingBufferObject));
+		Frame.UniformBuffer->Map();
+
+		Frame.IndirectBuffer = Context->CreateObject<FVulkanBuffer>();
+		Frame.IndirectBuffer->SetUsage(VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT);
+		Frame.IndirectBuffer->SetProperties(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		Frame.IndirectBuffer->Allocate(sizeof(VkDrawIndexedIndirectCommand) * NumCommands);
+
+		Frame.InstanceBuffer = Context->CreateObject<FVulkanBuffer>();
+		Frame.InstanceBuffer->SetUsage(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+		Frame.InstanceBuffer->SetProperties(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		Frame.InstanceBuffer->Allocate(sizeof(FInstanceBuffer) * NumInstanceSlots);
+
+		Frame.DescriptorSet = DescriptorAllocator->Allocate(DescriptorSetLayout);
+		Frame.ScatterDescriptorSet = DescriptorAllocator->Allocate(ScatterDescriptorSetLayout);
+
+		ReserveDeltaBuffer(Frame, MinDeltaCapacity);
+	}
+}
+
+void FVulkanCullingPass::ReserveDeltaBuffer(FFrameResources& InFrame, uint32_t InNumDeltas)
+{
+	if (InFrame.DeltaBuffer != nullptr && InFrame.DeltaCapacity >= InNumDeltas)
+	{
+		return;
+	}
+
+	// Only the current frame's buffer is ever resized, and its fence has already been waited on.
+	Context->DestroyObject(InFrame.DeltaBuffer);
+
+	InFrame.DeltaCapacity = std::max(InNumDeltas, InFrame.DeltaCapacity * 2);
+
+	InFrame.DeltaBuffer = Context->CreateObject<FVulkanBuffer>();
+	InFrame.DeltaBuffer->SetUsage(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+	InFrame.DeltaBuffer->SetProperties(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+	InFrame.DeltaBuffer->Allocate(sizeof(FObjectDelta) * InFrame.DeltaCapacity);
+	InFrame.DeltaBuffer->Map();
+
+	std::array<VkDescriptorBufferInfo, 2> BufferInfos{};
+	BufferInfos[0] = { InFrame.DeltaBuffer->GetHandle(), 0, VK_WHOLE_SIZE };
+	BufferInfos[1] = { SceneBuffer->GetHandle(), 0, VK_WHOLE_SIZE };
+
+	vkUpdateDescriptorSetWithTemplate(Context->GetDevice(), InFrame.ScatterDescriptorSet, ScatterDescriptorUpdateTemplate, BufferInfos.data());
+}
+
+void FVulkanCullingPass::UpdateDescriptorSets()
+{
+	VkDevice Device = Context->GetDevice();
+
+	for (const FFrameResources& Frame : FrameResources)
+	{
+		std::array<VkDescriptorBufferInfo, 5> BufferInfos{};
+		BufferInfos[0] = { Frame.UniformBuffer->GetHandle(), 0, sizeof(FCullingBufferObject) };
+		BufferInfos[1] = { SceneBuffer->GetHandle(), 0, VK_WHOLE_SIZE };
+		BufferInfos[2] = { MeshInfoBuffer->GetHandle(), 0, VK_WHOLE_SIZE };
+		BufferInfos[3] = { Frame.IndirectBuffer->GetHandle(), 0, VK_WHOLE_SIZE };
+		BufferInfos[4] = { Frame.InstanceBuffer->GetHandle(), 0, VK_WHOLE_SIZE };
+
+		vkUpdateDescriptorSetWithTemplate(Device, Frame.DescriptorSet, DescriptorUpdateTemplate, BufferInfos.data());
+	}
+}
+
+void FVulkanCullingPass::DestroyFrameResources()
+{
+	FVulkanDescriptorAllocator* DescriptorAllocator = Context->GetDescriptorAllocator();
+
+	for (FFrameResources& Frame : FrameResources)
+	{
+		Context->DestroyObject(Frame.UniformBuffer);
+		Context->DestroyObject(Frame.IndirectBuffer);
+		Context->DestroyObject(Frame.InstanceBuffer);
+		Context->DestroyObject(Frame.DeltaBuffer);
+
+		if (Frame.DescriptorSet != VK_NULL_HANDLE)
+		{
+			DescriptorAllocator->Free(Frame.DescriptorSet);
+		}
+
+		if (Frame.ScatterDescriptorSet != VK_NULL_HANDLE)
+		{
+			DescriptorAllocator->Free(Frame.ScatterDescriptorSet);
+		}
+	}
+	FrameResources.clear();
+
+	Context->DestroyObject(SceneBuffer);
+	SceneBuffer = nullptr;
+
+	Context->DestroyObject(MeshInfoBuffer);
+	MeshInfoBuffer = nullptr;
+
+	Context->DestroyObject(CommandTemplateBuffer);
+	CommandTemplateBuffer = nullptr;
+
+	ObjectMeshes.clear();
+	ObjectInstances.clear();
+	ObjectSpheres.Resize(0);
+	CommandTemplates.clear();
+	FrameCommands.clear();
+}
+
+void FVulkanCullingPass::SetObjectTransform(uint32_t InObjectIndex, const glm::mat4& InModel)
+{
+	if (InObjectIndex >= NumObjects)
+	{
+		return;
+	}
+
+	if (bGpuCulling == false)
+	{
+		PackModelRows(InModel, ObjectInstances[InObjectIndex].ModelRows);
+		UpdateObjectSphere(InObjectIndex);
+		return;
+	}
+
+	uint32_t& Slot = PendingDeltaSlots[InObjectIndex];
+	if (Slot == UINT32_MAX)
+	{
+		Slot = static_cast<uint32_t>(PendingDeltas.size());
+
+		FObjectDelta Delta{};
+		Delta.ObjectIndex = InObjectIndex;
+		PendingDeltas.push_back(Delta);
+	}
+
+	PackModelRows(InModel, PendingDeltas[Slot].ModelRows);
+}
+
+void FVulkanCullingPass::ApplyObjectDeltas(VkCommandBuffer InCommandBuffer)
+{
+	if (PendingDeltas.empty())
+	{
+		return;
+	}
+
+	FFrameResources& Frame = FrameResources[Context->GetCurrentFrame()];
+
+	const uint32_t NumDeltas = static_cast<uint32_t>(PendingDeltas.size());
+
+	ReserveDeltaBuffer(Frame, NumDeltas);
+	memcpy(Frame.DeltaBuffer->GetMappedAddress(), PendingDeltas.data(), sizeof(FObjectDelta) * NumDeltas);
+
+	for (const FObjectDelta& Delta : PendingDeltas)
+	{
+		PendingDeltaSlots[Delta.ObjectIndex] = UINT32_MAX;
+	}
+	PendingDeltas.clear();
+
+	// The scene buffer is shared by every frame in flight, so wait for earlier culling reads
+	// before overwriting it.
+	VkBufferMemoryBarrier SceneBarrier{};
+	SceneBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	SceneBarrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	SceneBarrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	SceneBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	SceneBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	SceneBarrier.buffer = SceneBuffer->GetHandle();
+	SceneBarrier.offset = 0;
+	SceneBarrier.size = VK_WHOLE_SIZE;
+
+	vkCmdPipelineBarrier(
+		InCommandBuffer,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		0,
+		0, nullptr,
+		1, &SceneBarrier,
+		0, nullptr);
+
+	FScatterPushConstants PushConstants{};
+	PushConstants.NumDeltas = NumDeltas;
+
+	vkCmdBindPipeline(InCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, ScatterPipeline->GetPipeline());
+	vkCmdBindDescriptorSets(InCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, ScatterPipeline->GetLayout(), 0, 1, &Frame.ScatterDescriptorSet, 0, nullptr);
+	vkCmdPushConstants(InCommandBuffer, ScatterPipeline->GetLayout(), VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(FScatterPushConstants), &PushConstants);
+	vkCmdDispatch(InCommandBuffer, (NumDeltas + ScatterGroupSize - 1) / ScatterGroupSize, 1, 1);
+
+	SceneBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	SceneBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+	vkCmdPipelineBarrier(
+		InCommandBuffer,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		0,
+		0, nullptr,
+		1, &SceneBarrier,
+		0, nullptr);
+}
+
+void FVulkanCullingPass::Dispatch(
+	VkCommandBuffer InCommandBuffer,
+	const glm::vec3& InCameraPosition,
+	const FVulkanFrustum& InCameraFrustum,
+	const FVulkanFrustum& InShadowFrustum)
+{
+	if (NumObjects == 0)
+	{
+		return;
+	}
+
+	if (bGpuCulling == false)
+	{
+		CullOnCpu(InCameraPosition, InCameraFrustum, InShadowFrustum);
+		return;
+	}
+
+	FFrameResources& Frame = FrameResources[Context->GetCurrentFrame()];
+
+	FCullingBufferObject CBO{};
+	CBO.CameraPosition = glm::vec4(InCameraPosition, 1.0f);
+	for (uint32_t Idx = 0; Idx < 6; ++Idx)
+	{
+		CBO.FrustumPlanes[static_cast<uint32_t>(ECullingView::Camera) * 6 + Idx] = InCameraFrustum.Planes[Idx];
+		CBO.FrustumPlanes[static_cast<uint32_t>(ECullingView::Shadow) * 6 + Idx] = InShadowFrustum.Planes[Idx];
+	}
+	CBO.NumObjects = NumObjects;
+	CBO.NumCommandsPerView = NumCommandsPerView;
+
+	memcpy(Frame.UniformBuffer->GetMappedAddress(), &CBO, sizeof(FCullingBufferObject));
+
+	ApplyObjectDeltas(InCommandBuffer);
+
+	VkDeviceSize CommandsSize = sizeof(VkDrawIndexedIndirectCommand) * NumCommandsPerView * static_cast<uint32_t>(ECullingView::Count);
+
+	VkBufferCopy CopyRegion{};
+	CopyRegion.srcOffset = 0;
+	CopyRegion.dstOffset = 0;
+	CopyRegion.size = CommandsSize;
+	vkCmdCopyBuffer(InCommandBuffer, CommandTemplateBuffer->GetHandle(), Frame.IndirectBuffer->GetHandle(), 1, &CopyRegion);
+
+	VkBufferMemoryBarrier ResetBarrier{};
+	ResetBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	ResetBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	ResetBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	ResetBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	ResetBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	ResetBarrier.buffer = Frame.IndirectBuffer->GetHandle();
+	ResetBarrier.offset = 0;
+	ResetBarrier.size = VK_WHOLE_SIZE;
+
+	vkCmdPipelineBarrier(
+		InCommandBuffer,
+		VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		0,
+		0, nullptr,
+		1, &ResetBarrier,
+		0, nullptr);
+
+	vkCmdBindPipeline(InCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, Pipeline->GetPipeline());
+	vkCmdBindDescriptorSets(InCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, Pipeline->GetLayout(), 0, 1, &Frame.DescriptorSet, 0, nullptr);
+	vkCmdDispatch(InCommandBuffer, (NumObjects + CullingGroupSize - 1) / CullingGroupSize, 1, 1);
+
+	std::array<VkBufferMemoryBarrier, 2> OutputBarriers{};
+	OutputBarriers[0].sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	OutputBarriers[0].srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	OutputBarriers[0].dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+	OutputBarriers[0].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	OutputBarriers[0].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	OutputBarriers[0].buffer = Frame.IndirectBuffer->GetHandle();
+	OutputBarriers[0].offset = 0;
+	OutputBarriers[0].size = VK_WHOLE_SIZE;
+
+	OutputBarriers[1] = OutputBarriers[0];
+	OutputBarriers[1].dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+	OutputBarriers[1].buffer = Frame.InstanceBuffer->GetHandle();
+
+	vkCmdPipelineBarrier(
+		InCommandBuffer,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+		0,
+		0, nullptr,
+		static_cast<uint32_t>(OutputBarriers.size()), OutputBarriers.data(),
+		0, nullptr);
+}
+
+void FVulkanCullingPass::UpdateObjectSphere(uint32_t InObjectIndex)
+{
+	// Same bounds as cull.comp: the mesh sphere moved into world space and grown by the largest axis scale.
+	const glm::vec4* Rows = ObjectInstances[InObjectIndex].ModelRows;
+	const glm::vec4& Sphere = Meshes[ObjectMeshes[InObjectIndex]].BoundingSphere;
+
+	glm::vec4 LocalCenter(glm::vec3(Sphere), 1.0f);
+	glm::vec3 AxisX(Rows[0].x, Rows[1].x, Rows[2].x);
+	glm::vec3 AxisY(Rows[0].y, Rows[1].y, Rows[2].y);
+	glm::vec3 AxisZ(Rows[0].z, Rows[1].z, Rows[2].z);
+	float MaxScaleSq = std::max(glm::dot(AxisX, AxisX), std::max(glm::dot(AxisY, AxisY), glm::dot(AxisZ, AxisZ)));
+
+	ObjectSpheres.CenterX[InObjectIndex] = glm::dot(Rows[0], LocalCenter);
+	ObjectSpheres.CenterY[InObjectIndex] = glm::dot(Rows[1], LocalCenter);
+	ObjectSpheres.CenterZ[InObjectIndex] = glm::dot(Rows[2], LocalCenter);
+	ObjectSpheres.Radius[InObjectIndex] = Sphere.w * std::sqrt(MaxScaleSq);
+}
+
+void FVulkanCullingPass::CullOnCpu(const glm::vec3& InCameraPosition, const FVulkanFrustum& InCameraFrustum, const FVulkanFrustum& InShadowFrustum)
+{
+	const uint32_t NumViews = static_cast<uint32_t>(ECullingView::Count);
+
+	const FVulkanFrustum* Frustums[NumViews] = {};
+	Frustums[static_cast<uint32_t>(ECullingView::Camera)] = &InCameraFrustum;
+	Frustums[static_cast<uint32_t>(ECullingView::Shadow)] = &InShadowFrustum;
+
+	for (uint32_t View = 0; View < NumViews; ++View)
+	{
+		Visibility[View].resize(NumObjects);
+		Vk::CullSpheres(*Frustums[View], ObjectSpheres, NumObjects, Visibility[View].data());
+	}
+
+	FFrameResources& Frame = FrameResources[Context->GetCurrentFrame()];
+
+	FInstanceBuffer* Instances = reinterpret_cast<FInstanceBuffer*>(Frame.InstanceBuffer->GetMappedAddress());
+
+	FrameCommands = CommandTemplates;
+
+	for (uint32_t ObjectIdx = 0; ObjectIdx < NumObjects; ++ObjectIdx)
+	{
+		const FMeshEntry& Mesh = Meshes[ObjectMeshes[ObjectIdx]];
+
+		glm::vec3 Center(ObjectSpheres.CenterX[ObjectIdx], ObjectSpheres.CenterY[ObjectIdx], ObjectSpheres.CenterZ[ObjectIdx]);
+		float DistanceToCamera = glm::length(Center - InCameraPosition);
+
+		uint32_t Lod = 0;
+		for (uint32_t Idx = 0; Idx + 1 < Mesh.NumLods; ++Idx)
+		{
+			if (DistanceToCamera > Mesh.LodDistances[Idx])
+			{
+				Lod = Idx + 1;
+			}
+		}
+
+		for (uint32_t View = 0; View < NumViews; ++View)
+		{
+			if (Visibility[View][ObjectIdx] == 0)
+			{
+				continue;
+			}
+
+			VkDrawIndexedIndirectCommand& Command = FrameCommands[View * NumCommandsPerView + Mesh.FirstCommand + Lod];
+			Instances[Command.firstInstance + Command.instanceCount] = ObjectInstances[ObjectIdx];
+			++Command.instanceCount;
+		}
+	}
+
+	memcpy(Frame.IndirectBuffer->GetMappedAddress(), FrameCommands.data(), sizeof(VkDrawIndexedIndirectCommand) * FrameCommands.size());
+}
+
+FVulkanBuffer* FVulkanCullingPass::GetIndirectBuffer() const
+{
+	return FrameResources.empty() ? nullptr : FrameResources[Context->GetCurrentFrame()].IndirectBuffer;
+}
+
+FVulkanBuffer* FVulkanCullingPass::GetInstanceBuffer() const
+{
+	return FrameResources.empty() ? nullptr : FrameResources[Context->GetCurrentFrame()].InstanceBuffer;
+}
+
+VkDeviceSize FVulkanCullingPass::GetCommandOffset(ECullingView InView, uint32_t InMeshIndex) const
+{
+	uint32_t CommandIndex = static_cast<uint32_t>(InView) * NumCommandsPerView + Meshes[InMeshIndex].FirstCommand;
+	return sizeof(VkDrawIndexedIndirectCommand) * CommandIndex;
+}
+
+uint32_t FVulkanCullingPass::GetNumCommands(uint32_t InFirstMesh, uint32_t InNumMeshes) const
+{
+	if (InNumMeshes == 0)
+	{
+		return 0;
+	}
+
+	const FMeshEntry& LastMesh = Meshes[InFirstMesh + InNumMeshes - 1];
+	return LastMesh.FirstCommand + LastMesh.NumLods - Meshes[InFirstMesh].FirstCommand;
+}
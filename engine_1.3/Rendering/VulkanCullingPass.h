@@ -0,0 +1,164 @@
+#pragma once
+
+#include "VulkanObject.h"
+#include "VulkanBuffer.h"
+#include "VulkanFrustum.h"
+
+#include "vulkan/vulkan.h"
+#include "glm/glm.hpp"
+
+#include <vector>
+#include <string>
+
+enum class ECullingView : uint32_t
+{
+	Camera = 0,
+	Shadow = 1,
+	Count
+};
+
+// Affine model matrix stored as the first three rows of the 4x4 matrix, the last row being
+// (0, 0, 0, 1). Vertex shaders derive ModelView and the normal matrix from the view uniform.
+struct FInstanceBuffer
+{
+	alignas(16) glm::vec4 ModelRows[3];
+};
+
+struct FCullingMeshDesc
+{
+	uint32_t NumInstances = 0;
+
+	glm::vec4 BoundingSphere = glm::vec4(0.0f);
+
+	// Index ranges of each level of detail, finest first. LodDistances[Idx] is the camera distance
+	// beyond which Lods[Idx + 1] is selected.
+	struct FLod
+	{
+		uint32_t FirstIndex = 0;
+		uint32_t IndexCount = 0;
+		int32_t VertexOffset = 0;
+	};
+	std::vector<FLod> Lods;
+	glm::vec4 LodDistances = glm::vec4(0.0f);
+};
+
+// Culls every object against the camera and shadow frustums and builds the indirect draws of both views.
+// This normally runs as a compute pass. With GpuCulling turned off, or on the null backend where compute
+// shaders never run, the same commands and instance data are built with the SIMD sphere culler and written
+// straight into host visible buffers.
+class FVulkanCullingPass : public FVulkanObject
+{
+public:
+	static const uint32_t MaxLods = 4;
+
+	FVulkanCullingPass(class FVulkanContext* InContext);
+
+	virtual void Destroy() override;
+
+	void Build(const std::vector<FCullingMeshDesc>& InMeshes);
+
+	bool IsGpuCulling() const { return bGpuCulling; }
+	uint32_t GetNumObjects() const { return NumObjects; }
+	uint32_t GetFirstObject(uint32_t InMeshIndex) const { return Meshes[InMeshIndex].FirstObject; }
+
+	// Object transforms live in a persistent device-local scene buffer. Changes are queued here
+	// and scattered into it by a compute pass at the start of the next Dispatch. The CPU culler
+	// applies them right away instead.
+	void SetObjectTransform(uint32_t InObjectIndex, const glm::mat4& InModel);
+	uint32_t GetNumPendingTransforms() const { return static_cast<uint32_t>(PendingDeltas.size()); }
+
+	void Dispatch(
+		VkCommandBuffer InCommandBuffer,
+		const glm::vec3& InCameraPosition,
+		const FVulkanFrustum& InCameraFrustum,
+		const FVulkanFrustum& InShadowFrustum);
+
+	FVulkanBuffer* GetIndirectBuffer() const;
+	FVulkanBuffer* GetInstanceBuffer() const;
+
+	uint32_t GetNumLods(uint32_t InMeshIndex) const { return Meshes[InMeshIndex].NumLods; }
+	VkDeviceSize GetCommandOffset(ECullingView InView, uint32_t InMeshIndex) const;
+
+	// Commands of consecutive meshes are packed back to back within a view, so a run of meshes
+	// can be drawn with a single multi-draw.
+	uint32_t GetNumCommands(uint32_t InFirstMesh, uint32_t InNumMeshes) const;
+
+protected:
+	VkDescriptorSetLayout CreateDescriptorSetLayout(const std::vector<VkDescriptorType>& InDescriptorTypes);
+	VkDescriptorUpdateTemplate CreateDescriptorUpdateTemplate(VkDescriptorSetLayout InLayout, const std::vector<VkDescriptorType>& InDescriptorTypes);
+	class FVulkanPipeline* CreatePipeline(const std::string& InShaderName, VkDescriptorSetLayout InDescriptorSetLayout, uint32_t InPushConstantSize);
+	void CreateFrameResources();
+	void UpdateDescriptorSets();
+	void DestroyFrameResources();
+
+	struct FMeshEntry
+	{
+		uint32_t FirstObject = 0;
+		uint32_t FirstCommand = 0;
+		uint32_t NumLods = 0;
+
+		// Only kept for the CPU culler; the compute pass reads them from the mesh info buffer.
+		glm::vec4 BoundingSphere = glm::vec4(0.0f);
+		glm::vec4 LodDistances = glm::vec4(0.0f);
+	};
+
+	struct FObjectDelta
+	{
+		alignas(16) glm::vec4 ModelRows[3];
+		alignas(4) uint32_t ObjectIndex;
+		alignas(4) uint32_t Padding[3];
+	};
+
+	struct FFrameResources
+	{
+		class FVulkanBuffer* UniformBuffer = nullptr;
+		class FVulkanBuffer* IndirectBuffer = nullptr;
+		class FVulkanBuffer* InstanceBuffer = nullptr;
+		VkDescriptorSet DescriptorSet = VK_NULL_HANDLE;
+
+		class FVulkanBuffer* DeltaBuffer = nullptr;
+		uint32_t DeltaCapacity = 0;
+		VkDescriptorSet ScatterDescriptorSet = VK_NULL_HANDLE;
+	};
+
+	void ReserveDeltaBuffer(FFrameResources& InFrame, uint32_t InNumDeltas);
+	void ApplyObjectDeltas(VkCommandBuffer InCommandBuffer);
+
+	void UpdateObjectSphere(uint32_t InObjectIndex);
+	void CullOnCpu(const glm::vec3& InCameraPosition, const FVulkanFrustum& InCameraFrustum, const FVulkanFrustum& InShadowFrustum);
+
+protected:
+	VkDescriptorSetLayout DescriptorSetLayout;
+	VkDescriptorUpdateTemplate DescriptorUpdateTemplate;
+	class FVulkanPipeline* Pipeline;
+
+	VkDescriptorSetLayout ScatterDescriptorSetLayout;
+	VkDescriptorUpdateTemplate ScatterDescriptorUpdateTemplate;
+	class FVulkanPipeline* ScatterPipeline;
+
+	class FVulkanBuffer* SceneBuffer;
+	class FVulkanBuffer* MeshInfoBuffer;
+	class FVulkanBuffer* CommandTemplateBuffer;
+
+	std::vector<FFrameResources> FrameResources;
+	std::vector<FMeshEntry> Meshes;
+
+	std::vector<FObjectDelta> PendingDeltas;
+	std::vector<uint32_t> PendingDeltaSlots;
+
+	bool bGpuCulling;
+
+	// CPU culling state: every object's mesh, instance data and world space bounding sphere, the
+	// commands each frame starts from, and the per view visibility and instance counts of the frame being
+	// built. The counts are gathered here rather than read back from the mapped indirect buffer.
+	std::vector<uint32_t> ObjectMeshes;
+	std::vector<FInstanceBuffer> ObjectInstances;
+	FVulkanCullingSpheres ObjectSpheres;
+	std::vector<VkDrawIndexedIndirectCommand> CommandTemplates;
+	std::vector<VkDrawIndexedIndirectCommand> FrameCommands;
+	std::vector<uint8_t> Visibility[static_cast<uint32_t>(ECullingView::Count)];
+
+	uint32_t NumObjects;
+	uint32_t NumInstanceSlots;
+	uint32_t NumCommandsPerView;
+};
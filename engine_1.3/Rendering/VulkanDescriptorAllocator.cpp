@@ -0,0 +1,165 @@
+#include "VulkanDescriptorAllocator.h"
+#include "VulkanContext.h"
+#include "VulkanHelpers.h"
+
+#include "Config.h"
+
+#include <array>
+#include <algorithm>
+#include <stdexcept>
+
+static const int32_t DefaultDescriptorPoolSets = 256;
+
+// Descriptors of each type a pool reserves per set; generous enough for every layout in the renderers.
+static const std::array<std::pair<VkDescriptorType, uint32_t>, 3> DescriptorsPerSet =
+{ {
+	{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 4 },
+	{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 4 },
+	{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4 },
+} };
+
+FVulkanDescriptorAllocator::FVulkanDescriptorAllocator(FVulkanContext* InContext)
+	: Context(InContext)
+	, CurrentFrame(0)
+	, SetsPerPool(DefaultDescriptorPoolSets)
+{
+	int32_t PoolSets = DefaultDescriptorPoolSets;
+	GConfig->Get("DescriptorPoolSets", PoolSets);
+	SetsPerPool = static_cast<uint32_t>(std::max(PoolSets, 1));
+
+	FrameChains.resize(Context->GetMaxConcurrentFrames());
+}
+
+FVulkanDescriptorAllocator::~FVulkanDescriptorAllocator()
+{
+	VkDevice Device = Context->GetDevice();
+
+	for (VkDescriptorPool Pool : PersistentChain.Pools)
+	{
+		vkDestroyDescriptorPool(Device, Pool, nullptr);
+	}
+
+	for (FPoolChain& Chain : FrameChains)
+	{
+		for (VkDescriptorPool Pool : Chain.Pools)
+		{
+			vkDestroyDescriptorPool(Device, Pool, nullptr);
+		}
+	}
+}
+
+VkDescriptorPool FVulkanDescriptorAllocator::CreatePool(bool InbFreeable)
+{
+	std::vector<VkDescriptorPoolSize> PoolSizes;
+	for (const auto& Pair : DescriptorsPerSet)
+	{
+		PoolSizes.push_back({ Pair.first, Pair.second * SetsPerPool });
+	}
+
+	VkDescriptorPoolCreateInfo DescriptorPoolCI{};
+	DescriptorPoolCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	DescriptorPoolCI.poolSizeCount = static_cast<uint32_t>(PoolSizes.size());
+	DescriptorPoolCI.pPoolSizes = PoolSizes.data();
+	DescriptorPoolCI.maxSets = SetsPerPool;
+
+	// Transient pools are only ever reset as a whole, which is cheaper when individual frees are not allowed.
+	DescriptorPoolCI.flags = InbFreeable ? VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT : 0;
+
+	VkDescriptorPool Pool = VK_NULL_HANDLE;
+	VK_ASSERT(vkCreateDescriptorPool(Context->GetDevice(), &DescriptorPoolCI, nullptr, &Pool));
+
+	return Pool;
+}
+
+VkDescriptorSet FVulkanDescriptorAllocator::AllocateFromChain(FPoolChain& InChain, VkDescriptorSetLayout InLayout, bool InbFreeable, VkDescriptorPool& OutPool)
+{
+	VkDevice Device = Context->GetDevice();
+
+	VkDescriptorSetAllocateInfo DescriptorSetAllocInfo{};
+	DescriptorSetAllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	DescriptorSetAllocInfo.descriptorSetCount = 1;
+	DescriptorSetAllocInfo.pSetLayouts = &InLayout;
+
+	// Pools before the current one are full. Freeing a persistent set moves the chain back to that set's pool,
+	// so the hole is filled before the chain grows, and a full pool on the way is simply skipped again.
+	while (true)
+	{
+		bool bNewPool = false;
+		if (InChain.CurrentPool == InChain.Pools.size())
+		{
+			InChain.Pools.push_back(CreatePool(InbFreeable));
+			bNewPool = true;
+		}
+
+		VkDescriptorPool Pool = InChain.Pools[InChain.CurrentPool];
+		DescriptorSetAllocInfo.descriptorPool = Pool;
+
+		VkDescriptorSet DescriptorSet = VK_NULL_HANDLE;
+		VkResult Result = vkAllocateDescriptorSets(Device, &DescriptorSetAllocInfo, &DescriptorSet);
+		if (Result == VK_SUCCESS)
+		{
+			OutPool = Pool;
+			return DescriptorSet;
+		}
+
+		if (Result != VK_ERROR_OUT_OF_POOL_MEMORY && Result != VK_ERROR_FRAGMENTED_POOL)
+		{
+			throw std::runtime_error("Failed to allocate a descriptor set.");
+		}
+
+		if (bNewPool)
+		{
+			throw std::runtime_error("Descriptor set layout does not fit in an empty descriptor pool.");
+		}
+
+		++InChain.CurrentPool;
+	}
+}
+
+VkDescriptorSet FVulkanDescriptorAllocator::Allocate(VkDescriptorSetLayout InLayout)
+{
+	VkDescriptorPool Pool = VK_NULL_HANDLE;
+	VkDescriptorSet DescriptorSet = AllocateFromChain(PersistentChain, InLayout, true, Pool);
+
+	PersistentSetPools[DescriptorSet] = Pool;
+
+	return DescriptorSet;
+}
+
+void FVulkanDescriptorAllocator::Free(VkDescriptorSet InDescriptorSet)
+{
+	auto Iter = PersistentSetPools.find(InDescriptorSet);
+	if (Iter == PersistentSetPools.end())
+	{
+		return;
+	}
+
+	VK_ASSERT(vkFreeDescriptorSets(Context->GetDevice(), Iter->second, 1, &InDescriptorSet));
+
+	auto PoolIter = std::find(PersistentChain.Pools.begin(), PersistentChain.Pools.end(), Iter->second);
+	const uint32_t PoolIdx = static_cast<uint32_t>(PoolIter - PersistentChain.Pools.begin());
+	PersistentChain.CurrentPool = std::min(PersistentChain.CurrentPool, PoolIdx);
+
+	PersistentSetPools.erase(Iter);
+}
+
+VkDescriptorSet FVulkanDescriptorAllocator::AllocateTransient(VkDescriptorSetLayout InLayout)
+{
+	VkDescriptorPool Pool = VK_NULL_HANDLE;
+	return AllocateFromChain(FrameChains[CurrentFrame], InLayout, false, Pool);
+}
+
+void FVulkanDescriptorAllocator::ResetFrame(uint32_t InFrameIndex)
+{
+	CurrentFrame = InFrameIndex;
+
+	FPoolChain& Chain = FrameChains[CurrentFrame];
+
+	// Only the pools the slot's last frame actually used need a reset; the ones past it are still empty.
+	const uint32_t NumUsedPools = std::min(Chain.CurrentPool + 1, static_cast<uint32_t>(Chain.Pools.size()));
+	for (uint32_t Idx = 0; Idx < NumUsedPools; ++Idx)
+	{
+		VK_ASSERT(vkResetDescriptorPool(Context->GetDevice(), Chain.Pools[Idx], 0));
+	}
+	Chain.CurrentPool = 0;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "vulkan/vulkan.h"
+
+#include <vector>
+#include <unordered_map>
+
+// Hands out descriptor sets from chains of pools that grow by another pool whenever the current one runs out.
+// Persistent sets live until they are freed or the allocator goes away. Transient sets come from the current
+// frame slot's chain, which is reset wholesale once the slot's previous frame has finished on the GPU, so they
+// are only valid for the frame being recorded.
+class FVulkanDescriptorAllocator
+{
+public:
+	FVulkanDescriptorAllocator(class FVulkanContext* InContext);
+	~FVulkanDescriptorAllocator();
+
+	VkDescriptorSet Allocate(VkDescriptorSetLayout InLayout);
+	void Free(VkDescriptorSet InDescriptorSet);
+
+	VkDescriptorSet AllocateTransient(VkDescriptorSetLayout InLayout);
+
+	// Called by the context once the frame slot about to be recorded has finished its previous frame.
+	void ResetFrame(uint32_t InFrameIndex);
+
+private:
+	struct FPoolChain
+	{
+		std::vector<VkDescriptorPool> Pools;
+		uint32_t CurrentPool = 0;
+	};
+
+	VkDescriptorPool CreatePool(bool InbFreeable);
+	VkDescriptorSet AllocateFromChain(FPoolChain& InChain, VkDescriptorSetLayout InLayout, bool InbFreeable, VkDescriptorPool& OutPool);
+
+private:
+	class FVulkanContext* Context;
+
+	FPoolChain PersistentChain;
+	std::vector<FPoolChain> FrameChains;
+	uint32_t CurrentFrame;
+
+	// Persistent sets have to be freed back to the pool they came from.
+	std::unordered_map<VkDescriptorSet, VkDescriptorPool> PersistentSetPools;
+
+	uint32_t SetsPerPool;
+};
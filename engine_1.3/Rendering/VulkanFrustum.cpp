@@ -0,0 +1,145 @@
+#include "VulkanFrustum.h"
+
+#include <cassert>
+#include <algorithm>
+#include <execution>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE__)
+#define VK_FRUSTUM_USE_SSE 1
+#include <xmmintrin.h>
+#else
+#define VK_FRUSTUM_USE_SSE 0
+#endif
+
+static const uint32_t CullingChunkSize = 256;
+
+FVulkanFrustum FVulkanFrustum::FromViewProjection(const glm::mat4& InViewProjection)
+{
+	const glm::mat4& M = InViewProjection;
+
+	glm::vec4 Row0(M[0][0], M[1][0], M[2][0], M[3][0]);
+	glm::vec4 Row1(M[0][1], M[1][1], M[2][1], M[3][1]);
+	glm::vec4 Row2(M[0][2], M[1][2], M[2][2], M[3][2]);
+	glm::vec4 Row3(M[0][3], M[1][3], M[2][3], M[3][3]);
+
+	FVulkanFrustum Frustum;
+	Frustum.Planes[0] = Row3 + Row0;
+	Frustum.Planes[1] = Row3 - Row0;
+	Frustum.Planes[2] = Row3 + Row1;
+	Frustum.Planes[3] = Row3 - Row1;
+	// Clip space depth is [0, 1] (GLM_FORCE_DEPTH_ZERO_TO_ONE), so the near plane is z >= 0 rather than z >= -w.
+	Frustum.Planes[4] = Row2;
+	Frustum.Planes[5] = Row3 - Row2;
+
+	for (glm::vec4& Plane : Frustum.Planes)
+	{
+		float Length = glm::length(glm::vec3(Plane));
+		if (Length > 0.0f)
+		{
+			Plane /= Length;
+		}
+	}
+
+	return Frustum;
+}
+
+void FVulkanCullingSpheres::Resize(uint32_t InCount)
+{
+	uint32_t PaddedCount = (InCount + 3) & ~3u;
+
+	CenterX.assign(PaddedCount, 0.0f);
+	CenterY.assign(PaddedCount, 0.0f);
+	CenterZ.assign(PaddedCount, 0.0f);
+	Radius.assign(PaddedCount, -1.0f);
+}
+
+static void CullSpheresChunk(const FVulkanFrustum& InFrustum, const FVulkanCullingSpheres& InSpheres, uint32_t InBegin, uint32_t InEnd, uint8_t* OutVisible)
+{
+#if VK_FRUSTUM_USE_SSE
+	__m128 PlaneX[6], PlaneY[6], PlaneZ[6], PlaneW[6];
+	for (int PlaneIdx = 0; PlaneIdx < 6; ++PlaneIdx)
+	{
+		PlaneX[PlaneIdx] = _mm_set1_ps(InFrustum.Planes[PlaneIdx].x);
+		PlaneY[PlaneIdx] = _mm_set1_ps(InFrustum.Planes[PlaneIdx].y);
+		PlaneZ[PlaneIdx] = _mm_set1_ps(InFrustum.Planes[PlaneIdx].z);
+		PlaneW[PlaneIdx] = _mm_set1_ps(InFrustum.Planes[PlaneIdx].w);
+	}
+
+	for (uint32_t Idx = InBegin; Idx < InEnd; Idx += 4)
+	{
+		__m128 X = _mm_loadu_ps(&InSpheres.CenterX[Idx]);
+		__m128 Y = _mm_loadu_ps(&InSpheres.CenterY[Idx]);
+		__m128 Z = _mm_loadu_ps(&InSpheres.CenterZ[Idx]);
+		__m128 Radius = _mm_loadu_ps(&InSpheres.Radius[Idx]);
+		__m128 NegRadius = _mm_sub_ps(_mm_setzero_ps(), Radius);
+
+		__m128 Inside = _mm_cmpge_ps(Radius, _mm_setzero_ps());
+		for (int PlaneIdx = 0; PlaneIdx < 6; ++PlaneIdx)
+		{
+			__m128 Distance = _mm_mul_ps(X, PlaneX[PlaneIdx]);
+			Distance = _mm_add_ps(Distance, _mm_mul_ps(Y, PlaneY[PlaneIdx]));
+			Distance = _mm_add_ps(Distance, _mm_mul_ps(Z, PlaneZ[PlaneIdx]));
+			Distance = _mm_add_ps(Distance, PlaneW[PlaneIdx]);
+
+			Inside = _mm_and_ps(Inside, _mm_cmpge_ps(Distance, NegRadius));
+		}
+
+		int Mask = _mm_movemask_ps(Inside);
+
+		uint32_t NumLanes = std::min(4u, InEnd - Idx);
+		for (uint32_t Lane = 0; Lane < NumLanes; ++Lane)
+		{
+			OutVisible[Idx + Lane] = static_cast<uint8_t>((Mask >> Lane) & 1);
+		}
+	}
+#else
+	for (uint32_t Idx = InBegin; Idx < InEnd; ++Idx)
+	{
+		glm::vec3 Center(InSpheres.CenterX[Idx], InSpheres.CenterY[Idx], InSpheres.CenterZ[Idx]);
+		float Radius = InSpheres.Radius[Idx];
+
+		bool bInside = Radius >= 0.0f;
+		for (int PlaneIdx = 0; PlaneIdx < 6 && bInside; ++PlaneIdx)
+		{
+			const glm::vec4& Plane = InFrustum.Planes[PlaneIdx];
+			bInside = glm::dot(glm::vec3(Plane), Center) + Plane.w >= -Radius;
+		}
+
+		OutVisible[Idx] = bInside ? 1 : 0;
+	}
+#endif
+}
+
+namespace Vk
+{
+	void CullSpheres(const FVulkanFrustum& InFrustum, const FVulkanCullingSpheres& InSpheres, uint32_t InCount, uint8_t* OutVisible)
+	{
+		if (InCount == 0 || OutVisible == nullptr)
+		{
+			return;
+		}
+
+		assert(InSpheres.GetPaddedCount() >= InCount);
+
+		uint32_t NumChunks = (InCount + CullingChunkSize - 1) / CullingChunkSize;
+		if (NumChunks == 1)
+		{
+			CullSpheresChunk(InFrustum, InSpheres, 0, InCount, OutVisible);
+			return;
+		}
+
+		std::vector<uint32_t> ChunkIndices(NumChunks);
+		for (uint32_t Idx = 0; Idx < NumChunks; ++Idx)
+		{
+			ChunkIndices[Idx] = Idx;
+		}
+
+		std::for_each(std::execution::par, std::begin(ChunkIndices), std::end(ChunkIndices), [&InFrustum, &InSpheres, InCount, OutVisible](uint32_t ChunkIdx)
+		{
+			uint32_t Begin = ChunkIdx * CullingChunkSize;
+			uint32_t End = std::min(Begin + CullingChunkSize, InCount);
+
+			CullSpheresChunk(InFrustum, InSpheres, Begin, End, OutVisible);
+		});
+	}
+}
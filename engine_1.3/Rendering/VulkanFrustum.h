@@ -0,0 +1,31 @@
+#pragma once
+
+#include "glm/glm.hpp"
+
+#include <cstdint>
+#include <vector>
+
+struct FVulkanFrustum
+{
+	glm::vec4 Planes[6];
+
+	static FVulkanFrustum FromViewProjection(const glm::mat4& InViewProjection);
+};
+
+// Bounding spheres laid out as structure of arrays, padded to a multiple of four so the
+// culling loop can test four spheres against a plane at once.
+struct FVulkanCullingSpheres
+{
+	std::vector<float> CenterX;
+	std::vector<float> CenterY;
+	std::vector<float> CenterZ;
+	std::vector<float> Radius;
+
+	void Resize(uint32_t InCount);
+	uint32_t GetPaddedCount() const { return static_cast<uint32_t>(Radius.size()); }
+};
+
+namespace Vk
+{
+	void CullSpheres(const FVulkanFrustum& InFrustum, const FVulkanCullingSpheres& InSpheres, uint32_t InCount, uint8_t* OutVisible);
+}
@@ -0,0 +1,238 @@
+#include "VulkanGeometryPool.h"
+#include "VulkanContext.h"
+#include "VulkanBuffer.h"
+
+#include "Config.h"
+#include "Vertex.h"
+
+#include <algorithm>
+
+static const int32_t DefaultMaxVerticesPerPage = 1 << 20;
+static const int32_t DefaultMaxIndicesPerPage = 1 << 22;
+
+static const uint32_t MinVerticesPerPage = 1 << 12;
+static const uint32_t MinIndicesPerPage = 1 << 14;
+
+static uint32_t GetPageSize(uint32_t InLastSize, uint32_t InMinSize, uint32_t InMaxSize, uint32_t InRequestSize)
+{
+	uint32_t Size = std::min(InMinSize, InMaxSize);
+	if (InLastSize > 0)
+	{
+		Size = InLastSize >= InMaxSize / 2 ? InMaxSize : InLastSize * 2;
+	}
+
+	uint32_t RoundedRequestSize = 1;
+	while (RoundedRequestSize < InRequestSize && RoundedRequestSize < InMaxSize)
+	{
+		RoundedRequestSize *= 2;
+	}
+
+	// A mesh larger than the maximum still gets a page of its own.
+	return std::max({ Size, std::min(RoundedRequestSize, InMaxSize), InRequestSize });
+}
+
+bool FVulkanGeometryPool::FFreeList::Allocate(uint32_t InSize, uint32_t& OutOffset)
+{
+	for (auto Iter = Ranges.begin(); Iter != Ranges.end(); ++Iter)
+	{
+		if (Iter->Size < InSize)
+		{
+			continue;
+		}
+
+		OutOffset = Iter->Offset;
+
+		Iter->Offset += InSize;
+		Iter->Size -= InSize;
+		if (Iter->Size == 0)
+		{
+			Ranges.erase(Iter);
+		}
+
+		return true;
+	}
+
+	return false;
+}
+
+void FVulkanGeometryPool::FFreeList::Free(uint32_t InOffset, uint32_t InSize)
+{
+	if (InSize == 0)
+	{
+		return;
+	}
+
+	auto Iter = std::lower_bound(Ranges.begin(), Ranges.end(), InOffset,
+		[](const FRange& InRange, uint32_t InValue) { return InRange.Offset < InValue; });
+
+	Iter = Ranges.insert(Iter, { InOffset, InSize });
+
+	// Merge with the following range first so the iterator stays valid for the preceding one.
+	auto Next = Iter + 1;
+	if (Next != Ranges.end() && Iter->Offset + Iter->Size == Next->Offset)
+	{
+		Iter->Size += Next->Size;
+		Ranges.erase(Next);
+	}
+
+	if (Iter != Ranges.begin())
+	{
+		auto Prev = Iter - 1;
+		if (Prev->Offset + Prev->Size == Iter->Offset)
+		{
+			Prev->Size += Iter->Size;
+			Ranges.erase(Iter);
+		}
+	}
+}
+
+FVulkanGeometryPool::FVulkanGeometryPool(FVulkanContext* InContext)
+	: FVulkanObject(InContext)
+	, MaxVerticesPerPage(DefaultMaxVerticesPerPage)
+	, MaxIndicesPerPage(DefaultMaxIndicesPerPage)
+{
+	int32_t ConfigVerticesPerPage = DefaultMaxVerticesPerPage;
+	int32_t ConfigIndicesPerPage = DefaultMaxIndicesPerPage;
+	GConfig->Get("GeometryPoolVertices", ConfigVerticesPerPage);
+	GConfig->Get("GeometryPoolIndices", ConfigIndicesPerPage);
+
+	MaxVerticesPerPage = static_cast<uint32_t>(std::max(ConfigVerticesPerPage, 1));
+	MaxIndicesPerPage = static_cast<uint32_t>(std::max(ConfigIndicesPerPage, 1));
+}
+
+void FVulkanGeometryPool::Destroy()
+{
+	for (FPage& Page : Pages)
+	{
+		Context->DestroyObject(Page.VertexBuffer);
+		Context->DestroyObject(Page.IndexBuffer);
+	}
+	Pages.clear();
+}
+
+uint32_t FVulkanGeometryPool::CreatePage(uint32_t InNumVertices, uint32_t InNumIndices)
+{
+	FPage Page;
+
+	Page.VertexBuffer = Context->CreateObject<FVulkanBuffer>();
+	Page.VertexBuffer->SetUsage(VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+	Page.VertexBuffer->SetProperties(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	Page.VertexBuffer->Allocate(sizeof(FVertex) * static_cast<VkDeviceSize>(InNumVertices));
+
+	Page.IndexBuffer = Context->CreateObject<FVulkanBuffer>();
+	Page.IndexBuffer->SetUsage(VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
+	Page.IndexBuffer->SetProperties(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	Page.IndexBuffer->Allocate(sizeof(uint32_t) * static_cast<VkDeviceSize>(InNumIndices));
+
+	Page.NumVertices = InNumVertices;
+	Page.NumIndices = InNumIndices;
+
+	Page.FreeVertices.Ranges.push_back({ 0, InNumVertices });
+	Page.FreeIndices.Ranges.push_back({ 0, InNumIndices });
+
+	Pages.push_back(Page);
+
+	return static_cast<uint32_t>(Pages.size() - 1);
+}
+
+bool FVulkanGeometryPool::Allocate(
+	const std::vector<FVertex>& InVertices,
+	const std::vector<uint32_t>& InIndices,
+	FVulkanGeometryAllocation& OutAllocation)
+{
+	OutAllocation = FVulkanGeometryAllocation();
+
+	if (InVertices.empty() || InIndices.empty())
+	{
+		return false;
+	}
+
+	const uint32_t NumVertices = static_cast<uint32_t>(InVertices.size());
+	const uint32_t NumIndices = static_cast<uint32_t>(InIndices.size());
+
+	auto TryAllocate = [&](uint32_t InPage)
+	{
+		FPage& Page = Pages[InPage];
+
+		uint32_t FirstVertex = 0;
+		if (Page.FreeVertices.Allocate(NumVertices, FirstVertex) == false)
+		{
+			return false;
+		}
+
+		uint32_t FirstIndex = 0;
+		if (Page.FreeIndices.Allocate(NumIndices, FirstIndex) == false)
+		{
+			Page.FreeVertices.Free(FirstVertex, NumVertices);
+			return false;
+		}
+
+		OutAllocation.Page = InPage;
+		OutAllocation.FirstVertex = FirstVertex;
+		OutAllocation.NumVertices = NumVertices;
+		OutAllocation.FirstIndex = FirstIndex;
+		OutAllocation.NumIndices = NumIndices;
+
+		return true;
+	};
+
+	bool bAllocated = false;
+	for (uint32_t PageIdx = 0; PageIdx < Pages.size() && bAllocated == false; ++PageIdx)
+	{
+		bAllocated = TryAllocate(PageIdx);
+	}
+
+	if (bAllocated == false)
+	{
+		const uint32_t LastVertices = Pages.empty() ? 0 : Pages.back().NumVertices;
+		const uint32_t LastIndices = Pages.empty() ? 0 : Pages.back().NumIndices;
+
+		uint32_t NewPage = CreatePage(
+			GetPageSize(LastVertices, MinVerticesPerPage, MaxVerticesPerPage, NumVertices),
+			GetPageSize(LastIndices, MinIndicesPerPage, MaxIndicesPerPage, NumIndices));
+		bAllocated = TryAllocate(NewPage);
+	}
+
+	if (bAllocated == false)
+	{
+		return false;
+	}
+
+	const FPage& Page = Pages[OutAllocation.Page];
+
+	Page.VertexBuffer->Copy(
+		(uint8_t*)InVertices.data(),
+		sizeof(FVertex) * InVertices.size(),
+		sizeof(FVertex) * static_cast<VkDeviceSize>(OutAllocation.FirstVertex));
+
+	Page.IndexBuffer->Copy(
+		(uint8_t*)InIndices.data(),
+		sizeof(uint32_t) * InIndices.size(),
+		sizeof(uint32_t) * static_cast<VkDeviceSize>(OutAllocation.FirstIndex));
+
+	return true;
+}
+
+void FVulkanGeometryPool::Free(FVulkanGeometryAllocation& InOutAllocation)
+{
+	if (InOutAllocation.IsValid() == false || InOutAllocation.Page >= Pages.size())
+	{
+		return;
+	}
+
+	FPage& Page = Pages[InOutAllocation.Page];
+	Page.FreeVertices.Free(InOutAllocation.FirstVertex, InOutAllocation.NumVertices);
+	Page.FreeIndices.Free(InOutAllocation.FirstIndex, InOutAllocation.NumIndices);
+
+	InOutAllocation = FVulkanGeometryAllocation();
+}
+
+FVulkanBuffer* FVulkanGeometryPool::GetVertexBuffer(uint32_t InPage) const
+{
+	return InPage < Pages.size() ? Pages[InPage].VertexBuffer : nullptr;
+}
+
+FVulkanBuffer* FVulkanGeometryPool::GetIndexBuffer(uint32_t InPage) const
+{
+	return InPage < Pages.size() ? Pages[InPage].IndexBuffer : nullptr;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "VulkanObject.h"
+
+#include "vulkan/vulkan.h"
+
+#include <vector>
+
+struct FVulkanGeometryAllocation
+{
+	uint32_t Page = UINT32_MAX;
+	uint32_t FirstVertex = 0;
+	uint32_t NumVertices = 0;
+	uint32_t FirstIndex = 0;
+	uint32_t NumIndices = 0;
+
+	bool IsValid() const { return Page != UINT32_MAX; }
+};
+
+// Sub-allocates the vertices and indices of every mesh out of a few large buffers, so a single
+// vertex/index buffer bind serves all meshes that live in the same page. The first page is sized from the
+// first mesh and every new page doubles the last one up to the configured maximum, so small scenes only pay
+// for the geometry they have while large ones still end up on few pages.
+class FVulkanGeometryPool : public FVulkanObject
+{
+public:
+	FVulkanGeometryPool(class FVulkanContext* InContext);
+
+	virtual void Destroy() override;
+
+	bool Allocate(
+		const std::vector<struct FVertex>& InVertices,
+		const std::vector<uint32_t>& InIndices,
+		FVulkanGeometryAllocation& OutAllocation);
+	void Free(FVulkanGeometryAllocation& InOutAllocation);
+
+	uint32_t GetNumPages() const { return static_cast<uint32_t>(Pages.size()); }
+	class FVulkanBuffer* GetVertexBuffer(uint32_t InPage) const;
+	class FVulkanBuffer* GetIndexBuffer(uint32_t InPage) const;
+
+protected:
+	struct FRange
+	{
+		uint32_t Offset;
+		uint32_t Size;
+	};
+
+	struct FFreeList
+	{
+		std::vector<FRange> Ranges;
+
+		bool Allocate(uint32_t InSize, uint32_t& OutOffset);
+		void Free(uint32_t InOffset, uint32_t InSize);
+	};
+
+	struct FPage
+	{
+		class FVulkanBuffer* VertexBuffer = nullptr;
+		class FVulkanBuffer* IndexBuffer = nullptr;
+
+		uint32_t NumVertices = 0;
+		uint32_t NumIndices = 0;
+
+		FFreeList FreeVertices;
+		FFreeList FreeIndices;
+	};
+
+	uint32_t CreatePage(uint32_t InNumVertices, uint32_t InNumIndices);
+
+protected:
+	std::vector<FPage> Pages;
+
+	uint32_t MaxVerticesPerPage;
+	uint32_t MaxIndicesPerPage;
+};
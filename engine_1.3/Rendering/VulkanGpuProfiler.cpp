@@ -0,0 +1,467 @@
+#include "VulkanGpuProfiler.h"
+#include "VulkanContext.h"
+#include "VulkanHelpers.h"
+
+#include "Config.h"
+
+#include "imgui/imgui.h"
+
+#include <cfloat>
+#include <fstream>
+#include <iomanip>
+#include <algorithm>
+
+static const int32_t DefaultGpuProfilerMaxScopes = 64;
+static const int32_t DefaultGpuProfilerHistory = 240;
+
+FVulkanGpuProfiler::FVulkanGpuProfiler(FVulkanContext* InContext)
+	: FVulkanObject(InContext)
+	, MaxQueries(0)
+	, MaxHistory(0)
+	, TimestampPeriod(1.0)
+	, TimestampMask(~0ULL)
+	, bSupported(false)
+	, bEnabled(true)
+	, bFrameActive(false)
+	, FrameNumber(0)
+{
+	int32_t ConfigMaxScopes = DefaultGpuProfilerMaxScopes;
+	int32_t ConfigHistory = DefaultGpuProfilerHistory;
+	GConfig->Get("GpuProfilerMaxScopes", ConfigMaxScopes);
+	GConfig->Get("GpuProfilerHistory", ConfigHistory);
+	GConfig->Get("GpuProfilerEnabled", bEnabled);
+
+	MaxQueries = static_cast<uint32_t>(std::max(ConfigMaxScopes, 1)) * 2;
+	MaxHistory = static_cast<uint32_t>(std::max(ConfigHistory, 1));
+
+	VkPhysicalDevice PhysicalDevice = Context->GetPhysicalDevice();
+
+	VkPhysicalDeviceProperties Properties;
+	vkGetPhysicalDeviceProperties(PhysicalDevice, &Properties);
+
+	uint32_t GraphicsFamily = 0;
+	uint32_t PresentFamily = 0;
+	Vk::FindQueueFamilies(PhysicalDevice, Context->GetSurface(), GraphicsFamily, PresentFamily);
+
+	uint32_t QueueFamilyCount = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(PhysicalDevice, &QueueFamilyCount, nullptr);
+	std::vector<VkQueueFamilyProperties> QueueFamilies(QueueFamilyCount);
+	vkGetPhysicalDeviceQueueFamilyProperties(PhysicalDevice, &QueueFamilyCount, QueueFamilies.data());
+
+	const uint32_t ValidBits = GraphicsFamily < QueueFamilyCount ? QueueFamilies[GraphicsFamily].timestampValidBits : 0;
+
+	// A zero period or zero valid bits means the queue cannot time anything.
+	bSupported = ValidBits > 0 && Properties.limits.timestampPeriod > 0.0f;
+	if (bSupported == false)
+	{
+		return;
+	}
+
+	TimestampPeriod = static_cast<double>(Properties.limits.timestampPeriod);
+	TimestampMask = ValidBits >= 64 ? ~0ULL : (1ULL << ValidBits) - 1;
+
+	Frames.resize(Context->GetMaxConcurrentFrames());
+	for (FFrameQueries& Frame : Frames)
+	{
+		VkQueryPoolCreateInfo QueryPoolCI{};
+		QueryPoolCI.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		QueryPoolCI.queryType = VK_QUERY_TYPE_TIMESTAMP;
+		QueryPoolCI.queryCount = MaxQueries;
+
+		VK_ASSERT(vkCreateQueryPool(Context->GetDevice(), &QueryPoolCI, nullptr, &Frame.QueryPool));
+
+		Frame.Scopes.reserve(MaxQueries / 2);
+	}
+
+	QueryResults.resize(MaxQueries);
+}
+
+void FVulkanGpuProfiler::Destroy()
+{
+	for (FFrameQueries& Frame : Frames)
+	{
+		vkDestroyQueryPool(Context->GetDevice(), Frame.QueryPool, nullptr);
+	}
+	Frames.clear();
+	History.clear();
+}
+
+void FVulkanGpuProfiler::BeginFrame(VkCommandBuffer InCommandBuffer)
+{
+	if (bSupported == false)
+	{
+		return;
+	}
+
+	// Resolved even when profiling was just turned off, so the slot's results are consumed exactly once and a
+	// later re-enable does not read them again.
+	FFrameQueries& Frame = Frames[Context->GetCurrentFrame()];
+	if (Frame.bRecorded)
+	{
+		ResolveFrame(Frame);
+		Frame.bRecorded = false;
+	}
+
+	if (IsEnabled() == false)
+	{
+		return;
+	}
+
+	vkCmdResetQueryPool(InCommandBuffer, Frame.QueryPool, 0, MaxQueries);
+
+	Frame.Scopes.clear();
+	Frame.NumQueries = 0;
+	Frame.FrameNumber = FrameNumber++;
+
+	OpenScopes.clear();
+	bFrameActive = true;
+}
+
+void FVulkanGpuProfiler::EndFrame(VkCommandBuffer InCommandBuffer)
+{
+	if (bFrameActive == false)
+	{
+		return;
+	}
+
+	while (OpenScopes.empty() == false)
+	{
+		EndScope(InCommandBuffer);
+	}
+
+	Frames[Context->GetCurrentFrame()].bRecorded = true;
+	bFrameActive = false;
+}
+
+void FVulkanGpuProfiler::BeginScope(VkCommandBuffer InCommandBuffer, const char* InName)
+{
+	if (bFrameActive == false)
+	{
+		return;
+	}
+
+	FFrameQueries& Frame = Frames[Context->GetCurrentFrame()];
+	if (Frame.NumQueries + 2 > MaxQueries)
+	{
+		// Out of queries; keep the stack balanced so the matching EndScope is skipped as well.
+		OpenScopes.push_back(UINT32_MAX);
+		return;
+	}
+
+	FScopeQuery Scope;
+	Scope.Name = InName;
+	Scope.Depth = static_cast<uint32_t>(OpenScopes.size());
+	Scope.BeginQuery = Frame.NumQueries++;
+	Scope.EndQuery = Frame.NumQueries++;
+
+	vkCmdWriteTimestamp(InCommandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, Frame.QueryPool, Scope.BeginQuery);
+
+	OpenScopes.push_back(static_cast<uint32_t>(Frame.Scopes.size()));
+	Frame.Scopes.push_back(Scope);
+}
+
+void FVulkanGpuProfiler::EndScope(VkCommandBuffer InCommandBuffer)
+{
+	if (bFrameActive == false || OpenScopes.empty())
+	{
+		return;
+	}
+
+	const uint32_t ScopeIdx = OpenScopes.back();
+	OpenScopes.pop_back();
+
+	if (ScopeIdx == UINT32_MAX)
+	{
+		return;
+	}
+
+	FFrameQueries& Frame = Frames[Context->GetCurrentFrame()];
+	vkCmdWriteTimestamp(InCommandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, Frame.QueryPool, Frame.Scopes[ScopeIdx].EndQuery);
+}
+
+void FVulkanGpuProfiler::ResolveFrame(FFrameQueries& InFrame)
+{
+	if (InFrame.NumQueries == 0)
+	{
+		return;
+	}
+
+	// No WAIT bit: the timeline wait in BeginRender already covers this submission.
+	VkResult Result = vkGetQueryPoolResults(
+		Context->GetDevice(),
+		InFrame.QueryPool,
+		0,
+		InFrame.NumQueries,
+		sizeof(uint64_t) * InFrame.NumQueries,
+		QueryResults.data(),
+		sizeof(uint64_t),
+		VK_QUERY_RESULT_64_BIT);
+
+	if (Result != VK_SUCCESS)
+	{
+		return;
+	}
+
+	const double MsPerTick = TimestampPeriod / 1000000.0;
+	const uint64_t FrameStart = QueryResults[0] & TimestampMask;
+
+	FGpuFrameTiming Timing;
+	Timing.FrameNumber = InFrame.FrameNumber;
+	Timing.Scopes.reserve(InFrame.Scopes.size());
+
+	for (const FScopeQuery& Scope : InFrame.Scopes)
+	{
+		const uint64_t Begin = QueryResults[Scope.BeginQuery] & TimestampMask;
+		const uint64_t End = QueryResults[Scope.EndQuery] & TimestampMask;
+
+		// Masked subtraction keeps a counter wrap between the two writes from turning into a huge duration.
+		FGpuScopeTiming ScopeTiming;
+		ScopeTiming.Name = Scope.Name;
+		ScopeTiming.Depth = Scope.Depth;
+		ScopeTiming.StartMs = static_cast<double>((Begin - FrameStart) & TimestampMask) * MsPerTick;
+		ScopeTiming.DurationMs = static_cast<double>((End - Begin) & TimestampMask) * MsPerTick;
+
+		if (Scope.Depth == 0)
+		{
+			Timing.TotalMs = std::max(Timing.TotalMs, ScopeTiming.StartMs + ScopeTiming.DurationMs);
+		}
+
+		Timing.Scopes.push_back(ScopeTiming);
+	}
+
+	History.push_back(std::move(Timing));
+	while (History.size() > MaxHistory)
+	{
+		History.pop_front();
+	}
+}
+
+void FVulkanGpuProfiler::GetStats(std::vector<FGpuScopeStats>& OutStats) const
+{
+	OutStats.clear();
+
+	for (const FGpuFrameTiming& Frame : History)
+	{
+		for (const FGpuScopeTiming& Scope : Frame.Scopes)
+		{
+			auto Iter = std::find_if(OutStats.begin(), OutStats.end(), [&Scope](const FGpuScopeStats& InStats)
+			{
+				return InStats.Depth == Scope.Depth && InStats.Name == Scope.Name;
+			});
+
+			if (Iter == OutStats.end())
+			{
+				FGpuScopeStats Stats;
+				Stats.Name = Scope.Name;
+				Stats.Depth = Scope.Depth;
+				Stats.MinMs = DBL_MAX;
+				OutStats.push_back(Stats);
+				Iter = OutStats.end() - 1;
+			}
+
+			Iter->NumSamples++;
+			Iter->LastMs = Scope.DurationMs;
+			Iter->AvgMs += Scope.DurationMs;
+			Iter->MinMs = std::min(Iter->MinMs, Scope.DurationMs);
+			Iter->MaxMs = std::max(Iter->MaxMs, Scope.DurationMs);
+		}
+	}
+
+	for (FGpuScopeStats& Stats : OutStats)
+	{
+		Stats.AvgMs /= static_cast<double>(Stats.NumSamples);
+	}
+}
+
+bool FVulkanGpuProfiler::ExportJSON(const std::string& InFilename) const
+{
+	std::ofstream File(InFilename, std::ios::trunc);
+	if (File.is_open() == false)
+	{
+		return false;
+	}
+
+	std::vector<FGpuScopeStats> Stats;
+	GetStats(Stats);
+
+	File << std::fixed << std::setprecision(6);
+	File << "{\n";
+	File << "\t\"timestampPeriodNs\": " << TimestampPeriod << ",\n";
+
+	File << "\t\"summary\": [\n";
+	for (size_t Idx = 0; Idx < Stats.size(); ++Idx)
+	{
+		const FGpuScopeStats& Scope = Stats[Idx];
+		File << "\t\t{ \"name\": \"" << Scope.Name << "\", \"depth\": " << Scope.Depth
+			<< ", \"samples\": " << Scope.NumSamples
+			<< ", \"avgMs\": " << Scope.AvgMs
+			<< ", \"minMs\": " << Scope.MinMs
+			<< ", \"maxMs\": " << Scope.MaxMs << " }"
+			<< (Idx + 1 < Stats.size() ? ",\n" : "\n");
+	}
+	File << "\t],\n";
+
+	File << "\t\"frames\": [\n";
+	for (size_t FrameIdx = 0; FrameIdx < History.size(); ++FrameIdx)
+	{
+		const FGpuFrameTiming& Frame = History[FrameIdx];
+		File << "\t\t{ \"frame\": " << Frame.FrameNumber << ", \"totalMs\": " << Frame.TotalMs << ", \"scopes\": [";
+		for (size_t ScopeIdx = 0; ScopeIdx < Frame.Scopes.size(); ++ScopeIdx)
+		{
+			const FGpuScopeTiming& Scope = Frame.Scopes[ScopeIdx];
+			File << (ScopeIdx > 0 ? ", " : " ")
+				<< "{ \"name\": \"" << Scope.Name << "\", \"depth\": " << Scope.Depth
+				<< ", \"startMs\": " << Scope.StartMs
+				<< ", \"durationMs\": " << Scope.DurationMs << " }";
+		}
+		File << " ] }" << (FrameIdx + 1 < History.size() ? ",\n" : "\n");
+	}
+	File << "\t]\n";
+	File << "}\n";
+
+	return File.good();
+}
+
+FVulkanGpuScope::FVulkanGpuScope(FVulkanContext* InContext, VkCommandBuffer InCommandBuffer, const char* InName)
+	: Profiler(InContext->GetGpuProfiler())
+	, CommandBuffer(InCommandBuffer)
+{
+	if (Profiler != nullptr)
+	{
+		Profiler->BeginScope(CommandBuffer, InName);
+	}
+}
+
+FVulkanGpuScope::~FVulkanGpuScope()
+{
+	if (Profiler != nullptr)
+	{
+		Profiler->EndScope(CommandBuffer);
+	}
+}
+
+FGpuProfilerWidget::FGpuProfilerWidget(FVulkanGpuProfiler* InProfiler)
+	: Profiler(InProfiler)
+	, bInitialized(false)
+{
+}
+
+void FGpuProfilerWidget::Draw()
+{
+	ImGui::Begin("GPU Profiler");
+
+	if (bInitialized == false)
+	{
+		ImGui::SetWindowPos(ImVec2(340, 20));
+		ImGui::SetWindowSize(ImVec2(420, 320));
+		bInitialized = true;
+	}
+
+	if (Profiler == nullptr || Profiler->IsSupported() == false)
+	{
+		ImGui::Text("Timestamp queries are not supported on the graphics queue.");
+		ImGui::End();
+		return;
+	}
+
+	bool bEnabled = Profiler->IsEnabled();
+	if (ImGui::Checkbox("Enabled", &bEnabled))
+	{
+		Profiler->SetEnabled(bEnabled);
+	}
+
+	const std::deque<FGpuFrameTiming>& History = Profiler->GetHistory();
+	if (History.empty())
+	{
+		ImGui::Text("Waiting for results...");
+		ImGui::End();
+		return;
+	}
+
+	std::vector<float> FrameTimes;
+	FrameTimes.reserve(History.size());
+	for (const FGpuFrameTiming& Frame : History)
+	{
+		FrameTimes.push_back(static_cast<float>(Frame.TotalMs));
+	}
+
+	char Overlay[32];
+	snprintf(Overlay, sizeof(Overlay), "%.3f ms", FrameTimes.back());
+	ImGui::PlotLines("GPU Frame", FrameTimes.data(), static_cast<int>(FrameTimes.size()), 0, Overlay, 0.0f, FLT_MAX, ImVec2(0.0f, 60.0f));
+
+	// Latest frame as one row of bars per nesting level.
+	const FGpuFrameTiming& Latest = History.back();
+	const float RowHeight = ImGui::GetTextLineHeightWithSpacing();
+	const float Width = ImGui::GetContentRegionAvail().x;
+
+	uint32_t MaxDepth = 0;
+	for (const FGpuScopeTiming& Scope : Latest.Scopes)
+	{
+		MaxDepth = std::max(MaxDepth, Scope.Depth);
+	}
+
+	const ImVec2 Origin = ImGui::GetCursorScreenPos();
+	ImDrawList* DrawList = ImGui::GetWindowDrawList();
+	const double Scale = Latest.TotalMs > 0.0 ? Width / Latest.TotalMs : 0.0;
+
+	for (size_t Idx = 0; Idx < Latest.Scopes.size(); ++Idx)
+	{
+		const FGpuScopeTiming& Scope = Latest.Scopes[Idx];
+
+		const ImVec2 Min(Origin.x + static_cast<float>(Scope.StartMs * Scale), Origin.y + Scope.Depth * RowHeight);
+		const ImVec2 Max(std::max(Min.x + 1.0f, Origin.x + static_cast<float>((Scope.StartMs + Scope.DurationMs) * Scale)), Min.y + RowHeight - 1.0f);
+
+		const ImU32 Color = ImGui::GetColorU32(ImVec4(0.3f + 0.1f * (Idx % 5), 0.5f, 0.8f - 0.1f * (Idx % 4), 1.0f));
+		DrawList->AddRectFilled(Min, Max, Color);
+		DrawList->PushClipRect(Min, Max, true);
+		DrawList->AddText(ImVec2(Min.x + 2.0f, Min.y), IM_COL32_WHITE, Scope.Name);
+		DrawList->PopClipRect();
+	}
+	ImGui::Dummy(ImVec2(Width, (MaxDepth + 1) * RowHeight));
+
+	std::vector<FGpuScopeStats> Stats;
+	Profiler->GetStats(Stats);
+
+	if (ImGui::BeginTable("GpuScopes", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+	{
+		ImGui::TableSetupColumn("Scope");
+		ImGui::TableSetupColumn("Last");
+		ImGui::TableSetupColumn("Avg");
+		ImGui::TableSetupColumn("Min");
+		ImGui::TableSetupColumn("Max");
+		ImGui::TableHeadersRow();
+
+		for (const FGpuScopeStats& Scope : Stats)
+		{
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn();
+			ImGui::Text("%*s%s", static_cast<int>(Scope.Depth * 2), "", Scope.Name.c_str());
+			ImGui::TableNextColumn();
+			ImGui::Text("%.3f", Scope.LastMs);
+			ImGui::TableNextColumn();
+			ImGui::Text("%.3f", Scope.AvgMs);
+			ImGui::TableNextColumn();
+			ImGui::Text("%.3f", Scope.MinMs);
+			ImGui::TableNextColumn();
+			ImGui::Text("%.3f", Scope.MaxMs);
+		}
+
+		ImGui::EndTable();
+	}
+
+	if (ImGui::Button("Export JSON"))
+	{
+		std::string ExportPath = "gpu_profile.json";
+		GConfig->Get("GpuProfileExportPath", ExportPath);
+
+		ExportStatus = Profiler->ExportJSON(ExportPath) ? "Wrote " + ExportPath : "Failed to write " + ExportPath;
+	}
+
+	if (ExportStatus.empty() == false)
+	{
+		ImGui::SameLine();
+		ImGui::TextUnformatted(ExportStatus.c_str());
+	}
+
+	ImGui::End();
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include "VulkanObject.h"
+
+#include "Widget.h"
+
+#include "vulkan/vulkan.h"
+
+#include <deque>
+#include <string>
+#include <vector>
+
+struct FGpuScopeTiming
+{
+	const char* Name = nullptr;
+	uint32_t Depth = 0;
+
+	// Relative to the first timestamp of the frame.
+	double StartMs = 0.0;
+	double DurationMs = 0.0;
+};
+
+struct FGpuFrameTiming
+{
+	uint64_t FrameNumber = 0;
+	double TotalMs = 0.0;
+	std::vector<FGpuScopeTiming> Scopes;
+};
+
+struct FGpuScopeStats
+{
+	std::string Name;
+	uint32_t Depth = 0;
+	uint32_t NumSamples = 0;
+	double LastMs = 0.0;
+	double AvgMs = 0.0;
+	double MinMs = 0.0;
+	double MaxMs = 0.0;
+};
+
+// Brackets named ranges of the frame's command buffer with timestamp queries. Every frame slot owns its own
+// query pool, and a slot's results are read when the slot comes around again. By then BeginRender has already
+// waited for that submission, so reading them never stalls.
+class FVulkanGpuProfiler : public FVulkanObject
+{
+public:
+	FVulkanGpuProfiler(class FVulkanContext* InContext);
+
+	virtual void Destroy() override;
+
+	bool IsSupported() const { return bSupported; }
+	bool IsEnabled() const { return bSupported && bEnabled; }
+	void SetEnabled(bool InbEnabled) { bEnabled = InbEnabled; }
+
+	// Both must be called outside of a render pass.
+	void BeginFrame(VkCommandBuffer InCommandBuffer);
+	void EndFrame(VkCommandBuffer InCommandBuffer);
+
+	// InName must outlive the profiler; string literals are expected.
+	void BeginScope(VkCommandBuffer InCommandBuffer, const char* InName);
+	void EndScope(VkCommandBuffer InCommandBuffer);
+
+	const std::deque<FGpuFrameTiming>& GetHistory() const { return History; }
+	void GetStats(std::vector<FGpuScopeStats>& OutStats) const;
+
+	double GetTimestampPeriod() const { return TimestampPeriod; }
+
+	bool ExportJSON(const std::string& InFilename) const;
+
+protected:
+	struct FScopeQuery
+	{
+		const char* Name;
+		uint32_t Depth;
+		uint32_t BeginQuery;
+		uint32_t EndQuery;
+	};
+
+	struct FFrameQueries
+	{
+		VkQueryPool QueryPool = VK_NULL_HANDLE;
+		std::vector<FScopeQuery> Scopes;
+		uint32_t NumQueries = 0;
+		uint64_t FrameNumber = 0;
+		bool bRecorded = false;
+	};
+
+	void ResolveFrame(FFrameQueries& InFrame);
+
+protected:
+	std::vector<FFrameQueries> Frames;
+	std::vector<uint32_t> OpenScopes;
+	std::vector<uint64_t> QueryResults;
+
+	std::deque<FGpuFrameTiming> History;
+
+	uint32_t MaxQueries;
+	uint32_t MaxHistory;
+
+	// Nanoseconds per timestamp tick, straight from the device limits.
+	double TimestampPeriod;
+	uint64_t TimestampMask;
+
+	bool bSupported;
+	bool bEnabled;
+	bool bFrameActive;
+
+	uint64_t FrameNumber;
+};
+
+class FVulkanGpuScope
+{
+public:
+	FVulkanGpuScope(class FVulkanContext* InContext, VkCommandBuffer InCommandBuffer, const char* InName);
+	~FVulkanGpuScope();
+
+private:
+	FVulkanGpuProfiler* Profiler;
+	VkCommandBuffer CommandBuffer;
+};
+
+class FGpuProfilerWidget : public FWidget
+{
+public:
+	FGpuProfilerWidget(FVulkanGpuProfiler* InProfiler);
+	virtual ~FGpuProfilerWidget() { }
+
+	virtual void Draw() override;
+
+private:
+	FVulkanGpuProfiler* Profiler;
+
+	bool bInitialized;
+	std::string ExportStatus;
+};
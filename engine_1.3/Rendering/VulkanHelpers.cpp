@@ -8,6 +8,7 @@
 #include <set>
 #include <string>
 #include <stdexcept>
+#include <limits>
 
 namespace Vk
 {
@@ -94,7 +95,15 @@ namespace Vk
 			}
 
 			VkBool32 PresentSupport = false;
-			vkGetPhysicalDeviceSurfaceSupportKHR(InDevice, Idx, InSurface, &PresentSupport);
+			if (InSurface != VK_NULL_HANDLE)
+			{
+				vkGetPhysicalDeviceSurfaceSupportKHR(InDevice, Idx, InSurface, &PresentSupport);
+			}
+			else
+			{
+				// Without a surface nothing is presented, so the graphics queue stands in for the present queue.
+				PresentSupport = (QueueFamilies[Idx].queueFlags & VK_QUEUE_GRAPHICS_BIT) != 0;
+			}
 
 			if (PresentSupport)
 			{
@@ -145,8 +154,8 @@ namespace Vk
 
 		bool bExtensionsSupported = DeviceSupportsExtensions(InDevice, InDeviceExtensions);
 
-		bool bSwapchainAdequate = false;
-		if (bExtensionsSupported)
+		bool bSwapchainAdequate = InSurface == VK_NULL_HANDLE;
+		if (bExtensionsSupported && InSurface != VK_NULL_HANDLE)
 		{
 			VkSurfaceCapabilitiesKHR Capabilities;
 			std::vector<VkSurfaceFormatKHR> Formats;
@@ -253,7 +262,8 @@ namespace Vk
 		VkQueue InCommandQueue,
 		VkBuffer InSrcBuffer,
 		VkBuffer InDstBuffer,
-		VkDeviceSize InSize)
+		VkDeviceSize InSize,
+		VkDeviceSize InDstOffset)
 	{
 		VkCommandBufferAllocateInfo CommandBufferAllocInfo{};
 		CommandBufferAllocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
@@ -274,6 +284,7 @@ namespace Vk
 		}
 
 		VkBufferCopy CopyRegion{};
+		CopyRegion.dstOffset = InDstOffset;
 		CopyRegion.size = InSize;
 		vkCmdCopyBuffer(CommandBuffer, InSrcBuffer, InDstBuffer, 1, &CopyRegion);
 
@@ -516,4 +527,56 @@ namespace Vk
 
 		return ColorBlendAttachmentState;
 	}
+
+	VkSamplerCreateInfo GetSamplerCI()
+	{
+		VkSamplerCreateInfo SamplerCI{};
+		SamplerCI.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+		SamplerCI.magFilter = VK_FILTER_LINEAR;
+		SamplerCI.minFilter = VK_FILTER_LINEAR;
+		SamplerCI.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+		SamplerCI.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+		SamplerCI.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+		SamplerCI.mipLodBias = 0.0f;
+		SamplerCI.anisotropyEnable = VK_TRUE;
+		SamplerCI.maxAnisotropy = std::numeric_limits<float>::max();
+		SamplerCI.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+		SamplerCI.unnormalizedCoordinates = VK_FALSE;
+		SamplerCI.compareEnable = VK_FALSE;
+		SamplerCI.compareOp = VK_COMPARE_OP_ALWAYS;
+		SamplerCI.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+
+		return SamplerCI;
+	}
+
+	VkDescriptorUpdateTemplateEntry GetDescriptorUpdateTemplateEntry(uint32_t InBinding, VkDescriptorType InType, size_t InOffset)
+	{
+		VkDescriptorUpdateTemplateEntry Entry{};
+		Entry.dstBinding = InBinding;
+		Entry.dstArrayElement = 0;
+		Entry.descriptorCount = 1;
+		Entry.descriptorType = InType;
+		Entry.offset = InOffset;
+		Entry.stride = 0;
+
+		return Entry;
+	}
+
+	VkDescriptorUpdateTemplate CreateDescriptorUpdateTemplate(
+		VkDevice InDevice,
+		VkDescriptorSetLayout InLayout,
+		const std::vector<VkDescriptorUpdateTemplateEntry>& InEntries)
+	{
+		VkDescriptorUpdateTemplateCreateInfo UpdateTemplateCI{};
+		UpdateTemplateCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO;
+		UpdateTemplateCI.descriptorUpdateEntryCount = static_cast<uint32_t>(InEntries.size());
+		UpdateTemplateCI.pDescriptorUpdateEntries = InEntries.data();
+		UpdateTemplateCI.templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET;
+		UpdateTemplateCI.descriptorSetLayout = InLayout;
+
+		VkDescriptorUpdateTemplate UpdateTemplate = VK_NULL_HANDLE;
+		VK_ASSERT(vkCreateDescriptorUpdateTemplate(InDevice, &UpdateTemplateCI, nullptr, &UpdateTemplate));
+
+		return UpdateTemplate;
+	}
 }
@@ -55,7 +55,8 @@ namespace Vk
 		VkQueue InCommandQueue,
 		VkBuffer InSrcBuffer,
 		VkBuffer InDstBuffer,
-		VkDeviceSize InSize);
+		VkDeviceSize InSize,
+		VkDeviceSize InDstOffset = 0);
 
 	VkCommandBuffer BeginOneTimeCommandBuffer(VkDevice InDevice, VkCommandPool InCommandPool);
 
@@ -98,4 +99,13 @@ namespace Vk
 	VkPipelineDepthStencilStateCreateInfo GetDepthStencilStateCI();
 	VkPipelineColorBlendStateCreateInfo GetColorBlendStateCI();
 	VkPipelineColorBlendAttachmentState GetColorBlendAttachment();
+
+	// Trilinear, repeating and as anisotropic as the device allows once it goes through the sampler cache.
+	VkSamplerCreateInfo GetSamplerCI();
+
+	VkDescriptorUpdateTemplateEntry GetDescriptorUpdateTemplateEntry(uint32_t InBinding, VkDescriptorType InType, size_t InOffset);
+	VkDescriptorUpdateTemplate CreateDescriptorUpdateTemplate(
+		VkDevice InDevice,
+		VkDescriptorSetLayout InLayout,
+		const std::vector<VkDescriptorUpdateTemplateEntry>& InEntries);
 }
@@ -0,0 +1,157 @@
+#include "VulkanLatency.h"
+#include "VulkanContext.h"
+#include "VulkanHelpers.h"
+
+#include "Config.h"
+#include "CpuProfiler.h"
+
+#include <algorithm>
+
+static const int32_t DefaultLatencyStatsWindow = 240;
+
+// Bounds how long the waiter thread sits in vkWaitSemaphores before it checks whether it should stop.
+static const uint64_t LatencyWaitTimeoutNs = 100000000;
+
+static void GetWindowStats(const std::vector<double>& InTimes, size_t InNumSamples, double& OutAverage, double& OutMax, double& OutP99)
+{
+	std::vector<double> Sorted(InTimes.begin(), InTimes.begin() + InNumSamples);
+	std::sort(Sorted.begin(), Sorted.end());
+
+	double Total = 0.0;
+	for (double Time : Sorted)
+	{
+		Total += Time;
+	}
+
+	OutAverage = Total / InNumSamples;
+	OutMax = Sorted.back();
+	OutP99 = Sorted[std::min(InNumSamples - 1, static_cast<size_t>(InNumSamples * 0.99))];
+}
+
+FVulkanLatencyTracker::FVulkanLatencyTracker(FVulkanContext* InContext)
+	: FVulkanObject(InContext)
+	, bStopping(false)
+	, bEnabled(false)
+{
+	GConfig->Get("LatencyMode", bEnabled);
+
+	if (bEnabled == false)
+	{
+		return;
+	}
+
+	int32_t StatsWindow = DefaultLatencyStatsWindow;
+	GConfig->Get("LatencyStatsWindow", StatsWindow);
+	for (FLatencyWindow& Window : Windows)
+	{
+		Window.InputToSubmitTimes.assign(static_cast<size_t>(std::max(StatsWindow, 1)), 0.0);
+		Window.SubmitToPresentTimes.assign(Window.InputToSubmitTimes.size(), 0.0);
+	}
+
+	Thread = std::thread(&FVulkanLatencyTracker::Run, this);
+}
+
+void FVulkanLatencyTracker::Destroy()
+{
+	if (Thread.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> Lock(Mutex);
+			bStopping = true;
+		}
+		Condition.notify_one();
+
+		Thread.join();
+	}
+}
+
+void FVulkanLatencyTracker::RecordSubmit(uint64_t InTimelineValue, FClock::time_point InInputSampleTime, FClock::time_point InSubmitTime, EPresentProfile InPresentProfile)
+{
+	if (bEnabled == false)
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> Lock(Mutex);
+		Pending.push_back({ InTimelineValue, InInputSampleTime, InSubmitTime, InPresentProfile });
+	}
+	Condition.notify_one();
+}
+
+void FVulkanLatencyTracker::Run()
+{
+	CPU_PROFILE_THREAD("Latency Tracker");
+
+	VkDevice Device = Context->GetDevice();
+	VkSemaphore FrameTimeline = Context->GetFrameTimeline();
+
+	while (true)
+	{
+		FPendingFrame Frame;
+		{
+			std::unique_lock<std::mutex> Lock(Mutex);
+			Condition.wait(Lock, [this]() { return bStopping || Pending.empty() == false; });
+
+			if (bStopping)
+			{
+				return;
+			}
+
+			Frame = Pending.front();
+		}
+
+		VkSemaphoreWaitInfo WaitInfo{};
+		WaitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+		WaitInfo.semaphoreCount = 1;
+		WaitInfo.pSemaphores = &FrameTimeline;
+		WaitInfo.pValues = &Frame.TimelineValue;
+
+		VkResult Result = vkWaitSemaphores(Device, &WaitInfo, LatencyWaitTimeoutNs);
+		if (Result == VK_TIMEOUT)
+		{
+			continue;
+		}
+		VK_ASSERT(Result);
+
+		const FClock::time_point PresentTime = FClock::now();
+
+		std::lock_guard<std::mutex> Lock(Mutex);
+
+		FLatencyWindow& Window = Windows[static_cast<size_t>(Frame.PresentProfile)];
+
+		const size_t Index = static_cast<size_t>(Window.NumSamples % Window.InputToSubmitTimes.size());
+		Window.InputToSubmitTimes[Index] = std::chrono::duration<double, std::milli>(Frame.SubmitTime - Frame.InputSampleTime).count();
+		Window.SubmitToPresentTimes[Index] = std::chrono::duration<double, std::milli>(PresentTime - Frame.SubmitTime).count();
+		++Window.NumSamples;
+
+		Pending.pop_front();
+	}
+}
+
+FLatencyStats FVulkanLatencyTracker::GetStats() const
+{
+	return GetStats(Context->GetViewport()->GetPresentProfile());
+}
+
+FLatencyStats FVulkanLatencyTracker::GetStats(EPresentProfile InPresentProfile) const
+{
+	std::lock_guard<std::mutex> Lock(Mutex);
+
+	const FLatencyWindow& Window = Windows[static_cast<size_t>(InPresentProfile)];
+
+	FLatencyStats Stats;
+	Stats.NumSamples = Window.NumSamples;
+
+	const size_t NumWindowSamples = static_cast<size_t>(std::min<uint64_t>(Window.NumSamples, Window.InputToSubmitTimes.size()));
+	if (NumWindowSamples == 0)
+	{
+		return Stats;
+	}
+
+	// Until the window fills up, the samples are exactly the first NumWindowSamples entries.
+	GetWindowStats(Window.InputToSubmitTimes, NumWindowSamples, Stats.AverageInputToSubmitMs, Stats.MaxInputToSubmitMs, Stats.P99InputToSubmitMs);
+	GetWindowStats(Window.SubmitToPresentTimes, NumWindowSamples, Stats.AverageSubmitToPresentMs, Stats.MaxSubmitToPresentMs, Stats.P99SubmitToPresentMs);
+
+	return Stats;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "VulkanObject.h"
+#include "VulkanViewport.h"
+
+#include "vulkan/vulkan.h"
+
+#include <array>
+#include <deque>
+#include <mutex>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <condition_variable>
+
+struct FLatencyStats
+{
+	uint64_t NumSamples = 0;
+
+	// From the moment the camera input was read to the vkQueueSubmit that carries it.
+	double AverageInputToSubmitMs = 0.0;
+	double MaxInputToSubmitMs = 0.0;
+	double P99InputToSubmitMs = 0.0;
+
+	// From vkQueueSubmit to the moment the frame finished rendering and was released to the presentation engine.
+	double AverageSubmitToPresentMs = 0.0;
+	double MaxSubmitToPresentMs = 0.0;
+	double P99SubmitToPresentMs = 0.0;
+
+	double GetAverageTotalMs() const { return AverageInputToSubmitMs + AverageSubmitToPresentMs; }
+};
+
+// Latency measurement mode. Samples are kept per present profile so the profiles can be compared in one run.
+// Every submit is stamped with the time its camera input was sampled, and a waiter
+// thread blocks on the frame timeline to stamp when the GPU finishes the frame, which is when the
+// render-finished semaphore hands the image to the presentation engine. Scan-out itself is not observable
+// without VK_KHR_present_wait or VK_GOOGLE_display_timing, so the present figure is a lower bound.
+class FVulkanLatencyTracker : public FVulkanObject
+{
+public:
+	using FClock = std::chrono::steady_clock;
+
+	FVulkanLatencyTracker(class FVulkanContext* InContext);
+
+	virtual void Destroy() override;
+
+	bool IsEnabled() const { return bEnabled; }
+
+	void RecordSubmit(uint64_t InTimelineValue, FClock::time_point InInputSampleTime, FClock::time_point InSubmitTime, EPresentProfile InPresentProfile);
+
+	// Stats of the profile the viewport is currently presenting with.
+	FLatencyStats GetStats() const;
+	FLatencyStats GetStats(EPresentProfile InPresentProfile) const;
+
+protected:
+	void Run();
+
+	struct FPendingFrame
+	{
+		uint64_t TimelineValue;
+		FClock::time_point InputSampleTime;
+		FClock::time_point SubmitTime;
+		EPresentProfile PresentProfile;
+	};
+
+	// Rolling windows of the most recent frames, indexed by sample number.
+	struct FLatencyWindow
+	{
+		std::vector<double> InputToSubmitTimes;
+		std::vector<double> SubmitToPresentTimes;
+		uint64_t NumSamples = 0;
+	};
+
+protected:
+	std::thread Thread;
+	mutable std::mutex Mutex;
+	std::condition_variable Condition;
+	std::deque<FPendingFrame> Pending;
+	bool bStopping;
+
+	std::array<FLatencyWindow, static_cast<size_t>(EPresentProfile::Num)> Windows;
+
+	bool bEnabled;
+};
@@ -1,5 +1,6 @@
 #include "VulkanMaterial.h"
 #include "VulkanContext.h"
+#include "VulkanShaderCache.h"
 
 FVulkanMaterial::FVulkanMaterial(FVulkanContext* InContext)
 	: FVulkanObject(InContext)
@@ -17,8 +18,8 @@ bool FVulkanMaterial::LoadVS(const std::string& InFilename)
 		UnloadVS();
 	}
 
-	VS = Context->CreateObject<FVulkanShader>();
-	return VS->LoadFile(InFilename);
+	VS = Context->GetShaderCache()->Acquire(InFilename);
+	return VS != nullptr;
 }
 
 bool FVulkanMaterial::LoadFS(const std::string& InFilename)
@@ -28,8 +29,8 @@ bool FVulkanMaterial::LoadFS(const std::string& InFilename)
 		UnloadFS();
 	}
 
-	FS = Context->CreateObject<FVulkanShader>();
-	return FS->LoadFile(InFilename);
+	FS = Context->GetShaderCache()->Acquire(InFilename);
+	return FS != nullptr;
 }
 
 void FVulkanMaterial::UnloadVS()
@@ -39,7 +40,7 @@ void FVulkanMaterial::UnloadVS()
 		return;
 	}
 
-	Context->DestroyObject(VS);
+	Context->GetShaderCache()->Release(VS);
 	VS = nullptr;
 }
 
@@ -50,7 +51,7 @@ void FVulkanMaterial::UnloadFS()
 		return;
 	}
 
-	Context->DestroyObject(FS);
+	Context->GetShaderCache()->Release(FS);
 	FS = nullptr;
 }
 
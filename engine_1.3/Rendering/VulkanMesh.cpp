@@ -10,17 +10,7 @@
 FVulkanMesh::FVulkanMesh(FVulkanContext* InContext)
 	: FVulkanObject(InContext)
 	, MeshAsset(nullptr)
-	, VertexBuffer(nullptr)
-	, IndexBuffer(nullptr)
 {
-	VertexBuffer = InContext->CreateObject<FVulkanBuffer>();
-	VertexBuffer->SetUsage(VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
-	VertexBuffer->SetProperties(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-	IndexBuffer = InContext->CreateObject<FVulkanBuffer>();
-	IndexBuffer->SetUsage(VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
-	IndexBuffer->SetProperties(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
 	Material = InContext->CreateObject<FVulkanMaterial>();
 }
 
@@ -36,36 +26,46 @@ bool FVulkanMesh::Load(UMesh* InMesh)
 		return false;
 	}
 
-	if (VertexBuffer->GetHandle() != VK_NULL_HANDLE ||
-		IndexBuffer->GetHandle() != VK_NULL_HANDLE)
+	if (Geometry.IsValid())
 	{
 		Unload();
 	}
 
 	MeshAsset = InMesh;
 
-	const std::vector<FVertex>& Vertices = InMesh->GetVertices();
-	const std::vector<uint32_t>& Indices = InMesh->GetIndices();
+	FVulkanGeometryPool* GeometryPool = Context->GetGeometryPool();
+	if (GeometryPool == nullptr)
+	{
+		return false;
+	}
 
-	VertexBuffer->Load((uint8_t*)Vertices.data(), sizeof(FVertex) * Vertices.size());
-	IndexBuffer->Load((uint8_t*)Indices.data(), sizeof(uint32_t) * Indices.size());
+	GeometryPoolHandle = GeometryPool->GetObjectHandle();
 
-	return true;
+	return GeometryPool->Allocate(InMesh->GetVertices(), InMesh->GetIndices(), Geometry);
 }
 
 void FVulkanMesh::Unload()
 {
-	VkDevice Device = Context->GetDevice();
-
 	MeshAsset = nullptr;
 
-	if (VertexBuffer != nullptr)
+	FVulkanGeometryPool* GeometryPool = Context->ResolveObject<FVulkanGeometryPool>(GeometryPoolHandle);
+	if (GeometryPool != nullptr)
 	{
-		VertexBuffer->Unload();
+		GeometryPool->Free(Geometry);
 	}
 
-	if (IndexBuffer != nullptr)
-	{
-		IndexBuffer->Unload();
-	}
+	Geometry = FVulkanGeometryAllocation();
+	GeometryPoolHandle = FVulkanObjectHandle();
+}
+
+FVulkanBuffer* FVulkanMesh::GetVertexBuffer() const
+{
+	FVulkanGeometryPool* GeometryPool = Context->GetGeometryPool();
+	return GeometryPool != nullptr ? GeometryPool->GetVertexBuffer(Geometry.Page) : nullptr;
+}
+
+FVulkanBuffer* FVulkanMesh::GetIndexBuffer() const
+{
+	FVulkanGeometryPool* GeometryPool = Context->GetGeometryPool();
+	return GeometryPool != nullptr ? GeometryPool->GetIndexBuffer(Geometry.Page) : nullptr;
 }
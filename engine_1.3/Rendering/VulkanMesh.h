@@ -3,6 +3,7 @@
 #include "VulkanObject.h"
 #include "VulkanBuffer.h"
 #include "VulkanMaterial.h"
+#include "VulkanGeometryPool.h"
 
 class FVulkanMesh : public FVulkanObject
 {
@@ -14,8 +15,13 @@ public:
 	virtual bool Load(class UMesh* InMesh);
 	virtual void Unload();
 
-	FVulkanBuffer* GetVertexBuffer() const { return VertexBuffer; }
-	FVulkanBuffer* GetIndexBuffer() const { return IndexBuffer; }
+	FVulkanBuffer* GetVertexBuffer() const;
+	FVulkanBuffer* GetIndexBuffer() const;
+
+	uint32_t GetGeometryPage() const { return Geometry.Page; }
+	uint32_t GetFirstIndex() const { return Geometry.FirstIndex; }
+	uint32_t GetIndexCount() const { return Geometry.NumIndices; }
+	int32_t GetVertexOffset() const { return static_cast<int32_t>(Geometry.FirstVertex); }
 
 	FVulkanMaterial* GetMaterial() const { return Material; }
 	void SetMaterial(FVulkanMaterial* InMaterial) { Material = InMaterial; }
@@ -23,10 +29,11 @@ public:
 	class UMesh* GetMeshAsset() const { return MeshAsset; }
 	
 protected:
-	FVulkanBuffer* VertexBuffer;
-	FVulkanBuffer* IndexBuffer;
+	FVulkanGeometryAllocation Geometry;
+
+	// The pool may already be gone when the context tears down every live object.
+	FVulkanObjectHandle GeometryPoolHandle;
 	FVulkanMaterial* Material;
 
 	class UMesh* MeshAsset;
 };
-
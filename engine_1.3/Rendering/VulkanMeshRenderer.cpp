@@ -1,21 +1,28 @@
 #include "VulkanMeshRenderer.h"
 #include "VulkanContext.h"
 #include "VulkanHelpers.h"
+#include "VulkanDescriptorAllocator.h"
 #include "VulkanSwapchain.h"
 #include "VulkanRenderPass.h"
 #include "VulkanFramebuffer.h"
 #include "VulkanPipeline.h"
+#include "VulkanPipelineLibrary.h"
 #include "VulkanViewport.h"
 #include "VulkanSampler.h"
+#include "VulkanSamplerCache.h"
 #include "VulkanScene.h"
 #include "VulkanShader.h"
+#include "VulkanShaderCache.h"
 #include "VulkanMaterial.h"
 #include "VulkanModel.h"
 #include "VulkanMesh.h"
 #include "VulkanTexture.h"
 #include "VulkanLight.h"
+#include "VulkanGeometryPool.h"
+#include "VulkanGpuProfiler.h"
 
 #include "Utils.h"
+#include "CpuProfiler.h"
 #include "Config.h"
 #include "Mesh.h"
 
@@ -30,12 +37,26 @@
 #include <algorithm>
 #include <execution>
 #include <unordered_map>
+#include <tuple>
+#include <cstddef>
+
+static const uint32_t DefaultShadowMapSize = 2048;
+
+static const uint32_t FrameDescriptorSet = 0;
+static const uint32_t MaterialDescriptorSet = 1;
+
+// Constant IDs of base.frag's feature toggles. Bit N of a pipeline permutation key holds constant N.
+static const uint32_t AttenuationConstant = 0;
+static const uint32_t GammaCorrectionConstant = 1;
+static const uint32_t ToneMappingConstant = 2;
+static const uint32_t NumFeatureConstants = 3;
 
 struct FTransformBufferObject
 {
 	alignas(16) glm::mat4 View;
 	alignas(16) glm::mat4 Projection;
 	alignas(16) glm::vec3 CameraPosition;
+	alignas(16) glm::mat4 CameraView;
 };
 
 struct FLightBufferObject
@@ -54,25 +75,43 @@ struct FMaterialBufferObject
 	alignas(16) glm::vec4 Specular;
 };
 
-struct FDebugBufferObject
+// Source data for the descriptor update templates, one member per binding in binding order.
+struct FFrameDescriptorData
 {
-	alignas(4) bool bAttenuation;
-	alignas(4) bool bGammaCorrection;
-	alignas(4) bool bToneMapping;
+	VkDescriptorBufferInfo TransformBuffer;
+	VkDescriptorBufferInfo LightBuffer;
+	VkDescriptorImageInfo ShadowMap;
 };
 
-struct FInstanceBuffer
+struct FMaterialDescriptorData
 {
-	alignas(16) glm::mat4 Model;
-	alignas(16) glm::mat4 ModelView;
-	alignas(16) glm::mat4 NormalMatrix;
+	VkDescriptorBufferInfo MaterialBuffer;
+	VkDescriptorImageInfo BaseColor;
+	VkDescriptorImageInfo Normal;
 };
 
 FVulkanMeshRenderer::FVulkanMeshRenderer(FVulkanContext* InContext)
 	: FVulkanRenderer(InContext)
+	, ShadowPass(nullptr)
 	, BasePass(nullptr)
+	, ShadowDepthImage(nullptr)
+	, ShadowFramebuffer(nullptr)
+	, ShadowMapExtent({ DefaultShadowMapSize, DefaultShadowMapSize })
+	, ShadowPipeline(nullptr)
+	, FallbackPipeline(nullptr)
 	, TBNPipeline(nullptr)
-	, DescriptorSetLayout(VK_NULL_HANDLE)
+	, FrameDescriptorSetLayout(VK_NULL_HANDLE)
+	, MaterialDescriptorSetLayout(VK_NULL_HANDLE)
+	, FrameUpdateTemplate(VK_NULL_HANDLE)
+	, MaterialUpdateTemplate(VK_NULL_HANDLE)
+	, CurrentFrameDescriptorSet(VK_NULL_HANDLE)
+	, BoundGeometryPage(UINT32_MAX)
+	, BoundPipeline(nullptr)
+	, RequestedPermutation(0)
+	, DrawnPermutation(0)
+	, BoundMaterial(nullptr)
+	, CullingPass(nullptr)
+	, CullingGuardBand(0.0f)
 	, Sampler(nullptr)
 	, bInitialized(false)
 	, bEnableTBNVisualization(false)
@@ -80,13 +119,28 @@ FVulkanMeshRenderer::FVulkanMeshRenderer(FVulkanContext* InContext)
 	, bEnableGammaCorrection(false)
 	, bEnableToneMapping(false)
 {
+	bool bLateLatchCamera = false;
+	GConfig->Get("LateLatchCamera", bLateLatchCamera);
+	if (bLateLatchCamera)
+	{
+		GConfig->Get("LateLatchGuardBand", CullingGuardBand);
+	}
+
+	int32_t ShadowMapSize = static_cast<int32_t>(DefaultShadowMapSize);
+	GConfig->Get("ShadowMapSize", ShadowMapSize);
+	ShadowMapExtent.width = static_cast<uint32_t>(std::max(ShadowMapSize, 1));
+	ShadowMapExtent.height = ShadowMapExtent.width;
+
 	CreateRenderPasses();
 	CreateShadowDepthImage();
+	CreateShadowFramebuffer();
 	CreateFramebuffers();
 	CreateTextureSampler();
-	CreateDescriptorSetLayout();
+	CreateDescriptorSetLayouts();
+	CreateDescriptorUpdateTemplates();
 	CreateUniformBuffers();
 	CreateShadowPipeline();
+	CreateFallbackPipeline();
 	CreateTBNPipeline();
 }
 
@@ -98,28 +152,24 @@ void FVulkanMeshRenderer::Destroy()
 {
 	VkDevice Device = Context->GetDevice();
 
-	if (Context->IsValidObject(ShadowPass))
-	{
-		Context->DestroyObject(ShadowPass);
-	}
+	Context->DestroyObject(Context->ResolveObject(ShadowPassHandle));
+	Context->DestroyObject(Context->ResolveObject(BasePassHandle));
 
-	if (Context->IsValidObject(BasePass))
+	for (FVulkanObjectHandle FramebufferHandle : FramebufferHandles)
 	{
-		Context->DestroyObject(BasePass);
+		Context->DestroyObject(Context->ResolveObject(FramebufferHandle));
 	}
 
-	for (FVulkanFramebuffer* Framebuffer : Framebuffers)
-	{
-		if (Context->IsValidObject(Framebuffer))
-		{
-			Context->DestroyObject(Framebuffer);
-		}
-	}
+	Context->DestroyObject(ShadowFramebuffer);
+	ShadowFramebuffer = nullptr;
+
+	Context->DestroyObject(ShadowDepthImage);
+	ShadowDepthImage = nullptr;
 
-	if (TBNPipeline != nullptr)
+	if (CullingPass != nullptr)
 	{
-		Context->DestroyObject(TBNPipeline);
-		TBNPipeline = nullptr;
+		Context->DestroyObject(CullingPass);
+		CullingPass = nullptr;
 	}
 
 	for (FVulkanBuffer* TransformBuffer : TransformBuffers)
@@ -144,49 +194,34 @@ void FVulkanMeshRenderer::Destroy()
 	}
 	LightBuffers.clear();
 
-	for (FVulkanBuffer* MaterialBuffer : MaterialBuffers)
+	FVulkanDescriptorAllocator* DescriptorAllocator = Context->GetDescriptorAllocator();
+	for (auto& Pair : MaterialBindings)
 	{
-		if (MaterialBuffer == nullptr)
+		Context->DestroyObject(Pair.second.MaterialBuffer);
+		if (Pair.second.DescriptorSet != VK_NULL_HANDLE)
 		{
-			continue;
-		}
-
-		Context->DestroyObject(MaterialBuffer);
-	}
-	MaterialBuffers.clear();
-
-	for (FVulkanBuffer* DebugBuffer : DebugBuffers)
-	{
-		if (DebugBuffer == nullptr)
-		{
-			continue;
+			DescriptorAllocator->Free(Pair.second.DescriptorSet);
 		}
-
-		Context->DestroyObject(DebugBuffer);
 	}
-	DebugBuffers.clear();
+	MaterialBindings.clear();
 
-	if (Sampler != nullptr)
-	{
-		Context->DestroyObject(Sampler);
-		Sampler = nullptr;
-	}
+	vkDestroyDescriptorUpdateTemplate(Device, FrameUpdateTemplate, nullptr);
+	vkDestroyDescriptorUpdateTemplate(Device, MaterialUpdateTemplate, nullptr);
 
-	vkDestroyDescriptorSetLayout(Device, DescriptorSetLayout, nullptr);
+	vkDestroyDescriptorSetLayout(Device, FrameDescriptorSetLayout, nullptr);
+	vkDestroyDescriptorSetLayout(Device, MaterialDescriptorSetLayout, nullptr);
 }
 
 void FVulkanMeshRenderer::OnRecreateSwapchain()
 {
+	// Only the base pass renders into swapchain-sized attachments.
 	for (FVulkanFramebuffer* Framebuffer : Framebuffers)
 	{
-		if (Context->IsValidObject(Framebuffer))
-		{
-			Context->DestroyObject(Framebuffer);
-		}
+		Context->RetireObject(Framebuffer);
 	}
 	Framebuffers.clear();
+	FramebufferHandles.clear();
 
-	CreateShadowDepthImage();
 	CreateFramebuffers();
 }
 
@@ -221,10 +256,87 @@ void FVulkanMeshRenderer::GenerateInstancedDrawingInfo()
 	}
 }
 
+void FVulkanMeshRenderer::GenerateDrawBatches()
+{
+	ShadowBatches.clear();
+	BaseBatches.clear();
+
+	std::vector<FVulkanMesh*> Meshes;
+	Meshes.reserve(InstancedDrawingMap.size());
+	for (const auto& Pair : InstancedDrawingMap)
+	{
+		Meshes.push_back(Pair.first);
+	}
+
+	// Order the meshes so that everything sharing a geometry page, pipeline and material ends up
+	// with consecutive culling indices, and therefore consecutive indirect commands.
+	std::sort(Meshes.begin(), Meshes.end(), [this](FVulkanMesh* A, FVulkanMesh* B)
+	{
+		FVulkanPipeline* PipelineA = InstancedDrawingMap.at(A).Pipeline;
+		FVulkanPipeline* PipelineB = InstancedDrawingMap.at(B).Pipeline;
+
+		return std::make_tuple(A->GetGeometryPage(), PipelineA, A->GetMaterial(), A) <
+			std::make_tuple(B->GetGeometryPage(), PipelineB, B->GetMaterial(), B);
+	});
+
+	for (uint32_t MeshIdx = 0; MeshIdx < Meshes.size(); ++MeshIdx)
+	{
+		FVulkanMesh* Mesh = Meshes[MeshIdx];
+		FInstancedDrawingInfo& DrawingInfo = InstancedDrawingMap.at(Mesh);
+		DrawingInfo.MeshIndex = MeshIdx;
+
+		if (Mesh->GetVertexBuffer() == nullptr)
+		{
+			continue;
+		}
+
+		const uint32_t GeometryPage = Mesh->GetGeometryPage();
+
+		// Shadow depth only reads the transform buffer, so every mesh in a page can share one draw.
+		FDrawBatch* ShadowBatch = ShadowBatches.empty() ? nullptr : &ShadowBatches.back();
+		if (ShadowBatch == nullptr ||
+			ShadowBatch->GeometryPage != GeometryPage ||
+			ShadowBatch->FirstMesh + ShadowBatch->NumMeshes != MeshIdx)
+		{
+			FDrawBatch NewBatch;
+			NewBatch.Pipeline = ShadowPipeline;
+			NewBatch.Mesh = Mesh;
+			NewBatch.GeometryPage = GeometryPage;
+			NewBatch.FirstMesh = MeshIdx;
+			ShadowBatches.push_back(NewBatch);
+		}
+		ShadowBatches.back().NumMeshes++;
+
+		if (DrawingInfo.Pipeline == nullptr)
+		{
+			continue;
+		}
+
+		FDrawBatch* BaseBatch = BaseBatches.empty() ? nullptr : &BaseBatches.back();
+		if (BaseBatch == nullptr ||
+			BaseBatch->GeometryPage != GeometryPage ||
+			BaseBatch->Pipeline != DrawingInfo.Pipeline ||
+			BaseBatch->Mesh->GetMaterial() != Mesh->GetMaterial() ||
+			BaseBatch->FirstMesh + BaseBatch->NumMeshes != MeshIdx)
+		{
+			FDrawBatch NewBatch;
+			NewBatch.Pipeline = DrawingInfo.Pipeline;
+			NewBatch.Mesh = Mesh;
+			NewBatch.GeometryPage = GeometryPage;
+			NewBatch.FirstMesh = MeshIdx;
+			BaseBatches.push_back(NewBatch);
+		}
+		BaseBatches.back().NumMeshes++;
+	}
+}
+
 void FVulkanMeshRenderer::CreateRenderPasses()
 {
 	ShadowPass = FVulkanRenderPass::CreateShadowPass(Context);
 	BasePass = FVulkanRenderPass::CreateBasePass(Context);
+
+	ShadowPassHandle = ShadowPass->GetObjectHandle();
+	BasePassHandle = BasePass->GetObjectHandle();
 }
 
 void FVulkanMeshRenderer::CreateShadowDepthImage()
@@ -233,23 +345,9 @@ void FVulkanMeshRenderer::CreateShadowDepthImage()
 
 	VkFormat DepthFormat = Vk::FindDepthFormat(PhysicalDevice);
 
-	if (Context->IsValidObject(ShadowDepthImage))
-	{
-		Context->DestroyObject(ShadowDepthImage);
-		ShadowDepthImage = nullptr;
-	}
-
-	FVulkanViewport* Viewport = Context->GetViewport();
-	assert(Viewport != nullptr);
-
-	FVulkanSwapchain* Swapchain = Viewport->GetSwapchain();
-	assert(Swapchain != nullptr);
-
-	VkExtent2D SwapchainExtent = Swapchain->GetExtent();
-
 	ShadowDepthImage = Context->CreateObject<FVulkanImage>();
 	ShadowDepthImage->CreateImage(
-		{ SwapchainExtent.width, SwapchainExtent.height, 1 },
+		{ ShadowMapExtent.width, ShadowMapExtent.height, 1 },
 		1,
 		1,
 		DepthFormat,
@@ -272,6 +370,17 @@ void FVulkanMeshRenderer::CreateShadowDepthImage()
 	Vk::EndOneTimeCommandBuffer(Device, CommandPool, Context->GetGfxQueue(), CommandBuffer);
 }
 
+void FVulkanMeshRenderer::CreateShadowFramebuffer()
+{
+	std::vector<VkImageView> Attachments =
+	{
+		ShadowDepthImage->GetView()
+	};
+
+	ShadowFramebuffer = FVulkanFramebuffer::Create(
+		Context, ShadowPass->GetHandle(), Attachments, ShadowMapExtent);
+}
+
 void FVulkanMeshRenderer::CreateFramebuffers()
 {
 	FVulkanViewport* Viewport = Context->GetViewport();
@@ -285,20 +394,8 @@ void FVulkanMeshRenderer::CreateFramebuffers()
 
 	uint32_t ImageCount = Swapchain->GetImageCount();
 
-	ShadowFramebuffers.resize(Swapchain->GetImageCount());
-
-	for (size_t Idx = 0; Idx < ImageCount; ++Idx)
-	{
-		std::vector<VkImageView> Attachments =
-		{
-			ShadowDepthImage->GetView()
-		};
-
-		ShadowFramebuffers[Idx] = FVulkanFramebuffer::Create(
-			Context, ShadowPass->GetHandle(), Attachments, Swapchain->GetExtent());
-	}
-
 	Framebuffers.resize(ImageCount);
+	FramebufferHandles.resize(ImageCount);
 
 	for (size_t Idx = 0; Idx < ImageCount; ++Idx)
 	{
@@ -310,13 +407,18 @@ void FVulkanMeshRenderer::CreateFramebuffers()
 
 		Framebuffers[Idx] = FVulkanFramebuffer::Create(
 			Context, BasePass->GetHandle(), Attachments, Swapchain->GetExtent());
+		FramebufferHandles[Idx] = Framebuffers[Idx]->GetObjectHandle();
 	}
 }
 
-void FVulkanMeshRenderer::CreateDescriptorSetLayout()
+void FVulkanMeshRenderer::CreateDescriptorSetLayouts()
 {
 	VkDevice Device = Context->GetDevice();
 
+	// Every texture is sampled the same way, so the sampler is baked into the layouts and the descriptor
+	// writes only carry image views.
+	const VkSampler ImmutableSampler = Sampler->GetSampler();
+
 	VkDescriptorSetLayoutBinding TransformBufferBinding{};
 	TransformBufferBinding.descriptorCount = 1;
 	TransformBufferBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
@@ -329,63 +431,102 @@ void FVulkanMeshRenderer::CreateDescriptorSetLayout()
 	LightBufferBinding.pImmutableSamplers = nullptr;
 	LightBufferBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
 
+	VkDescriptorSetLayoutBinding ShadowSamplerBinding{};
+	ShadowSamplerBinding.descriptorCount = 1;
+	ShadowSamplerBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	ShadowSamplerBinding.pImmutableSamplers = &ImmutableSampler;
+	ShadowSamplerBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
 	VkDescriptorSetLayoutBinding MaterialBufferBinding{};
 	MaterialBufferBinding.descriptorCount = 1;
 	MaterialBufferBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
 	MaterialBufferBinding.pImmutableSamplers = nullptr;
 	MaterialBufferBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
 
-	VkDescriptorSetLayoutBinding DebugBufferBinding{};
-	DebugBufferBinding.descriptorCount = 1;
-	DebugBufferBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-	DebugBufferBinding.pImmutableSamplers = nullptr;
-	DebugBufferBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-
 	VkDescriptorSetLayoutBinding BaseColorSamplerBinding{};
 	BaseColorSamplerBinding.descriptorCount = 1;
 	BaseColorSamplerBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	BaseColorSamplerBinding.pImmutableSamplers = nullptr;
+	BaseColorSamplerBinding.pImmutableSamplers = &ImmutableSampler;
 	BaseColorSamplerBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
 
 	VkDescriptorSetLayoutBinding NormalSamplerBinding{};
 	NormalSamplerBinding.descriptorCount = 1;
 	NormalSamplerBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	NormalSamplerBinding.pImmutableSamplers = nullptr;
+	NormalSamplerBinding.pImmutableSamplers = &ImmutableSampler;
 	NormalSamplerBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
 
-	VkDescriptorSetLayoutBinding ShadowSamplerBinding{};
-	ShadowSamplerBinding.descriptorCount = 1;
-	ShadowSamplerBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	ShadowSamplerBinding.pImmutableSamplers = nullptr;
-	ShadowSamplerBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+	struct FDescriptorSetLayoutCreateInfo
+	{
+		std::vector<VkDescriptorSetLayoutBinding> Bindings;
+		VkDescriptorSetLayout& TargetLayout;
+	};
 
-	std::vector<VkDescriptorSetLayoutBinding> Bindings =
+	std::vector<FDescriptorSetLayoutCreateInfo> DescriptorSetLayoutCIs =
 	{
-		TransformBufferBinding,
-		LightBufferBinding,
-		MaterialBufferBinding,
-		DebugBufferBinding,
-		BaseColorSamplerBinding,
-		NormalSamplerBinding,
-		ShadowSamplerBinding
+		{ { TransformBufferBinding, LightBufferBinding, ShadowSamplerBinding }, FrameDescriptorSetLayout },
+		{ { MaterialBufferBinding, BaseColorSamplerBinding, NormalSamplerBinding }, MaterialDescriptorSetLayout }
 	};
 
-	for (int Idx = 0; Idx < Bindings.size(); ++Idx)
+	for (FDescriptorSetLayoutCreateInfo& CI : DescriptorSetLayoutCIs)
 	{
-		Bindings[Idx].binding = Idx;
+		for (int Idx = 0; Idx < CI.Bindings.size(); ++Idx)
+		{
+			CI.Bindings[Idx].binding = Idx;
+		}
+
+		VkDescriptorSetLayoutCreateInfo DescriptorSetLayoutCI{};
+		DescriptorSetLayoutCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		DescriptorSetLayoutCI.bindingCount = static_cast<uint32_t>(CI.Bindings.size());
+		DescriptorSetLayoutCI.pBindings = CI.Bindings.data();
+
+		VK_ASSERT(vkCreateDescriptorSetLayout(Device, &DescriptorSetLayoutCI, nullptr, &CI.TargetLayout));
 	}
+}
 
-	VkDescriptorSetLayoutCreateInfo DescriptorSetLayoutCI{};
-	DescriptorSetLayoutCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-	DescriptorSetLayoutCI.bindingCount = static_cast<uint32_t>(Bindings.size());
-	DescriptorSetLayoutCI.pBindings = Bindings.data();
+void FVulkanMeshRenderer::CreateDescriptorUpdateTemplates()
+{
+	VkDevice Device = Context->GetDevice();
 
-	VK_ASSERT(vkCreateDescriptorSetLayout(Device, &DescriptorSetLayoutCI, nullptr, &DescriptorSetLayout));
+	std::vector<VkDescriptorUpdateTemplateEntry> FrameEntries =
+	{
+		Vk::GetDescriptorUpdateTemplateEntry(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, offsetof(FFrameDescriptorData, TransformBuffer)),
+		Vk::GetDescriptorUpdateTemplateEntry(1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, offsetof(FFrameDescriptorData, LightBuffer)),
+		Vk::GetDescriptorUpdateTemplateEntry(2, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, offsetof(FFrameDescriptorData, ShadowMap))
+	};
+	FrameUpdateTemplate = Vk::CreateDescriptorUpdateTemplate(Device, FrameDescriptorSetLayout, FrameEntries);
+
+	std::vector<VkDescriptorUpdateTemplateEntry> MaterialEntries =
+	{
+		Vk::GetDescriptorUpdateTemplateEntry(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, offsetof(FMaterialDescriptorData, MaterialBuffer)),
+		Vk::GetDescriptorUpdateTemplateEntry(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, offsetof(FMaterialDescriptorData, BaseColor)),
+		Vk::GetDescriptorUpdateTemplateEntry(2, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, offsetof(FMaterialDescriptorData, Normal))
+	};
+	MaterialUpdateTemplate = Vk::CreateDescriptorUpdateTemplate(Device, MaterialDescriptorSetLayout, MaterialEntries);
+}
+
+void FVulkanMeshRenderer::GetGraphicsPipelineDesc(VkRenderPass InRenderPass, FGraphicsPipelineDesc& OutDesc)
+{
+	GetVertexInputBindings(OutDesc.VertexBindings);
+	GetVertexInputAttributes(OutDesc.VertexAttributes);
+
+	OutDesc.SetLayouts.resize(2);
+	OutDesc.SetLayouts[FrameDescriptorSet] = FrameDescriptorSetLayout;
+	OutDesc.SetLayouts[MaterialDescriptorSet] = MaterialDescriptorSetLayout;
+
+	OutDesc.RenderPass = InRenderPass;
 }
 
 void FVulkanMeshRenderer::CreateGraphicsPipelines()
 {
-	VkDevice Device = Context->GetDevice();
+	FVulkanPipelineLibrary* PipelineLibrary = Context->GetPipelineLibrary();
+
+	FGraphicsPipelineDesc Desc;
+	GetGraphicsPipelineDesc(BasePass->GetHandle(), Desc);
+
+	for (uint32_t Idx = 0; Idx < NumFeatureConstants; ++Idx)
+	{
+		Desc.SpecializationConstants.push_back((RequestedPermutation >> Idx) & 1);
+	}
 
 	for (auto& Pair : InstancedDrawingMap)
 	{
@@ -398,8 +539,6 @@ void FVulkanMeshRenderer::CreateGraphicsPipelines()
 			continue;
 		}
 
-		FVulkanPipeline* Pipeline = Context->CreateObject<FVulkanPipeline>();
-
 		FVulkanShader* VS = Material->GetVS();
 		FVulkanShader* FS = Material->GetFS();
 		if (VS == nullptr || FS == nullptr)
@@ -407,240 +546,126 @@ void FVulkanMeshRenderer::CreateGraphicsPipelines()
 			continue;
 		}
 
-		Pipeline->SetVertexShader(VS);
-		Pipeline->SetFragmentShader(FS);
-
-		VkPipelineShaderStageCreateInfo VertexShaderStageCI{};
-		VertexShaderStageCI.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-		VertexShaderStageCI.stage = VK_SHADER_STAGE_VERTEX_BIT;
-		VertexShaderStageCI.module = VS->GetModule();
-		VertexShaderStageCI.pName = "main";
-
-		VkPipelineShaderStageCreateInfo FragmentShaderStageCI{};
-		FragmentShaderStageCI.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-		FragmentShaderStageCI.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-		FragmentShaderStageCI.module = FS->GetModule();
-		FragmentShaderStageCI.pName = "main";
-
-		std::array<VkPipelineShaderStageCreateInfo, 2> ShaderStageCIs = { VertexShaderStageCI, FragmentShaderStageCI };
-
-		std::vector<VkVertexInputBindingDescription> VertexInputBindingDescs;
-		std::vector<VkVertexInputAttributeDescription> VertexInputAttributeDescs;
-		GetVertexInputBindings(VertexInputBindingDescs);
-		GetVertexInputAttributes(VertexInputAttributeDescs);
-
-		VkPipelineVertexInputStateCreateInfo VertexInputStateCI = Vk::GetVertexInputStateCI(VertexInputBindingDescs, VertexInputAttributeDescs);
-		VkPipelineInputAssemblyStateCreateInfo InputAssemblyStateCI = Vk::GetInputAssemblyStateCI();
-		VkPipelineViewportStateCreateInfo ViewportStateCI = Vk::GetViewportStateCI();
-		VkPipelineRasterizationStateCreateInfo RasterizerCI = Vk::GetRasterizationStateCI();
-		VkPipelineMultisampleStateCreateInfo MultisampleStateCI = Vk::GetMultisampleStateCI();
-		VkPipelineDepthStencilStateCreateInfo DepthStencilStateCI = Vk::GetDepthStencilStateCI();
-
-		VkPipelineColorBlendAttachmentState ColorBlendAttachmentState = Vk::GetColorBlendAttachment();
-		VkPipelineColorBlendStateCreateInfo ColorBlendStateCI = Vk::GetColorBlendStateCI();
-		ColorBlendStateCI.pAttachments = &ColorBlendAttachmentState;
-
-		std::vector<VkDynamicState> DynamicStates = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
-
-		VkPipelineDynamicStateCreateInfo DynamicStateCI{};
-		DynamicStateCI.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
-		DynamicStateCI.dynamicStateCount = static_cast<uint32_t>(DynamicStates.size());
-		DynamicStateCI.pDynamicStates = DynamicStates.data();
-
-		VkPipelineLayoutCreateInfo PipelineLayoutCI{};
-		PipelineLayoutCI.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-		PipelineLayoutCI.setLayoutCount = 1;
-		PipelineLayoutCI.pSetLayouts = &DescriptorSetLayout;
-
-		Pipeline->CreateLayout(PipelineLayoutCI);
-
-		VkGraphicsPipelineCreateInfo PipelineCI{};
-		PipelineCI.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-		PipelineCI.stageCount = static_cast<uint32_t>(ShaderStageCIs.size());
-		PipelineCI.pStages = ShaderStageCIs.data();
-		PipelineCI.pVertexInputState = &VertexInputStateCI;
-		PipelineCI.pInputAssemblyState = &InputAssemblyStateCI;
-		PipelineCI.pViewportState = &ViewportStateCI;
-		PipelineCI.pRasterizationState = &RasterizerCI;
-		PipelineCI.pDepthStencilState = &DepthStencilStateCI;
-		PipelineCI.pMultisampleState = &MultisampleStateCI;
-		PipelineCI.pColorBlendState = &ColorBlendStateCI;
-		PipelineCI.pDynamicState = &DynamicStateCI;
-		PipelineCI.layout = Pipeline->GetLayout();
-		PipelineCI.renderPass = BasePass->GetHandle();
-		PipelineCI.subpass = 0;
-		PipelineCI.basePipelineHandle = VK_NULL_HANDLE;
-
-		Pipeline->CreatePipeline(PipelineCI);
-
-		DrawingInfo.Pipeline = Pipeline;
+		// Materials that only differ in their parameters describe the same pipeline and get the same one back.
+		// It compiles in the background; meshes draw with the fallback pipeline until it is ready.
+		Desc.VS = VS;
+		Desc.FS = FS;
+
+		DrawingInfo.Pipeline = PipelineLibrary->RequestGraphicsPipeline(Desc);
+	}
+}
+
+uint32_t FVulkanMeshRenderer::GetPermutationKey() const
+{
+	uint32_t Key = 0;
+	Key |= (bEnableAttenuation ? 1U : 0U) << AttenuationConstant;
+	Key |= (bEnableGammaCorrection ? 1U : 0U) << GammaCorrectionConstant;
+	Key |= (bEnableToneMapping ? 1U : 0U) << ToneMappingConstant;
+
+	return Key;
+}
+
+void FVulkanMeshRenderer::UpdatePipelinePermutation()
+{
+	const uint32_t Permutation = GetPermutationKey();
+	if (Permutation != RequestedPermutation)
+	{
+		// Variants seen before are library hits; new ones start compiling in the background.
+		RequestedPermutation = Permutation;
+		CreateGraphicsPipelines();
+	}
+
+	if (DrawnPermutation == RequestedPermutation)
+	{
+		return;
+	}
+
+	// Keep drawing the previous variants until every new one has compiled, so toggling a feature never
+	// drops meshes to the fallback pipeline for a few frames.
+	for (const auto& Pair : InstancedDrawingMap)
+	{
+		if (Pair.second.Pipeline != nullptr && Pair.second.Pipeline->IsReady() == false)
+		{
+			return;
+		}
+	}
+
+	// Meshes that shared a pipeline in one permutation share it in every other, so the batches stay as they are.
+	for (FDrawBatch& Batch : BaseBatches)
+	{
+		Batch.Pipeline = InstancedDrawingMap.at(Batch.Mesh).Pipeline;
 	}
+	DrawnPermutation = RequestedPermutation;
 }
 
 void FVulkanMeshRenderer::CreateShadowPipeline()
 {
-	VkDevice Device = Context->GetDevice();
+	std::string ShaderDirectory;
+	GConfig->Get("ShaderDirectory", ShaderDirectory);
+
+	FVulkanShaderCache* ShaderCache = Context->GetShaderCache();
+	FVulkanShader* VS = ShaderCache->Acquire(ShaderDirectory + "shadow.vert.spv");
+
+	// Only set 0 is read here, but sharing the material pipelines' set layouts keeps the pipeline layouts
+	// compatible, so the sets bound for one stay valid after switching to another.
+	FGraphicsPipelineDesc Desc;
+	GetGraphicsPipelineDesc(ShadowPass->GetHandle(), Desc);
+	Desc.VS = VS;
+
+	ShadowPipeline = Context->GetPipelineLibrary()->GetGraphicsPipeline(Desc);
 
+	// The library holds its own references for as long as it keeps the pipeline.
+	ShaderCache->Release(VS);
+}
+
+void FVulkanMeshRenderer::CreateFallbackPipeline()
+{
 	std::string ShaderDirectory;
 	GConfig->Get("ShaderDirectory", ShaderDirectory);
 
-	FVulkanShader* VS = Context->CreateObject<FVulkanShader>();
-	VS->LoadFile(ShaderDirectory + "shadow.vert.spv");
-
-	ShadowPipeline = Context->CreateObject<FVulkanPipeline>();
-	ShadowPipeline->SetVertexShader(VS);
-	ShadowPipeline->SetFragmentShader(nullptr);
-
-	VkPipelineShaderStageCreateInfo VertexShaderStageCI{};
-	VertexShaderStageCI.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-	VertexShaderStageCI.stage = VK_SHADER_STAGE_VERTEX_BIT;
-	VertexShaderStageCI.module = VS->GetModule();
-	VertexShaderStageCI.pName = "main";
-
-	std::array<VkPipelineShaderStageCreateInfo, 1> ShaderStageCIs = { VertexShaderStageCI };
-
-	std::vector<VkVertexInputBindingDescription> VertexInputBindingDescs;
-	std::vector<VkVertexInputAttributeDescription> VertexInputAttributeDescs;
-	GetVertexInputBindings(VertexInputBindingDescs);
-	GetVertexInputAttributes(VertexInputAttributeDescs);
-
-	VkPipelineVertexInputStateCreateInfo VertexInputStateCI = Vk::GetVertexInputStateCI(VertexInputBindingDescs, VertexInputAttributeDescs);
-	VkPipelineInputAssemblyStateCreateInfo InputAssemblyStateCI = Vk::GetInputAssemblyStateCI();
-	VkPipelineViewportStateCreateInfo ViewportStateCI = Vk::GetViewportStateCI();
-	VkPipelineRasterizationStateCreateInfo RasterizerCI = Vk::GetRasterizationStateCI();
-	VkPipelineMultisampleStateCreateInfo MultisampleStateCI = Vk::GetMultisampleStateCI();
-	VkPipelineDepthStencilStateCreateInfo DepthStencilStateCI = Vk::GetDepthStencilStateCI();
-
-	VkPipelineColorBlendAttachmentState ColorBlendAttachmentState = Vk::GetColorBlendAttachment();
-	VkPipelineColorBlendStateCreateInfo ColorBlendStateCI = Vk::GetColorBlendStateCI();
-	ColorBlendStateCI.pAttachments = &ColorBlendAttachmentState;
-
-	std::vector<VkDynamicState> DynamicStates = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
-
-	VkPipelineDynamicStateCreateInfo DynamicStateCI{};
-	DynamicStateCI.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
-	DynamicStateCI.dynamicStateCount = static_cast<uint32_t>(DynamicStates.size());
-	DynamicStateCI.pDynamicStates = DynamicStates.data();
-
-	VkPipelineLayoutCreateInfo PipelineLayoutCI{};
-	PipelineLayoutCI.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-	PipelineLayoutCI.setLayoutCount = 1;
-	PipelineLayoutCI.pSetLayouts = &DescriptorSetLayout;
-
-	ShadowPipeline->CreateLayout(PipelineLayoutCI);
-
-	VkGraphicsPipelineCreateInfo PipelineCI{};
-	PipelineCI.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-	PipelineCI.stageCount = static_cast<uint32_t>(ShaderStageCIs.size());
-	PipelineCI.pStages = ShaderStageCIs.data();
-	PipelineCI.pVertexInputState = &VertexInputStateCI;
-	PipelineCI.pInputAssemblyState = &InputAssemblyStateCI;
-	PipelineCI.pViewportState = &ViewportStateCI;
-	PipelineCI.pRasterizationState = &RasterizerCI;
-	PipelineCI.pDepthStencilState = &DepthStencilStateCI;
-	PipelineCI.pMultisampleState = &MultisampleStateCI;
-	PipelineCI.pColorBlendState = &ColorBlendStateCI;
-	PipelineCI.pDynamicState = &DynamicStateCI;
-	PipelineCI.layout = ShadowPipeline->GetLayout();
-	PipelineCI.renderPass = ShadowPass->GetHandle();
-	PipelineCI.subpass = 0;
-	PipelineCI.basePipelineHandle = VK_NULL_HANDLE;
-
-	ShadowPipeline->CreatePipeline(PipelineCI);
+	// The unlit light source shaders are about the cheapest thing that still shows the geometry in place.
+	FVulkanShaderCache* ShaderCache = Context->GetShaderCache();
+	FVulkanShader* VS = ShaderCache->Acquire(ShaderDirectory + "lightSource.vert.spv");
+	FVulkanShader* FS = ShaderCache->Acquire(ShaderDirectory + "lightSource.frag.spv");
+
+	FGraphicsPipelineDesc Desc;
+	GetGraphicsPipelineDesc(BasePass->GetHandle(), Desc);
+	Desc.VS = VS;
+	Desc.FS = FS;
+
+	FallbackPipeline = Context->GetPipelineLibrary()->GetGraphicsPipeline(Desc);
+
+	ShaderCache->Release(VS);
+	ShaderCache->Release(FS);
 }
 
 void FVulkanMeshRenderer::CreateTBNPipeline()
 {
-	VkDevice Device = Context->GetDevice();
-
 	std::string ShaderDirectory;
 	GConfig->Get("ShaderDirectory", ShaderDirectory);
 
-	FVulkanShader* VS = Context->CreateObject<FVulkanShader>();
-	VS->LoadFile(ShaderDirectory + "visualizeTBN.vert.spv");
-	FVulkanShader* GS = Context->CreateObject<FVulkanShader>();
-	GS->LoadFile(ShaderDirectory + "visualizeTBN.geom.spv");
-	FVulkanShader* FS = Context->CreateObject<FVulkanShader>();
-	FS->LoadFile(ShaderDirectory + "visualizeTBN.frag.spv");
-
-	TBNPipeline = Context->CreateObject<FVulkanPipeline>();
-	TBNPipeline->SetVertexShader(VS);
-	TBNPipeline->SetGeometryShader(GS);
-	TBNPipeline->SetFragmentShader(FS);
-
-	VkPipelineShaderStageCreateInfo VertexShaderStageCI{};
-	VertexShaderStageCI.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-	VertexShaderStageCI.stage = VK_SHADER_STAGE_VERTEX_BIT;
-	VertexShaderStageCI.module = VS->GetModule();
-	VertexShaderStageCI.pName = "main";
-
-	VkPipelineShaderStageCreateInfo GeometryShaderStageCI{};
-	GeometryShaderStageCI.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-	GeometryShaderStageCI.stage = VK_SHADER_STAGE_GEOMETRY_BIT;
-	GeometryShaderStageCI.module = GS->GetModule();
-	GeometryShaderStageCI.pName = "main";
-
-	VkPipelineShaderStageCreateInfo FragmentShaderStageCI{};
-	FragmentShaderStageCI.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-	FragmentShaderStageCI.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-	FragmentShaderStageCI.module = FS->GetModule();
-	FragmentShaderStageCI.pName = "main";
-
-	std::array<VkPipelineShaderStageCreateInfo, 3> ShaderStageCIs = { VertexShaderStageCI, GeometryShaderStageCI, FragmentShaderStageCI };
-
-	std::vector<VkVertexInputBindingDescription> VertexInputBindingDescs;
-	std::vector<VkVertexInputAttributeDescription> VertexInputAttributeDescs;
-	GetVertexInputBindings(VertexInputBindingDescs);
-	GetVertexInputAttributes(VertexInputAttributeDescs);
-
-	VkPipelineVertexInputStateCreateInfo VertexInputStateCI = Vk::GetVertexInputStateCI(VertexInputBindingDescs, VertexInputAttributeDescs);
-	VkPipelineInputAssemblyStateCreateInfo InputAssemblyStateCI = Vk::GetInputAssemblyStateCI();
-	VkPipelineViewportStateCreateInfo ViewportStateCI = Vk::GetViewportStateCI();
-	VkPipelineRasterizationStateCreateInfo RasterizerCI = Vk::GetRasterizationStateCI();
-	VkPipelineMultisampleStateCreateInfo MultisampleStateCI = Vk::GetMultisampleStateCI();
-	VkPipelineDepthStencilStateCreateInfo DepthStencilStateCI = Vk::GetDepthStencilStateCI();
-
-	VkPipelineColorBlendAttachmentState ColorBlendAttachmentState = Vk::GetColorBlendAttachment();
-	VkPipelineColorBlendStateCreateInfo ColorBlendStateCI = Vk::GetColorBlendStateCI();
-	ColorBlendStateCI.pAttachments = &ColorBlendAttachmentState;
-
-	std::vector<VkDynamicState> DynamicStates = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
-
-	VkPipelineDynamicStateCreateInfo DynamicStateCI{};
-	DynamicStateCI.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
-	DynamicStateCI.dynamicStateCount = static_cast<uint32_t>(DynamicStates.size());
-	DynamicStateCI.pDynamicStates = DynamicStates.data();
-
-	VkPipelineLayoutCreateInfo PipelineLayoutCI{};
-	PipelineLayoutCI.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-	PipelineLayoutCI.setLayoutCount = 1;
-	PipelineLayoutCI.pSetLayouts = &DescriptorSetLayout;
-
-	TBNPipeline->CreateLayout(PipelineLayoutCI);
-
-	VkGraphicsPipelineCreateInfo PipelineCI{};
-	PipelineCI.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-	PipelineCI.stageCount = static_cast<uint32_t>(ShaderStageCIs.size());
-	PipelineCI.pStages = ShaderStageCIs.data();
-	PipelineCI.pVertexInputState = &VertexInputStateCI;
-	PipelineCI.pInputAssemblyState = &InputAssemblyStateCI;
-	PipelineCI.pViewportState = &ViewportStateCI;
-	PipelineCI.pRasterizationState = &RasterizerCI;
-	PipelineCI.pDepthStencilState = &DepthStencilStateCI;
-	PipelineCI.pMultisampleState = &MultisampleStateCI;
-	PipelineCI.pColorBlendState = &ColorBlendStateCI;
-	PipelineCI.pDynamicState = &DynamicStateCI;
-	PipelineCI.layout = TBNPipeline->GetLayout();
-	PipelineCI.renderPass = BasePass->GetHandle();
-	PipelineCI.subpass = 0;
-	PipelineCI.basePipelineHandle = VK_NULL_HANDLE;
-
-	TBNPipeline->CreatePipeline(PipelineCI);
+	FVulkanShaderCache* ShaderCache = Context->GetShaderCache();
+	FVulkanShader* VS = ShaderCache->Acquire(ShaderDirectory + "visualizeTBN.vert.spv");
+	FVulkanShader* GS = ShaderCache->Acquire(ShaderDirectory + "visualizeTBN.geom.spv");
+	FVulkanShader* FS = ShaderCache->Acquire(ShaderDirectory + "visualizeTBN.frag.spv");
+
+	FGraphicsPipelineDesc Desc;
+	GetGraphicsPipelineDesc(BasePass->GetHandle(), Desc);
+	Desc.VS = VS;
+	Desc.GS = GS;
+	Desc.FS = FS;
+
+	// Only a debug view, so it is simply left out until it has compiled.
+	TBNPipeline = Context->GetPipelineLibrary()->RequestGraphicsPipeline(Desc);
+
+	ShaderCache->Release(VS);
+	ShaderCache->Release(GS);
+	ShaderCache->Release(FS);
 }
 
 void FVulkanMeshRenderer::CreateTextureSampler()
 {
-	Sampler = Context->CreateObject<FVulkanSampler>();
+	Sampler = Context->GetSamplerCache()->GetSampler(Vk::GetSamplerCI());
 }
 
 void FVulkanMeshRenderer::CreateUniformBuffers()
@@ -657,9 +682,7 @@ void FVulkanMeshRenderer::CreateUniformBuffers()
 	std::vector<FUniformBufferCreateInfo> UniformBufferCIs =
 	{
 		{ sizeof(FTransformBufferObject), TransformBuffers },
-		{ sizeof(FLightBufferObject), LightBuffers },
-		{ sizeof(FMaterialBufferObject), MaterialBuffers },
-		{ sizeof(FDebugBufferObject), DebugBuffers }
+		{ sizeof(FLightBufferObject), LightBuffers }
 	};
 
 	const uint32_t MaxConcurrentFrames = Context->GetMaxConcurrentFrames();
@@ -678,60 +701,80 @@ void FVulkanMeshRenderer::CreateUniformBuffers()
 	}
 }
 
-void FVulkanMeshRenderer::CreateInstanceBuffers()
+void FVulkanMeshRenderer::CreateCullingPass()
 {
-	VkPhysicalDevice PhysicalDevice = Context->GetPhysicalDevice();
-	VkDevice Device = Context->GetDevice();
+	std::vector<FCullingMeshDesc> MeshDescs(InstancedDrawingMap.size());
 
 	for (auto& Pair : InstancedDrawingMap)
 	{
 		FVulkanMesh* Mesh = Pair.first;
-		std::vector<FVulkanBuffer*>& InstanceBuffers = Pair.second.InstanceBuffers;
-		std::vector<FVulkanModel*>& Models = Pair.second.Models;
+		FInstancedDrawingInfo& DrawingInfo = Pair.second;
+
+		const FMeshBounds& Bounds = Mesh->GetMeshAsset()->GetBounds();
+
+		FCullingMeshDesc& MeshDesc = MeshDescs[DrawingInfo.MeshIndex];
+		MeshDesc.NumInstances = static_cast<uint32_t>(DrawingInfo.Models.size());
+		MeshDesc.BoundingSphere = glm::vec4(Bounds.Center, Bounds.Radius);
+
+		FCullingMeshDesc::FLod Lod;
+		Lod.FirstIndex = Mesh->GetFirstIndex();
+		Lod.IndexCount = Mesh->GetIndexCount();
+		Lod.VertexOffset = Mesh->GetVertexOffset();
+		MeshDesc.Lods.push_back(Lod);
+	}
+
+	CullingPass = Context->CreateObject<FVulkanCullingPass>();
+	CullingPass->Build(MeshDescs);
+
+	ModelObjectIndices.clear();
 
-		uint32_t InstanceBufferSize = static_cast<uint32_t>(sizeof(FInstanceBuffer) * Models.size());
+	for (const auto& Pair : InstancedDrawingMap)
+	{
+		const FInstancedDrawingInfo& DrawingInfo = Pair.second;
+		const std::vector<FVulkanModel*>& Models = DrawingInfo.Models;
 
-		const uint32_t MaxConcurrentFrames = Context->GetMaxConcurrentFrames();
+		uint32_t FirstObject = CullingPass->GetFirstObject(DrawingInfo.MeshIndex);
 
-		InstanceBuffers.resize(MaxConcurrentFrames);
-		for (uint32_t Idx = 0; Idx < MaxConcurrentFrames; ++Idx)
+		for (uint32_t Idx = 0; Idx < Models.size(); ++Idx)
 		{
-			InstanceBuffers[Idx] = Context->CreateObject<FVulkanBuffer>();
-			InstanceBuffers[Idx]->SetUsage(VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
-			InstanceBuffers[Idx]->SetProperties(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-			InstanceBuffers[Idx]->Allocate(InstanceBufferSize);
-			InstanceBuffers[Idx]->Map();
+			ModelObjectIndices[Models[Idx]] = FirstObject + Idx;
+			CullingPass->SetObjectTransform(FirstObject + Idx, Models[Idx]->GetModelMatrix());
 		}
-
-		UpdateInstanceBuffer(Mesh);
 	}
 }
 
 void FVulkanMeshRenderer::CreateDescriptorSets()
 {
-	VkDevice Device = Context->GetDevice();
-	VkDescriptorPool DescriptorPool = Context->GetDescriptorPool();
-
-	const uint32_t MaxConcurrentFrames = Context->GetMaxConcurrentFrames();
+	FVulkanDescriptorAllocator* DescriptorAllocator = Context->GetDescriptorAllocator();
 
-	for (auto& Pair : InstancedDrawingMap)
+	for (const auto& Pair : InstancedDrawingMap)
 	{
-		FVulkanMesh* Mesh = Pair.first;
-		std::vector<FVulkanModel*>& Models = Pair.second.Models;
-		std::vector<VkDescriptorSet>& DescriptorSets = Pair.second.DescriptorSets;
-
-		std::vector<VkDescriptorSetLayout> Layouts(MaxConcurrentFrames, DescriptorSetLayout);
-		VkDescriptorSetAllocateInfo DescriptorSetAllocInfo{};
-		DescriptorSetAllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-		DescriptorSetAllocInfo.descriptorPool = DescriptorPool;
-		DescriptorSetAllocInfo.descriptorSetCount = static_cast<uint32_t>(MaxConcurrentFrames);
-		DescriptorSetAllocInfo.pSetLayouts = Layouts.data();
-
-		DescriptorSets.resize(MaxConcurrentFrames);
-		VK_ASSERT(vkAllocateDescriptorSets(Device, &DescriptorSetAllocInfo, DescriptorSets.data()));
-	}
+		FVulkanMaterial* Material = Pair.first->GetMaterial();
+		if (Material == nullptr || MaterialBindings.find(Material) != MaterialBindings.end())
+		{
+			continue;
+		}
 
-	UpdateDescriptorSets();
+		// Material constants never change after load, so unlike the per-frame buffers a single copy is enough.
+		FMaterialBinding Binding;
+		Binding.MaterialBuffer = Context->CreateObject<FVulkanBuffer>();
+		Binding.MaterialBuffer->SetUsage(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
+		Binding.MaterialBuffer->SetProperties(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		Binding.MaterialBuffer->Allocate(sizeof(FMaterialBufferObject));
+		Binding.MaterialBuffer->Map();
+
+		Binding.DescriptorSet = DescriptorAllocator->Allocate(MaterialDescriptorSetLayout);
+
+		MaterialBindings[Material] = Binding;
+
+		UpdateMaterialBuffer(Material);
+		if (UpdateMaterialDescriptorSet(Material) == false)
+		{
+			// Draws of a material whose textures are missing are skipped rather than made with a half-written set.
+			DescriptorAllocator->Free(Binding.DescriptorSet);
+			MaterialBindings[Material].DescriptorSet = VK_NULL_HANDLE;
+		}
+	}
 }
 
 void FVulkanMeshRenderer::GetVertexInputBindings(std::vector<VkVertexInputBindingDescription>& OutDescs)
@@ -749,7 +792,7 @@ void FVulkanMeshRenderer::GetVertexInputBindings(std::vector<VkVertexInputBindin
 
 void FVulkanMeshRenderer::GetVertexInputAttributes(std::vector<VkVertexInputAttributeDescription>& OutDescs)
 {
-	OutDescs.resize(16);
+	OutDescs.resize(7);
 	OutDescs[0].binding = 0;
 	OutDescs[0].location = 0;
 	OutDescs[0].format = VK_FORMAT_R32G32B32_SFLOAT;
@@ -770,79 +813,105 @@ void FVulkanMeshRenderer::GetVertexInputAttributes(std::vector<VkVertexInputAttr
 	OutDescs[3].format = VK_FORMAT_R32G32B32_SFLOAT;
 	OutDescs[3].offset = offsetof(FVertex, Tangent);
 
-	for (int Idx = 0; Idx < 4; ++Idx)
+	for (int Idx = 0; Idx < 3; ++Idx)
 	{
 		OutDescs[4 + Idx].binding = 1;
 		OutDescs[4 + Idx].location = 4 + Idx;
 		OutDescs[4 + Idx].format = VK_FORMAT_R32G32B32A32_SFLOAT;
-		OutDescs[4 + Idx].offset = offsetof(FInstanceBuffer, Model) + sizeof(glm::vec4) * Idx;
+		OutDescs[4 + Idx].offset = offsetof(FInstanceBuffer, ModelRows) + sizeof(glm::vec4) * Idx;
 	}
+}
+
+void FVulkanMeshRenderer::GetViewProjection(bool bIsShadowPass, glm::mat4& OutView, glm::mat4& OutProjection)
+{
+	FVulkanCamera Camera = Scene->GetCamera();
+
+	FVulkanViewport* Viewport = Context->GetViewport();
+	assert(Viewport != nullptr);
+
+	FVulkanSwapchain* Swapchain = Viewport->GetSwapchain();
+	assert(Swapchain != nullptr);
+
+	VkExtent2D SwapchainExtent = Swapchain->GetExtent();
+
+	float FOVRadians = glm::radians(Camera.FOV);
+	float AspectRatio = SwapchainExtent.width / (float)SwapchainExtent.height;
+
+	const std::vector<FVulkanPointLight>& PointLights = Scene->GetPointLights();
 
-	for (int Idx = 0; Idx < 4; ++Idx)
+	if (bIsShadowPass && PointLights.size() > 0)
 	{
-		OutDescs[8 + Idx].binding = 1;
-		OutDescs[8 + Idx].location = 8 + Idx;
-		OutDescs[8 + Idx].format = VK_FORMAT_R32G32B32A32_SFLOAT;
-		OutDescs[8 + Idx].offset = offsetof(FInstanceBuffer, ModelView) + sizeof(glm::vec4) * Idx;
+		OutView = glm::lookAt(PointLights[0].Position, Camera.Position, glm::vec3(0.0f, 1.0f, 0.0f));
 	}
-
-	for (int Idx = 0; Idx < 4; ++Idx)
+	else
 	{
-		OutDescs[12 + Idx].binding = 1;
-		OutDescs[12 + Idx].location = 12 + Idx;
-		OutDescs[12 + Idx].format = VK_FORMAT_R32G32B32A32_SFLOAT;
-		OutDescs[12 + Idx].offset = offsetof(FInstanceBuffer, NormalMatrix) + sizeof(glm::vec4) * Idx;
+		OutView = Camera.View;
 	}
+	OutProjection = glm::perspective(FOVRadians, AspectRatio, Camera.Near, Camera.Far);
 }
 
-void FVulkanMeshRenderer::UpdateUniformBuffer(bool bIsShadowPass)
+void FVulkanMeshRenderer::UpdateFrustums()
 {
 	if (Scene == nullptr)
 	{
 		return;
 	}
 
-	FVulkanCamera Camera = Scene->GetCamera();
+	glm::mat4 View;
+	glm::mat4 Projection;
 
-	FVulkanViewport* Viewport = Context->GetViewport();
-	assert(Viewport != nullptr);
+	GetViewProjection(false, View, Projection);
+	if (CullingGuardBand > 0.0f)
+	{
+		FVulkanCamera Camera = Scene->GetCamera();
 
-	FVulkanSwapchain* Swapchain = Viewport->GetSwapchain();
-	assert(Swapchain != nullptr);
+		// Only the vertical field of view is widened; the aspect ratio carries it over to the horizontal one.
+		const float FOVScale = std::tan(glm::radians(Camera.FOV + CullingGuardBand) * 0.5f) / std::tan(glm::radians(Camera.FOV) * 0.5f);
+		Projection[0][0] /= FOVScale;
+		Projection[1][1] /= FOVScale;
+	}
+	CameraFrustum = FVulkanFrustum::FromViewProjection(Projection * View);
 
-	VkExtent2D SwapchainExtent = Swapchain->GetExtent();
+	GetViewProjection(true, View, Projection);
+	ShadowFrustum = FVulkanFrustum::FromViewProjection(Projection * View);
+}
 
-	float FOVRadians = glm::radians(Camera.FOV);
-	float AspectRatio = SwapchainExtent.width / (float)SwapchainExtent.height;
+void FVulkanMeshRenderer::UpdateUniformBuffer(bool bIsShadowPass)
+{
+	if (Scene == nullptr)
+	{
+		return;
+	}
 
-	static const glm::mat4 IdentityMatrix(1.0f);
+	FVulkanCamera Camera = Scene->GetCamera();
 
 	const std::vector<FVulkanPointLight>& PointLights = Scene->GetPointLights();
 	const std::vector<FVulkanDirectionalLight>& DirectionalLights = Scene->GetDirectionalLights();
 
 	FTransformBufferObject TBO{};
+	GetViewProjection(bIsShadowPass, TBO.View, TBO.Projection);
 	if (bIsShadowPass && PointLights.size() > 0)
 	{
-		TBO.View = glm::lookAt(PointLights[0].Position, Camera.Position, glm::vec3(0.0f, 1.0f, 0.0f));
 		TBO.CameraPosition = PointLights[0].Position;
 	}
 	else
 	{
-		TBO.View = Camera.View;
 		TBO.CameraPosition = Camera.Position;
 	}
-	TBO.Projection = glm::perspective(FOVRadians, AspectRatio, Camera.Near, Camera.Far);
+	TBO.CameraView = Camera.View;
 
 	FLightBufferObject LBO{};
 
+	// Lights stay in world space; the shaders move them into view space with the transform buffer's camera
+	// view, so a late-latched camera only has to rewrite that one matrix.
 	LBO.NumPointLights = static_cast<uint32_t>(PointLights.size());
 	for (uint32_t Idx = 0; Idx < LBO.NumPointLights; ++Idx)
 	{
 		LBO.PointLights[Idx] = PointLights[Idx];
-		LBO.PointLights[Idx].Position = Camera.View * glm::vec4(LBO.PointLights[Idx].Position, 1.0f);
 
-		glm::vec3 LightForward = LBO.PointLights[Idx].Position - Camera.Position;
-		glm::mat4 LightView = glm::lookAt(LightForward, LBO.PointLights[Idx].Position, glm::vec3(0.0f, 1.0f, 0.0f));
+		glm::vec3 ViewPosition = Camera.View * glm::vec4(LBO.PointLights[Idx].Position, 1.0f);
+		glm::vec3 LightForward = ViewPosition - Camera.Position;
+		glm::mat4 LightView = glm::lookAt(LightForward, ViewPosition, glm::vec3(0.0f, 1.0f, 0.0f));
 		LBO.PointLights[Idx].LightSpaceMatrix = TBO.Projection * LightView;
 	}
 
@@ -850,248 +919,149 @@ void FVulkanMeshRenderer::UpdateUniformBuffer(bool bIsShadowPass)
 	for (uint32_t Idx = 0; Idx < LBO.NumDirectionalLights; ++Idx)
 	{
 		LBO.DirectionalLights[Idx] = DirectionalLights[Idx];
-		LBO.DirectionalLights[Idx].Direction = Camera.View * glm::vec4(LBO.DirectionalLights[Idx].Direction, 0.0f);
 	}
 
-	FDebugBufferObject DBO{};
-	DBO.bAttenuation = bEnableAttenuation;
-	DBO.bGammaCorrection = bEnableGammaCorrection;
-	DBO.bToneMapping = bEnableToneMapping;
-
 	uint32_t CurrentFrame = Context->GetCurrentFrame();
 
 	memcpy(TransformBuffers[CurrentFrame]->GetMappedAddress(), &TBO, sizeof(FTransformBufferObject));
 	memcpy(LightBuffers[CurrentFrame]->GetMappedAddress(), &LBO, sizeof(FLightBufferObject));
-	memcpy(DebugBuffers[CurrentFrame]->GetMappedAddress(), &DBO, sizeof(FDebugBufferObject));
 }
 
-void FVulkanMeshRenderer::UpdateMaterialBuffer(FVulkanMesh* InMesh)
+void FVulkanMeshRenderer::LatchView()
 {
-	if (InMesh == nullptr)
+	if (Scene == nullptr || bInitialized == false)
 	{
 		return;
 	}
 
-	FVulkanMaterial* Material = InMesh->GetMaterial();
-	if (Material == nullptr)
+	// The shadow pass's view follows the light and keeps the culling it was recorded with; only the camera
+	// passes read CameraView.
+	const glm::mat4 CameraView = Scene->GetCamera().View;
+
+	uint8_t* MappedAddress = static_cast<uint8_t*>(TransformBuffers[Context->GetCurrentFrame()]->GetMappedAddress());
+	memcpy(MappedAddress + offsetof(FTransformBufferObject, CameraView), &CameraView, sizeof(glm::mat4));
+}
+
+void FVulkanMeshRenderer::UpdateMaterialBuffer(FVulkanMaterial* InMaterial)
+{
+	auto Iter = MaterialBindings.find(InMaterial);
+	if (Iter == MaterialBindings.end())
 	{
 		return;
 	}
 
 	FMaterialBufferObject MBO{};
-	MBO.Ambient = glm::vec4(Material->GetAmbient().Vec3Param, 1.0);
-	MBO.Diffuse = glm::vec4(Material->GetDiffuse().Vec3Param, 1.0);
-	MBO.Specular = glm::vec4(Material->GetSpecular().Vec3Param, 1.0);
-
-	uint32_t CurrentFrame = Context->GetCurrentFrame();
+	MBO.Ambient = glm::vec4(InMaterial->GetAmbient().Vec3Param, 1.0);
+	MBO.Diffuse = glm::vec4(InMaterial->GetDiffuse().Vec3Param, 1.0);
+	MBO.Specular = glm::vec4(InMaterial->GetSpecular().Vec3Param, 1.0);
 
-	memcpy(MaterialBuffers[CurrentFrame]->GetMappedAddress(), &MBO, sizeof(FMaterialBufferObject));
+	memcpy(Iter->second.MaterialBuffer->GetMappedAddress(), &MBO, sizeof(FMaterialBufferObject));
 }
 
-void FVulkanMeshRenderer::UpdateInstanceBuffer(FVulkanMesh* InMesh)
+void FVulkanMeshRenderer::UpdateObjectTransforms()
 {
+	CPU_PROFILE_SCOPE("FVulkanMeshRenderer::UpdateObjectTransforms");
+
 	if (Scene == nullptr)
 	{
 		return;
 	}
 
-	if (InMesh == nullptr)
+	for (FVulkanModel* Model : Scene->GetDirtyModels())
 	{
-		return;
-	}
+		auto Iter = ModelObjectIndices.find(Model);
+		if (Iter == ModelObjectIndices.end())
+		{
+			continue;
+		}
 
-	auto Iter = InstancedDrawingMap.find(InMesh);
-	if (Iter == InstancedDrawingMap.end())
-	{
-		return;
+		CullingPass->SetObjectTransform(Iter->second, Model->GetModelMatrix());
 	}
 
-	static const glm::mat4 IdentityMatrix(1.0f);
-
-	FVulkanCamera Camera = Scene->GetCamera();
+	Scene->ClearDirtyModels();
+}
 
-	glm::mat4 View = Camera.View;
+void FVulkanMeshRenderer::UpdateFrameDescriptorSet()
+{
+	const uint32_t CurrentFrame = Context->GetCurrentFrame();
 
-	FVulkanBuffer* InstanceBuffer = Iter->second.InstanceBuffers[Context->GetCurrentFrame()];
+	// The set only lives until this frame slot comes around again, so it is rewritten from scratch every frame.
+	CurrentFrameDescriptorSet = Context->GetDescriptorAllocator()->AllocateTransient(FrameDescriptorSetLayout);
 
-	const std::vector<FVulkanModel*> Models = Iter->second.Models;
-	{
-		std::vector<int> ModelIndices;
-		ModelIndices.resize(Models.size());
-		for (int Idx = 0; Idx < Models.size(); ++Idx)
-		{
-			ModelIndices[Idx] = Idx;
-		}
+	FFrameDescriptorData DescriptorData{};
+	DescriptorData.TransformBuffer = { TransformBuffers[CurrentFrame]->GetHandle(), 0, sizeof(FTransformBufferObject) };
+	DescriptorData.LightBuffer = { LightBuffers[CurrentFrame]->GetHandle(), 0, sizeof(FLightBufferObject) };
+	// The samplers are immutable in the set layouts.
+	DescriptorData.ShadowMap = { VK_NULL_HANDLE, ShadowDepthImage->GetView(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
 
-		std::for_each(std::execution::par, std::begin(ModelIndices), std::end(ModelIndices), [&View, &Models, &InstanceBuffer](int Idx)
-		{
-			FVulkanModel* Model = Models[Idx];
-			if (Model == nullptr)
-			{
-				return;
-			}
-
-			FInstanceBuffer* InstanceBufferData = (FInstanceBuffer*)InstanceBuffer->GetMappedAddress()  + Idx;
-			InstanceBufferData->Model = Model->GetModelMatrix();
-			InstanceBufferData->ModelView = View * InstanceBufferData->Model;
-			InstanceBufferData->NormalMatrix = glm::transpose(glm::inverse(glm::mat3(InstanceBufferData->ModelView)));
-		});
-	}
+	vkUpdateDescriptorSetWithTemplate(Context->GetDevice(), CurrentFrameDescriptorSet, FrameUpdateTemplate, &DescriptorData);
 }
 
-void FVulkanMeshRenderer::UpdateDescriptorSets()
+bool FVulkanMeshRenderer::UpdateMaterialDescriptorSet(FVulkanMaterial* InMaterial)
 {
 	VkDevice Device = Context->GetDevice();
 
-	for (const auto& Pair : InstancedDrawingMap)
+	auto Iter = MaterialBindings.find(InMaterial);
+	if (Iter == MaterialBindings.end())
 	{
-		FVulkanMesh* Mesh = static_cast<FVulkanMesh*>(Pair.first);
-		if (Mesh == nullptr)
-		{
-			continue;
-		}
+		return false;
+	}
 
-		FVulkanMaterial* Material = Mesh->GetMaterial();
-		if (Material == nullptr)
-		{
-			continue;
-		}
+	UTexture* BaseColorTextureAsset = InMaterial->GetBaseColor().TexParam;
+	if (BaseColorTextureAsset == nullptr)
+	{
+		return false;
+	}
 
-		UTexture* BaseColorTextureAsset = Material->GetBaseColor().TexParam;
-		if (BaseColorTextureAsset == nullptr)
-		{
-			continue;
-		}
+	FVulkanTexture* BaseColorTexture = BaseColorTextureAsset->GetRenderTexture();
+	if (BaseColorTexture == nullptr)
+	{
+		return false;
+	}
 
-		FVulkanTexture* BaseColorTexture = BaseColorTextureAsset->GetRenderTexture();
-		if (BaseColorTexture == nullptr)
-		{
-			continue;
-		}
+	UTexture* NormalTextureAsset = InMaterial->GetNormal().TexParam;
+	if (NormalTextureAsset == nullptr)
+	{
+		return false;
+	}
 
-		UTexture* NormalTextureAsset = Material->GetNormal().TexParam;
-		if (NormalTextureAsset == nullptr)
-		{
-			continue;
-		}
+	FVulkanTexture* NormalTexture = NormalTextureAsset->GetRenderTexture();
+	if (NormalTexture == nullptr)
+	{
+		return false;
+	}
 
-		FVulkanTexture* NormalTexture = NormalTextureAsset->GetRenderTexture();
-		if (NormalTexture == nullptr)
-		{
-			continue;
-		}
+	FMaterialDescriptorData DescriptorData{};
+	DescriptorData.MaterialBuffer = { Iter->second.MaterialBuffer->GetHandle(), 0, sizeof(FMaterialBufferObject) };
+	DescriptorData.BaseColor = { VK_NULL_HANDLE, BaseColorTexture->GetImage()->GetView(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+	DescriptorData.Normal = { VK_NULL_HANDLE, NormalTexture->GetImage()->GetView(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
 
-		const std::vector<VkDescriptorSet>& DescriptorSets = Pair.second.DescriptorSets;
+	vkUpdateDescriptorSetWithTemplate(Device, Iter->second.DescriptorSet, MaterialUpdateTemplate, &DescriptorData);
 
-		for (int32_t i = 0; i < DescriptorSets.size(); ++i)
-		{
-			VkDescriptorBufferInfo TransformBufferInfo{};
-			TransformBufferInfo.buffer = TransformBuffers[i]->GetHandle();
-			TransformBufferInfo.offset = 0;
-			TransformBufferInfo.range = sizeof(FTransformBufferObject);
-
-			VkWriteDescriptorSet TransformBufferDescriptor{};
-			TransformBufferDescriptor.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-			TransformBufferDescriptor.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-			TransformBufferDescriptor.pBufferInfo = &TransformBufferInfo;
-
-			VkDescriptorBufferInfo LightBufferInfo{};
-			LightBufferInfo.buffer = LightBuffers[i]->GetHandle();
-			LightBufferInfo.offset = 0;
-			LightBufferInfo.range = sizeof(FLightBufferObject);
-
-			VkWriteDescriptorSet LightBufferDescriptor{};
-			LightBufferDescriptor.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-			LightBufferDescriptor.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-			LightBufferDescriptor.pBufferInfo = &LightBufferInfo;
-
-			VkDescriptorBufferInfo MaterialBufferInfo{};
-			MaterialBufferInfo.buffer = MaterialBuffers[i]->GetHandle();
-			MaterialBufferInfo.offset = 0;
-			MaterialBufferInfo.range = sizeof(FMaterialBufferObject);
-
-			VkWriteDescriptorSet MaterialBufferDescriptor{};
-			MaterialBufferDescriptor.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-			MaterialBufferDescriptor.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-			MaterialBufferDescriptor.pBufferInfo = &MaterialBufferInfo;
-
-			VkDescriptorBufferInfo DebugBufferInfo{};
-			DebugBufferInfo.buffer = DebugBuffers[i]->GetHandle();
-			DebugBufferInfo.offset = 0;
-			DebugBufferInfo.range = sizeof(FDebugBufferObject);
-
-			VkWriteDescriptorSet DebugBufferDescriptor{};
-			DebugBufferDescriptor.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-			DebugBufferDescriptor.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-			DebugBufferDescriptor.pBufferInfo = &DebugBufferInfo;
-
-			VkDescriptorImageInfo BaseColorImageInfo{};
-			BaseColorImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-			BaseColorImageInfo.imageView = BaseColorTexture->GetImage()->GetView();
-			BaseColorImageInfo.sampler = Sampler->GetSampler();
-
-			VkWriteDescriptorSet BaseColorDescriptor{};
-			BaseColorDescriptor.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-			BaseColorDescriptor.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-			BaseColorDescriptor.pImageInfo = &BaseColorImageInfo;
-
-			VkDescriptorImageInfo NormalImageInfo{};
-			NormalImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-			NormalImageInfo.imageView = NormalTexture->GetImage()->GetView();
-			NormalImageInfo.sampler = Sampler->GetSampler();
-
-			VkWriteDescriptorSet NormalDescriptor{};
-			NormalDescriptor.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-			NormalDescriptor.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-			NormalDescriptor.pImageInfo = &NormalImageInfo;
-
-			VkDescriptorImageInfo ShadowImageInfo{};
-			ShadowImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-			ShadowImageInfo.imageView = ShadowDepthImage->GetView();
-			ShadowImageInfo.sampler = Sampler->GetSampler();
-
-			VkWriteDescriptorSet ShadowDescriptor{};
-			ShadowDescriptor.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-			ShadowDescriptor.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-			ShadowDescriptor.pImageInfo = &ShadowImageInfo;
-
-			std::vector<VkWriteDescriptorSet> DescriptorWrites
-			{
-				TransformBufferDescriptor,
-				LightBufferDescriptor,
-				MaterialBufferDescriptor,
-				DebugBufferDescriptor,
-				BaseColorDescriptor,
-				NormalDescriptor,
-				ShadowDescriptor
-			};
-
-			for (int j = 0; j < DescriptorWrites.size(); ++j)
-			{
-				DescriptorWrites[j].dstSet = DescriptorSets[i];
-				DescriptorWrites[j].dstArrayElement = 0;
-				DescriptorWrites[j].dstBinding = j;
-				DescriptorWrites[j].descriptorCount = 1;
-			}
-
-			vkUpdateDescriptorSets(Device, static_cast<uint32_t>(DescriptorWrites.size()), DescriptorWrites.data(), 0, nullptr);
-		}
-	}
+	return true;
 }
 
 void FVulkanMeshRenderer::Render()
 {
+	CPU_PROFILE_SCOPE("FVulkanMeshRenderer::Render");
+
 	if (bInitialized == false)
 	{
 		GenerateInstancedDrawingInfo();
 
+		RequestedPermutation = GetPermutationKey();
+		DrawnPermutation = RequestedPermutation;
+
 		CreateGraphicsPipelines();
-		CreateInstanceBuffers();
+		GenerateDrawBatches();
+		CreateCullingPass();
 		CreateDescriptorSets();
 
 		bInitialized = true;
 	}
 
+	UpdatePipelinePermutation();
+
 	VkCommandBuffer CommandBuffer = Context->GetCommandBuffer();
  
 	FVulkanViewport* Viewport = Context->GetViewport();
@@ -1120,30 +1090,53 @@ void FVulkanMeshRenderer::Render()
 	Scissor.offset = { 0, 0 };
 	Scissor.extent = SwapchainExtent;
 
+	VkRect2D ShadowRenderArea;
+	ShadowRenderArea.offset = { 0, 0 };
+	ShadowRenderArea.extent = ShadowMapExtent;
+
+	VkViewport ShadowViewportState = ViewportState;
+	ShadowViewportState.width = (float)ShadowMapExtent.width;
+	ShadowViewportState.height = (float)ShadowMapExtent.height;
+
 	std::vector<VkClearValue> ClearValuesShadowPass{};
 	ClearValuesShadowPass.resize(1);
 	ClearValuesShadowPass[0].depthStencil = { 1.0f, 0 };
 
-	ShadowPass->Begin(CommandBuffer, ShadowFramebuffers[CurrentImageIndex], RenderArea, ClearValuesShadowPass);
+	UpdateFrustums();
+	UpdateObjectTransforms();
+	UpdateFrameDescriptorSet();
 
-	UpdateUniformBuffer(true);
+	FVulkanGpuProfiler* GpuProfiler = Context->GetGpuProfiler();
 
-	for (const auto& Pair : InstancedDrawingMap)
+	if (Scene != nullptr)
 	{
-		FVulkanMesh* Mesh = Pair.first;
-		FInstancedDrawingInfo DrawingInfo = Pair.second;
-		DrawingInfo.Pipeline = ShadowPipeline;
+		FVulkanCamera Camera = Scene->GetCamera();
 
-		if (Mesh == nullptr)
-		{
-			continue;
-		}
+		GpuProfiler->BeginScope(CommandBuffer, "Culling");
+		CullingPass->Dispatch(CommandBuffer, Camera.Position, CameraFrustum, ShadowFrustum);
+		GpuProfiler->EndScope(CommandBuffer);
+	}
+
+	GpuProfiler->BeginScope(CommandBuffer, "Shadow Pass");
+
+	ShadowPass->Begin(CommandBuffer, ShadowFramebuffer, ShadowRenderArea, ClearValuesShadowPass);
+
+	UpdateUniformBuffer(true);
 
-		Draw(Mesh, DrawingInfo, ViewportState, Scissor);
+	vkCmdSetViewport(CommandBuffer, 0, 1, &ShadowViewportState);
+	vkCmdSetScissor(CommandBuffer, 0, 1, &ShadowRenderArea);
+
+	BeginPass(CommandBuffer);
+
+	for (const FDrawBatch& Batch : ShadowBatches)
+	{
+		Draw(Batch, ShadowPipeline, ECullingView::Shadow);
 	}
 
 	ShadowPass->End(CommandBuffer);
 
+	GpuProfiler->EndScope(CommandBuffer);
+
 	std::vector<VkClearValue> ClearValuesBasePass{};
 	ClearValuesBasePass.resize(2);
 	ClearValuesBasePass[0].color = { { 0.0f, 0.0f, 0.0f, 1.0f } };
@@ -1151,27 +1144,26 @@ void FVulkanMeshRenderer::Render()
 
 	TransitionShadowImage(CommandBuffer, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 
+	GpuProfiler->BeginScope(CommandBuffer, "Base Pass");
+
 	BasePass->Begin(CommandBuffer, Framebuffers[CurrentImageIndex], RenderArea, ClearValuesBasePass);
 
 //	UpdateUniformBuffer(false);
 
-	for (const auto& Pair : InstancedDrawingMap)
-	{
-		FVulkanMesh* Mesh = Pair.first;
-		const FInstancedDrawingInfo& DrawingInfo = Pair.second;
+	vkCmdSetViewport(CommandBuffer, 0, 1, &ViewportState);
+	vkCmdSetScissor(CommandBuffer, 0, 1, &Scissor);
 
-		if (Mesh == nullptr)
-		{
-			continue;
-		}
+	BeginPass(CommandBuffer);
 
-		UpdateMaterialBuffer(Mesh);
-		UpdateInstanceBuffer(Mesh);
-		Draw(Mesh, DrawingInfo, ViewportState, Scissor);
+	for (const FDrawBatch& Batch : BaseBatches)
+	{
+		Draw(Batch, Batch.Pipeline, ECullingView::Camera);
 	}
 
 	BasePass->End(CommandBuffer);
 
+	GpuProfiler->EndScope(CommandBuffer);
+
 	TransitionShadowImage(CommandBuffer, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
 }
 
@@ -1227,48 +1219,119 @@ void FVulkanMeshRenderer::TransitionShadowImage(VkCommandBuffer CommandBuffer, V
 		1, &ImageMemoryBarrier);
 }
 
-void FVulkanMeshRenderer::Draw(
-	FVulkanMesh* InMesh,
-	const FInstancedDrawingInfo& InDrawingInfo,
-	VkViewport& InViewport,
-	VkRect2D& InScissor)
+void FVulkanMeshRenderer::BeginPass(VkCommandBuffer InCommandBuffer)
 {
-	if (InMesh == nullptr)
+	BoundGeometryPage = UINT32_MAX;
+	BoundPipeline = nullptr;
+	BoundMaterial = nullptr;
+
+	// Every mesh pipeline layout is compatible for set 0, so any of them can bind it for the whole pass.
+	vkCmdBindDescriptorSets(InCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, ShadowPipeline->GetLayout(), FrameDescriptorSet, 1, &CurrentFrameDescriptorSet, 0, nullptr);
+}
+
+bool FVulkanMeshRenderer::BindGeometry(VkCommandBuffer InCommandBuffer, uint32_t InGeometryPage)
+{
+	if (BoundGeometryPage == InGeometryPage)
 	{
-		return;
+		return true;
+	}
+
+	FVulkanGeometryPool* GeometryPool = Context->GetGeometryPool();
+	FVulkanBuffer* VertexBuffer = GeometryPool->GetVertexBuffer(InGeometryPage);
+	FVulkanBuffer* IndexBuffer = GeometryPool->GetIndexBuffer(InGeometryPage);
+	FVulkanBuffer* InstanceBuffer = CullingPass->GetInstanceBuffer();
+	if (VertexBuffer == nullptr || IndexBuffer == nullptr || InstanceBuffer == nullptr)
+	{
+		return false;
 	}
 
-	FVulkanPipeline* Pipeline = InDrawingInfo.Pipeline;
+	VkBuffer VertexBuffers[] = { VertexBuffer->GetHandle(), InstanceBuffer->GetHandle() };
+	VkDeviceSize Offsets[] = { 0, 0 };
+	vkCmdBindVertexBuffers(InCommandBuffer, 0, 2, VertexBuffers, Offsets);
+	vkCmdBindIndexBuffer(InCommandBuffer, IndexBuffer->GetHandle(), 0, VK_INDEX_TYPE_UINT32);
+
+	BoundGeometryPage = InGeometryPage;
+
+	return true;
+}
+
+void FVulkanMeshRenderer::Draw(const FDrawBatch& InBatch, FVulkanPipeline* InPipeline, ECullingView InCullingView)
+{
+	FVulkanPipeline* Pipeline = InPipeline;
 	if (Pipeline == nullptr)
 	{
 		return;
 	}
 
-	uint32_t CurrentFrame = Context->GetCurrentFrame();
+	// All mesh pipelines share their set layouts, so the fallback binds the same sets.
+	if (Pipeline->IsReady() == false)
+	{
+		Pipeline = FallbackPipeline;
+	}
+
+	auto Iter = InstancedDrawingMap.find(InBatch.Mesh);
+	if (Iter == InstancedDrawingMap.end())
+	{
+		return;
+	}
+
+	FVulkanBuffer* IndirectBuffer = CullingPass->GetIndirectBuffer();
+	if (IndirectBuffer == nullptr)
+	{
+		return;
+	}
+
 	VkCommandBuffer CommandBuffer = Context->GetCommandBuffer();
 
-	vkCmdSetViewport(CommandBuffer, 0, 1, &InViewport);
-	vkCmdSetScissor(CommandBuffer, 0, 1, &InScissor);
+	// The shadow pass only reads set 0, so only the camera pass needs a material.
+	FVulkanMaterial* Material = InCullingView == ECullingView::Camera ? InBatch.Mesh->GetMaterial() : nullptr;
+	if (Material != nullptr && Material != BoundMaterial)
+	{
+		auto BindingIter = MaterialBindings.find(Material);
+		if (BindingIter == MaterialBindings.end() || BindingIter->second.DescriptorSet == VK_NULL_HANDLE)
+		{
+			return;
+		}
 
-	FVulkanBuffer* InstanceBuffer = InDrawingInfo.InstanceBuffers[CurrentFrame];
-	VkDescriptorSet DescriptorSet = InDrawingInfo.DescriptorSets[CurrentFrame];
+		vkCmdBindDescriptorSets(CommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, Pipeline->GetLayout(), MaterialDescriptorSet, 1, &BindingIter->second.DescriptorSet, 0, nullptr);
+		BoundMaterial = Material;
+	}
 
-	VkBuffer VertexBuffers[] = { InMesh->GetVertexBuffer()->GetHandle(), InstanceBuffer->GetHandle() };
-	VkDeviceSize Offsets[] = { 0, 0 };
-	vkCmdBindVertexBuffers(CommandBuffer, 0, 2, VertexBuffers, Offsets);
-	vkCmdBindIndexBuffer(CommandBuffer, InMesh->GetIndexBuffer()->GetHandle(), 0, VK_INDEX_TYPE_UINT32);
+	if (BindGeometry(CommandBuffer, InBatch.GeometryPage) == false)
+	{
+		return;
+	}
 
-	uint32_t NumIndices = static_cast<uint32_t>(InMesh->GetMeshAsset()->GetIndices().size());
-	uint32_t NumModels = static_cast<uint32_t>(InDrawingInfo.Models.size());
+	VkDeviceSize CommandOffset = CullingPass->GetCommandOffset(InCullingView, InBatch.FirstMesh);
+	uint32_t NumCommands = CullingPass->GetNumCommands(InBatch.FirstMesh, InBatch.NumMeshes);
 
-	if (bEnableTBNVisualization)
+	if (bEnableTBNVisualization && InCullingView == ECullingView::Camera && TBNPipeline->IsReady())
 	{
 		vkCmdBindPipeline(CommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, TBNPipeline->GetPipeline());
-		vkCmdBindDescriptorSets(CommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, TBNPipeline->GetLayout(), 0, 1, &DescriptorSet, 0, nullptr);
-		vkCmdDrawIndexed(CommandBuffer, NumIndices, NumModels, 0, 0, 0);
+		DrawIndirect(CommandBuffer, IndirectBuffer->GetHandle(), CommandOffset, NumCommands);
+		BoundPipeline = TBNPipeline;
+	}
+
+	if (Pipeline != BoundPipeline)
+	{
+		vkCmdBindPipeline(CommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, Pipeline->GetPipeline());
+		BoundPipeline = Pipeline;
 	}
+	DrawIndirect(CommandBuffer, IndirectBuffer->GetHandle(), CommandOffset, NumCommands);
+}
 
-	vkCmdBindPipeline(CommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, Pipeline->GetPipeline());
-	vkCmdBindDescriptorSets(CommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, Pipeline->GetLayout(), 0, 1, &DescriptorSet, 0, nullptr);
-	vkCmdDrawIndexed(CommandBuffer, NumIndices, NumModels, 0, 0, 0);
+void FVulkanMeshRenderer::DrawIndirect(VkCommandBuffer InCommandBuffer, VkBuffer InIndirectBuffer, VkDeviceSize InOffset, uint32_t InDrawCount)
+{
+	const uint32_t Stride = sizeof(VkDrawIndexedIndirectCommand);
+
+	if (Context->GetEnabledFeatures().multiDrawIndirect)
+	{
+		vkCmdDrawIndexedIndirect(InCommandBuffer, InIndirectBuffer, InOffset, InDrawCount, Stride);
+		return;
+	}
+
+	for (uint32_t Idx = 0; Idx < InDrawCount; ++Idx)
+	{
+		vkCmdDrawIndexedIndirect(InCommandBuffer, InIndirectBuffer, InOffset + Stride * Idx, 1, Stride);
+	}
 }
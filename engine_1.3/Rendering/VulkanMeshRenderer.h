@@ -2,6 +2,8 @@
 
 #include "VulkanRenderer.h"
 #include "VulkanBuffer.h"
+#include "VulkanFrustum.h"
+#include "VulkanCullingPass.h"
 
 #include "vulkan/vulkan.h"
 #include "glfw/glfw3.h"
@@ -9,6 +11,7 @@
 
 #include "Vertex.h"
 
+#include <array>
 #include <vector>
 #include <unordered_map>
 
@@ -20,36 +23,49 @@ public:
 
 	virtual void Destroy() override;
 
+	virtual const char* GetName() const override { return "Mesh"; }
 	virtual void Render() override;
 	virtual void OnRecreateSwapchain() override;
+	virtual void LatchView() override;
 
 	void SetEnableTBNVisualization(bool bEnabled) { bEnableTBNVisualization = bEnabled; }
+	// The shading toggles select a pipeline permutation; a change takes effect once its variants have compiled.
 	void SetEnableAttenuation(bool bEnabled) { bEnableAttenuation = bEnabled; }
 	void SetEnableGammaCorrection(bool bEnabled) { bEnableGammaCorrection = bEnabled; }
 	void SetEnableToneMapping(bool bEnabled) { bEnableToneMapping = bEnabled; }
 
 protected:
 	void GenerateInstancedDrawingInfo();
+	void GenerateDrawBatches();
 
 	void CreateRenderPasses();
 	void CreateShadowDepthImage();
+	void CreateShadowFramebuffer();
 	void CreateFramebuffers();
-	void CreateDescriptorSetLayout();
+	void CreateDescriptorSetLayouts();
+	void CreateDescriptorUpdateTemplates();
 	void CreateGraphicsPipelines();
+	uint32_t GetPermutationKey() const;
+	void UpdatePipelinePermutation();
 	void CreateShadowPipeline();
+	void CreateFallbackPipeline();
 	void CreateTBNPipeline();
 	void CreateTextureSampler();
 	void CreateUniformBuffers();
-	void CreateInstanceBuffers();
+	void CreateCullingPass();
 	void CreateDescriptorSets();
 
 	void GetVertexInputBindings(std::vector<VkVertexInputBindingDescription>& OutDescs);
 	void GetVertexInputAttributes(std::vector<VkVertexInputAttributeDescription>& OutDescs);
 
+	void GetViewProjection(bool bIsShadowPass, glm::mat4& OutView, glm::mat4& OutProjection);
+	void UpdateFrustums();
+
 	void UpdateUniformBuffer(bool bIsShadowPass);
-	void UpdateMaterialBuffer(class FVulkanMesh* InMesh);
-	void UpdateInstanceBuffer(class FVulkanMesh* InMesh);
-	void UpdateDescriptorSets();
+	void UpdateMaterialBuffer(class FVulkanMaterial* InMaterial);
+	void UpdateObjectTransforms();
+	void UpdateFrameDescriptorSet();
+	bool UpdateMaterialDescriptorSet(class FVulkanMaterial* InMaterial);
 
 	void TransitionShadowImage(VkCommandBuffer CommandBuffer, VkImageLayout InOldLayout, VkImageLayout InNewLayout);
 
@@ -57,32 +73,95 @@ protected:
 	{
 		class FVulkanPipeline* Pipeline;
 		std::vector<class FVulkanModel*> Models;
-		std::vector<class FVulkanBuffer*> InstanceBuffers;
-		std::vector<VkDescriptorSet> DescriptorSets;
+		uint32_t MeshIndex = 0;
+	};
+
+	// A run of meshes with consecutive culling indices that share a geometry page, pipeline and
+	// material, drawn with one multi-draw-indirect call.
+	struct FDrawBatch
+	{
+		class FVulkanPipeline* Pipeline = nullptr;
+		class FVulkanMesh* Mesh = nullptr;
+		uint32_t GeometryPage = 0;
+		uint32_t FirstMesh = 0;
+		uint32_t NumMeshes = 0;
 	};
-	void Draw(class FVulkanMesh* InMesh, const FInstancedDrawingInfo& InDrawingInfo, VkViewport& InViewport, VkRect2D& InScissor);
+
+	// Descriptors are split by how often they change. Set 0 holds what every draw of a frame shares (transforms,
+	// lights and the shadow map) and is bound once per pass. Set 1 holds a material's constants and
+	// textures and is only rebound when the material changes. Per-draw data, the model matrices, already reaches
+	// the shaders through the culling pass's instance stream. All mesh pipelines share the same set layouts, so
+	// their pipeline layouts stay compatible and switching pipelines never disturbs the bound sets.
+	// Set 0 is a transient set allocated and written every frame; material sets are persistent.
+	struct FMaterialBinding
+	{
+		class FVulkanBuffer* MaterialBuffer = nullptr;
+		VkDescriptorSet DescriptorSet = VK_NULL_HANDLE;
+	};
+
+	// Fills in the vertex layout and set layouts every mesh pipeline shares, leaving the shaders to the caller.
+	void GetGraphicsPipelineDesc(VkRenderPass InRenderPass, struct FGraphicsPipelineDesc& OutDesc);
+	void BeginPass(VkCommandBuffer InCommandBuffer);
+
+	bool BindGeometry(VkCommandBuffer InCommandBuffer, uint32_t InGeometryPage);
+	void Draw(const FDrawBatch& InBatch, class FVulkanPipeline* InPipeline, ECullingView InCullingView);
+	void DrawIndirect(VkCommandBuffer InCommandBuffer, VkBuffer InIndirectBuffer, VkDeviceSize InOffset, uint32_t InDrawCount);
 
 protected:
 	class FVulkanRenderPass* ShadowPass;
 	class FVulkanRenderPass* BasePass;
 
+	// The context may destroy the passes and framebuffers before the renderer at teardown.
+	FVulkanObjectHandle ShadowPassHandle;
+	FVulkanObjectHandle BasePassHandle;
+
+	// The shadow map has its own fixed size, so resizing the window never touches it.
 	class FVulkanImage* ShadowDepthImage;
+	class FVulkanFramebuffer* ShadowFramebuffer;
+	VkExtent2D ShadowMapExtent;
 
-	std::vector<class FVulkanFramebuffer*> ShadowFramebuffers;
 	std::vector<class FVulkanFramebuffer*> Framebuffers;
+	std::vector<FVulkanObjectHandle> FramebufferHandles;
 
+	// Owned by the context's pipeline library.
 	class FVulkanPipeline* ShadowPipeline;
+	class FVulkanPipeline* FallbackPipeline;
 	class FVulkanPipeline* TBNPipeline;
 
-	VkDescriptorSetLayout DescriptorSetLayout;
+	VkDescriptorSetLayout FrameDescriptorSetLayout;
+	VkDescriptorSetLayout MaterialDescriptorSetLayout;
+	VkDescriptorUpdateTemplate FrameUpdateTemplate;
+	VkDescriptorUpdateTemplate MaterialUpdateTemplate;
+
+	VkDescriptorSet CurrentFrameDescriptorSet;
+	std::unordered_map<class FVulkanMaterial*, FMaterialBinding> MaterialBindings;
 
 	std::unordered_map<class FVulkanMesh*, FInstancedDrawingInfo> InstancedDrawingMap;
 
+	std::vector<FDrawBatch> ShadowBatches;
+	std::vector<FDrawBatch> BaseBatches;
+	uint32_t BoundGeometryPage;
+	class FVulkanPipeline* BoundPipeline;
+
+	// Shader feature permutation the material pipelines were last requested for, and the one the batches draw with.
+	uint32_t RequestedPermutation;
+	uint32_t DrawnPermutation;
+	class FVulkanMaterial* BoundMaterial;
+
+	class FVulkanCullingPass* CullingPass;
+	std::unordered_map<class FVulkanModel*, uint32_t> ModelObjectIndices;
+
+	FVulkanFrustum CameraFrustum;
+	FVulkanFrustum ShadowFrustum;
+
+	// Extra field of view, in degrees, the camera is culled with so a late-latched view that turned a little
+	// since recording does not reveal culled objects at the screen edges.
+	float CullingGuardBand;
+
 	std::vector<class FVulkanBuffer*> TransformBuffers;
 	std::vector<class FVulkanBuffer*> LightBuffers;
-	std::vector<class FVulkanBuffer*> MaterialBuffers;
-	std::vector<class FVulkanBuffer*> DebugBuffers;
 
+	// Owned by the context's sampler cache and baked into the set layouts as an immutable sampler.
 	class FVulkanSampler* Sampler;
 
 	bool bInitialized;
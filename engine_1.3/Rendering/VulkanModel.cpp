@@ -1,12 +1,25 @@
 #include "VulkanModel.h"
 #include "VulkanContext.h"
 #include "VulkanMesh.h"
+#include "VulkanScene.h"
 
 #include "glm/gtc/matrix_transform.hpp"
 
 FVulkanModel::FVulkanModel(class FVulkanContext* InContext)
 	: FVulkanObject(InContext)
 	, Mesh(nullptr)
+	, Scene(nullptr)
 	, Model(1.0f)
+	, bDirty(false)
 {
 }
+
+void FVulkanModel::SetModelMatrix(const glm::mat4& InModel)
+{
+	Model = InModel;
+
+	if (Scene != nullptr)
+	{
+		Scene->MarkModelDirty(this);
+	}
+}
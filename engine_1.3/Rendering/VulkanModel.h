@@ -15,10 +15,19 @@ public:
 	void SetMesh(class FVulkanMesh* InMesh) { Mesh = InMesh; }
 
 	glm::mat4 GetModelMatrix() const { return Model; }
-	void SetModelMatrix(const glm::mat4& InModel) { Model = InModel; }
+	void SetModelMatrix(const glm::mat4& InModel);
+
+	class FVulkanScene* GetScene() const { return Scene; }
+	void SetScene(class FVulkanScene* InScene) { Scene = InScene; }
+
+	bool IsDirty() const { return bDirty; }
+	void SetDirty(bool InbDirty) { bDirty = InbDirty; }
 
 protected:
 	class FVulkanMesh* Mesh;
+	class FVulkanScene* Scene;
 
 	glm::mat4 Model;
+
+	bool bDirty;
 };
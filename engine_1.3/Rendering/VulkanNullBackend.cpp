@@ -0,0 +1,915 @@
+#include "VulkanNullBackend.h"
+
+#include "vulkan/vulkan.h"
+
+#include <mutex>
+#include <memory>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+
+static std::mutex GNullMutex;
+static FVulkanNullStats GNullStats;
+
+FVulkanNullStats VkNull::GetStats()
+{
+	std::lock_guard<std::mutex> Lock(GNullMutex);
+	return GNullStats;
+}
+
+void VkNull::ResetCommandStats()
+{
+	std::lock_guard<std::mutex> Lock(GNullMutex);
+
+	FVulkanNullStats Stats;
+	Stats.NumAllocations = GNullStats.NumAllocations;
+	Stats.AllocatedBytes = GNullStats.AllocatedBytes;
+	Stats.PeakAllocatedBytes = GNullStats.PeakAllocatedBytes;
+	Stats.NumLiveObjects = GNullStats.NumLiveObjects;
+
+	GNullStats = Stats;
+}
+
+#ifdef VK_NULL_BACKEND
+
+namespace
+{
+	// Memory type 0 is device local, type 1 is host visible. Only host visible allocations get real storage,
+	// since nothing ever reads device local memory.
+	const uint32_t DeviceLocalMemoryType = 0;
+	const uint32_t HostVisibleMemoryType = 1;
+
+	struct FNullAllocation
+	{
+		VkDeviceSize Size = 0;
+		std::unique_ptr<uint8_t[]> Data;
+	};
+
+	uint64_t GNextHandle = 0;
+
+	std::unordered_map<uint64_t, FNullAllocation> GAllocations;
+	std::unordered_map<uint64_t, VkDeviceSize> GResourceSizes;
+	std::unordered_map<uint64_t, uint64_t> GSemaphoreValues;
+
+	// Sets still allocated from each descriptor pool, so resetting or destroying a pool releases them too.
+	std::unordered_map<uint64_t, std::vector<VkDescriptorSet>> GDescriptorPoolSets;
+
+	// Handles are plain increasing numbers. The C-style cast covers both the pointer and the 64-bit integer
+	// flavours of non-dispatchable handles.
+	template<typename T>
+	T NewHandle()
+	{
+		std::lock_guard<std::mutex> Lock(GNullMutex);
+		++GNullStats.NumLiveObjects;
+		return (T)(uintptr_t)(++GNextHandle);
+	}
+
+	template<typename T>
+	uint64_t HandleKey(T InHandle)
+	{
+		return (uint64_t)(uintptr_t)InHandle;
+	}
+
+	template<typename T>
+	void ReleaseHandle(T InHandle)
+	{
+		if (InHandle == VK_NULL_HANDLE)
+		{
+			return;
+		}
+
+		std::lock_guard<std::mutex> Lock(GNullMutex);
+		--GNullStats.NumLiveObjects;
+		GResourceSizes.erase(HandleKey(InHandle));
+		GSemaphoreValues.erase(HandleKey(InHandle));
+	}
+
+	template<typename T>
+	void NewHandles(uint32_t InCount, T* OutHandles)
+	{
+		for (uint32_t Idx = 0; Idx < InCount; ++Idx)
+		{
+			OutHandles[Idx] = NewHandle<T>();
+		}
+	}
+
+	template<typename T>
+	void ReleaseHandles(uint32_t InCount, const T* InHandles)
+	{
+		for (uint32_t Idx = 0; Idx < InCount; ++Idx)
+		{
+			ReleaseHandle(InHandles[Idx]);
+		}
+	}
+
+	template<typename T>
+	VkResult FillArray(const T* InValues, uint32_t InNumValues, uint32_t* InOutCount, T* OutValues)
+	{
+		if (OutValues == nullptr)
+		{
+			*InOutCount = InNumValues;
+			return VK_SUCCESS;
+		}
+
+		uint32_t NumWritten = std::min(*InOutCount, InNumValues);
+		std::copy(InValues, InValues + NumWritten, OutValues);
+		*InOutCount = NumWritten;
+
+		return NumWritten < InNumValues ? VK_INCOMPLETE : VK_SUCCESS;
+	}
+
+	void CountCommand(uint64_t FVulkanNullStats::* InCounter, uint64_t InAmount = 1)
+	{
+		std::lock_guard<std::mutex> Lock(GNullMutex);
+		GNullStats.*InCounter += InAmount;
+	}
+}
+
+extern "C"
+{
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateInstance(const VkInstanceCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkInstance* pInstance)
+{
+	*pInstance = NewHandle<VkInstance>();
+	return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkDestroyInstance(VkInstance instance, const VkAllocationCallbacks* pAllocator)
+{
+	ReleaseHandle(instance);
+}
+
+VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL vkGetInstanceProcAddr(VkInstance instance, const char* pName)
+{
+	return nullptr;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkEnumerateInstanceLayerProperties(uint32_t* pPropertyCount, VkLayerProperties* pProperties)
+{
+	*pPropertyCount = 0;
+	return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkEnumeratePhysicalDevices(VkInstance instance, uint32_t* pPhysicalDeviceCount, VkPhysicalDevice* pPhysicalDevices)
+{
+	static VkPhysicalDevice PhysicalDevice = NewHandle<VkPhysicalDevice>();
+	return FillArray(&PhysicalDevice, 1, pPhysicalDeviceCount, pPhysicalDevices);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkEnumerateDeviceExtensionProperties(VkPhysicalDevice physicalDevice, const char* pLayerName, uint32_t* pPropertyCount, VkExtensionProperties* pProperties)
+{
+	VkExtensionProperties Extension{};
+	strncpy(Extension.extensionName, VK_KHR_SWAPCHAIN_EXTENSION_NAME, VK_MAX_EXTENSION_NAME_SIZE - 1);
+	Extension.specVersion = 1;
+
+	return FillArray(&Extension, 1, pPropertyCount, pProperties);
+}
+
+VKAPI_ATTR void VKAPI_CALL vkGetPhysicalDeviceProperties(VkPhysicalDevice physicalDevice, VkPhysicalDeviceProperties* pProperties)
+{
+	*pProperties = VkPhysicalDeviceProperties{};
+	pProperties->apiVersion = VK_API_VERSION_1_2;
+	pProperties->deviceType = VK_PHYSICAL_DEVICE_TYPE_CPU;
+	strncpy(pProperties->deviceName, "Null Device", VK_MAX_PHYSICAL_DEVICE_NAME_SIZE - 1);
+
+	VkPhysicalDeviceLimits& Limits = pProperties->limits;
+	Limits.maxImageDimension2D = 16384;
+	Limits.maxBoundDescriptorSets = 8;
+	Limits.maxPushConstantsSize = 256;
+	Limits.maxDrawIndirectCount = UINT32_MAX;
+	Limits.maxSamplerAnisotropy = 16.0f;
+	Limits.minUniformBufferOffsetAlignment = 256;
+	Limits.minStorageBufferOffsetAlignment = 256;
+	Limits.nonCoherentAtomSize = 256;
+	Limits.timestampPeriod = 1.0f;
+	Limits.timestampComputeAndGraphics = VK_TRUE;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkGetPhysicalDeviceFeatures(VkPhysicalDevice physicalDevice, VkPhysicalDeviceFeatures* pFeatures)
+{
+	// Every member is a VkBool32, so claim support for all of them.
+	VkBool32* Features = reinterpret_cast<VkBool32*>(pFeatures);
+	std::fill(Features, Features + sizeof(VkPhysicalDeviceFeatures) / sizeof(VkBool32), VK_TRUE);
+}
+
+VKAPI_ATTR void VKAPI_CALL vkGetPhysicalDeviceFeatures2(VkPhysicalDevice physicalDevice, VkPhysicalDeviceFeatures2* pFeatures)
+{
+	vkGetPhysicalDeviceFeatures(physicalDevice, &pFeatures->features);
+
+	for (VkBaseOutStructure* Next = reinterpret_cast<VkBaseOutStructure*>(pFeatures->pNext); Next != nullptr; Next = Next->pNext)
+	{
+		if (Next->sType == VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES)
+		{
+			reinterpret_cast<VkPhysicalDeviceTimelineSemaphoreFeatures*>(Next)->timelineSemaphore = VK_TRUE;
+		}
+	}
+}
+
+VKAPI_ATTR void VKAPI_CALL vkGetPhysicalDeviceMemoryProperties(VkPhysicalDevice physicalDevice, VkPhysicalDeviceMemoryProperties* pMemoryProperties)
+{
+	*pMemoryProperties = VkPhysicalDeviceMemoryProperties{};
+	pMemoryProperties->memoryTypeCount = 2;
+	pMemoryProperties->memoryTypes[DeviceLocalMemoryType].propertyFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+	pMemoryProperties->memoryTypes[DeviceLocalMemoryType].heapIndex = 0;
+	pMemoryProperties->memoryTypes[HostVisibleMemoryType].propertyFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+	pMemoryProperties->memoryTypes[HostVisibleMemoryType].heapIndex = 1;
+	pMemoryProperties->memoryHeapCount = 2;
+	pMemoryProperties->memoryHeaps[0].size = 1ULL << 34;
+	pMemoryProperties->memoryHeaps[0].flags = VK_MEMORY_HEAP_DEVICE_LOCAL_BIT;
+	pMemoryProperties->memoryHeaps[1].size = 1ULL << 34;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkGetPhysicalDeviceQueueFamilyProperties(VkPhysicalDevice physicalDevice, uint32_t* pQueueFamilyPropertyCount, VkQueueFamilyProperties* pQueueFamilyProperties)
+{
+	VkQueueFamilyProperties QueueFamily{};
+	QueueFamily.queueFlags = VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT | VK_QUEUE_TRANSFER_BIT;
+	QueueFamily.queueCount = 1;
+	QueueFamily.timestampValidBits = 64;
+	QueueFamily.minImageTransferGranularity = { 1, 1, 1 };
+
+	FillArray(&QueueFamily, 1, pQueueFamilyPropertyCount, pQueueFamilyProperties);
+}
+
+VKAPI_ATTR void VKAPI_CALL vkGetPhysicalDeviceFormatProperties(VkPhysicalDevice physicalDevice, VkFormat format, VkFormatProperties* pFormatProperties)
+{
+	pFormatProperties->linearTilingFeatures = ~0U;
+	pFormatProperties->optimalTilingFeatures = ~0U;
+	pFormatProperties->bufferFeatures = ~0U;
+}
+
+// Surfaces never exist in the null backend; these only satisfy the references made by the windowed code paths.
+VKAPI_ATTR VkResult VKAPI_CALL vkGetPhysicalDeviceSurfaceSupportKHR(VkPhysicalDevice physicalDevice, uint32_t queueFamilyIndex, VkSurfaceKHR surface, VkBool32* pSupported)
+{
+	*pSupported = VK_FALSE;
+	return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkGetPhysicalDeviceSurfaceCapabilitiesKHR(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface, VkSurfaceCapabilitiesKHR* pSurfaceCapabilities)
+{
+	*pSurfaceCapabilities = VkSurfaceCapabilitiesKHR{};
+	return VK_ERROR_SURFACE_LOST_KHR;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkGetPhysicalDeviceSurfaceFormatsKHR(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface, uint32_t* pSurfaceFormatCount, VkSurfaceFormatKHR* pSurfaceFormats)
+{
+	*pSurfaceFormatCount = 0;
+	return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkGetPhysicalDeviceSurfacePresentModesKHR(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface, uint32_t* pPresentModeCount, VkPresentModeKHR* pPresentModes)
+{
+	*pPresentModeCount = 0;
+	return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkDestroySurfaceKHR(VkInstance instance, VkSurfaceKHR surface, const VkAllocationCallbacks* pAllocator)
+{
+	ReleaseHandle(surface);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateSwapchainKHR(VkDevice device, const VkSwapchainCreateInfoKHR* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkSwapchainKHR* pSwapchain)
+{
+	return VK_ERROR_SURFACE_LOST_KHR;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkDestroySwapchainKHR(VkDevice device, VkSwapchainKHR swapchain, const VkAllocationCallbacks* pAllocator)
+{
+	ReleaseHandle(swapchain);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkGetSwapchainImagesKHR(VkDevice device, VkSwapchainKHR swapchain, uint32_t* pSwapchainImageCount, VkImage* pSwapchainImages)
+{
+	*pSwapchainImageCount = 0;
+	return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkAcquireNextImageKHR(VkDevice device, VkSwapchainKHR swapchain, uint64_t timeout, VkSemaphore semaphore, VkFence fence, uint32_t* pImageIndex)
+{
+	return VK_ERROR_SURFACE_LOST_KHR;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkQueuePresentKHR(VkQueue queue, const VkPresentInfoKHR* pPresentInfo)
+{
+	return VK_ERROR_SURFACE_LOST_KHR;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateDevice(VkPhysicalDevice physicalDevice, const VkDeviceCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkDevice* pDevice)
+{
+	*pDevice = NewHandle<VkDevice>();
+	return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkDestroyDevice(VkDevice device, const VkAllocationCallbacks* pAllocator)
+{
+	ReleaseHandle(device);
+}
+
+VKAPI_ATTR void VKAPI_CALL vkGetDeviceQueue(VkDevice device, uint32_t queueFamilyIndex, uint32_t queueIndex, VkQueue* pQueue)
+{
+	static VkQueue Queue = NewHandle<VkQueue>();
+	*pQueue = Queue;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkDeviceWaitIdle(VkDevice device)
+{
+	return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkQueueWaitIdle(VkQueue queue)
+{
+	return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkQueueSubmit(VkQueue queue, uint32_t submitCount, const VkSubmitInfo* pSubmits, VkFence fence)
+{
+	std::lock_guard<std::mutex> Lock(GNullMutex);
+
+	for (uint32_t SubmitIdx = 0; SubmitIdx < submitCount; ++SubmitIdx)
+	{
+		const VkSubmitInfo& Submit = pSubmits[SubmitIdx];
+
+		++GNullStats.NumSubmits;
+		GNullStats.NumCommandBuffers += Submit.commandBufferCount;
+
+		// Work completes the moment it is submitted, so timeline semaphores jump straight to their signal value.
+		for (const VkBaseInStructure* Next = reinterpret_cast<const VkBaseInStructure*>(Submit.pNext); Next != nullptr; Next = Next->pNext)
+		{
+			if (Next->sType != VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO)
+			{
+				continue;
+			}
+
+			const VkTimelineSemaphoreSubmitInfo* TimelineInfo = reinterpret_cast<const VkTimelineSemaphoreSubmitInfo*>(Next);
+			uint32_t NumValues = std::min(TimelineInfo->signalSemaphoreValueCount, Submit.signalSemaphoreCount);
+			for (uint32_t Idx = 0; Idx < NumValues; ++Idx)
+			{
+				uint64_t& Value = GSemaphoreValues[HandleKey(Submit.pSignalSemaphores[Idx])];
+				Value = std::max(Value, TimelineInfo->pSignalSemaphoreValues[Idx]);
+			}
+		}
+	}
+
+	return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkAllocateMemory(VkDevice device, const VkMemoryAllocateInfo* pAllocateInfo, const VkAllocationCallbacks* pAllocator, VkDeviceMemory* pMemory)
+{
+	*pMemory = NewHandle<VkDeviceMemory>();
+
+	FNullAllocation Allocation;
+	Allocation.Size = pAllocateInfo->allocationSize;
+	if (pAllocateInfo->memoryTypeIndex == HostVisibleMemoryType)
+	{
+		Allocation.Data.reset(new uint8_t[static_cast<size_t>(Allocation.Size)]);
+	}
+
+	std::lock_guard<std::mutex> Lock(GNullMutex);
+
+	++GNullStats.NumAllocations;
+	GNullStats.AllocatedBytes += Allocation.Size;
+	GNullStats.PeakAllocatedBytes = std::max(GNullStats.PeakAllocatedBytes, GNullStats.AllocatedBytes);
+
+	GAllocations[HandleKey(*pMemory)] = std::move(Allocation);
+
+	return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkFreeMemory(VkDevice device, VkDeviceMemory memory, const VkAllocationCallbacks* pAllocator)
+{
+	if (memory == VK_NULL_HANDLE)
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> Lock(GNullMutex);
+
+		auto Iter = GAllocations.find(HandleKey(memory));
+		if (Iter != GAllocations.end())
+		{
+			--GNullStats.NumAllocations;
+			GNullStats.AllocatedBytes -= Iter->second.Size;
+			GAllocations.erase(Iter);
+		}
+	}
+
+	ReleaseHandle(memory);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkMapMemory(VkDevice device, VkDeviceMemory memory, VkDeviceSize offset, VkDeviceSize size, VkMemoryMapFlags flags, void** ppData)
+{
+	std::lock_guard<std::mutex> Lock(GNullMutex);
+
+	auto Iter = GAllocations.find(HandleKey(memory));
+	if (Iter == GAllocations.end() || Iter->second.Data == nullptr)
+	{
+		*ppData = nullptr;
+		return VK_ERROR_MEMORY_MAP_FAILED;
+	}
+
+	*ppData = Iter->second.Data.get() + offset;
+	return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkUnmapMemory(VkDevice device, VkDeviceMemory memory)
+{
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkFlushMappedMemoryRanges(VkDevice device, uint32_t memoryRangeCount, const VkMappedMemoryRange* pMemoryRanges)
+{
+	return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkInvalidateMappedMemoryRanges(VkDevice device, uint32_t memoryRangeCount, const VkMappedMemoryRange* pMemoryRanges)
+{
+	return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkBindBufferMemory(VkDevice device, VkBuffer buffer, VkDeviceMemory memory, VkDeviceSize memoryOffset)
+{
+	return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkBindImageMemory(VkDevice device, VkImage image, VkDeviceMemory memory, VkDeviceSize memoryOffset)
+{
+	return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkGetBufferMemoryRequirements(VkDevice device, VkBuffer buffer, VkMemoryRequirements* pMemoryRequirements)
+{
+	std::lock_guard<std::mutex> Lock(GNullMutex);
+
+	pMemoryRequirements->size = GResourceSizes[HandleKey(buffer)];
+	pMemoryRequirements->alignment = 256;
+	pMemoryRequirements->memoryTypeBits = (1U << DeviceLocalMemoryType) | (1U << HostVisibleMemoryType);
+}
+
+VKAPI_ATTR void VKAPI_CALL vkGetImageMemoryRequirements(VkDevice device, VkImage image, VkMemoryRequirements* pMemoryRequirements)
+{
+	std::lock_guard<std::mutex> Lock(GNullMutex);
+
+	pMemoryRequirements->size = GResourceSizes[HandleKey(image)];
+	pMemoryRequirements->alignment = 256;
+	pMemoryRequirements->memoryTypeBits = (1U << DeviceLocalMemoryType) | (1U << HostVisibleMemoryType);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateBuffer(VkDevice device, const VkBufferCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkBuffer* pBuffer)
+{
+	*pBuffer = NewHandle<VkBuffer>();
+
+	std::lock_guard<std::mutex> Lock(GNullMutex);
+	GResourceSizes[HandleKey(*pBuffer)] = pCreateInfo->size;
+
+	return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkDestroyBuffer(VkDevice device, VkBuffer buffer, const VkAllocationCallbacks* pAllocator)
+{
+	ReleaseHandle(buffer);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateImage(VkDevice device, const VkImageCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkImage* pImage)
+{
+	*pImage = NewHandle<VkImage>();
+
+	// Four bytes per texel is close enough for tracking; mips add roughly a third on top.
+	const VkExtent3D& Extent = pCreateInfo->extent;
+	VkDeviceSize Size = 4ULL * Extent.width * Extent.height * Extent.depth * pCreateInfo->arrayLayers;
+	if (pCreateInfo->mipLevels > 1)
+	{
+		Size += Size / 3;
+	}
+
+	std::lock_guard<std::mutex> Lock(GNullMutex);
+	GResourceSizes[HandleKey(*pImage)] = Size;
+
+	return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkDestroyImage(VkDevice device, VkImage image, const VkAllocationCallbacks* pAllocator)
+{
+	ReleaseHandle(image);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateImageView(VkDevice device, const VkImageViewCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkImageView* pView)
+{
+	*pView = NewHandle<VkImageView>();
+	return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkDestroyImageView(VkDevice device, VkImageView imageView, const VkAllocationCallbacks* pAllocator)
+{
+	ReleaseHandle(imageView);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateSampler(VkDevice device, const VkSamplerCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkSampler* pSampler)
+{
+	*pSampler = NewHandle<VkSampler>();
+	return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkDestroySampler(VkDevice device, VkSampler sampler, const VkAllocationCallbacks* pAllocator)
+{
+	ReleaseHandle(sampler);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateFence(VkDevice device, const VkFenceCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkFence* pFence)
+{
+	*pFence = NewHandle<VkFence>();
+	return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkDestroyFence(VkDevice device, VkFence fence, const VkAllocationCallbacks* pAllocator)
+{
+	ReleaseHandle(fence);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateQueryPool(VkDevice device, const VkQueryPoolCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkQueryPool* pQueryPool)
+{
+	*pQueryPool = NewHandle<VkQueryPool>();
+	return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkDestroyQueryPool(VkDevice device, VkQueryPool queryPool, const VkAllocationCallbacks* pAllocator)
+{
+	ReleaseHandle(queryPool);
+}
+
+// Nothing executes, so every timestamp reads back as zero.
+VKAPI_ATTR VkResult VKAPI_CALL vkGetQueryPoolResults(VkDevice device, VkQueryPool queryPool, uint32_t firstQuery, uint32_t queryCount, size_t dataSize, void* pData, VkDeviceSize stride, VkQueryResultFlags flags)
+{
+	memset(pData, 0, dataSize);
+	return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateSemaphore(VkDevice device, const VkSemaphoreCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkSemaphore* pSemaphore)
+{
+	*pSemaphore = NewHandle<VkSemaphore>();
+
+	uint64_t InitialValue = 0;
+	for (const VkBaseInStructure* Next = reinterpret_cast<const VkBaseInStructure*>(pCreateInfo->pNext); Next != nullptr; Next = Next->pNext)
+	{
+		if (Next->sType == VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO)
+		{
+			InitialValue = reinterpret_cast<const VkSemaphoreTypeCreateInfo*>(Next)->initialValue;
+		}
+	}
+
+	std::lock_guard<std::mutex> Lock(GNullMutex);
+	GSemaphoreValues[HandleKey(*pSemaphore)] = InitialValue;
+
+	return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkDestroySemaphore(VkDevice device, VkSemaphore semaphore, const VkAllocationCallbacks* pAllocator)
+{
+	ReleaseHandle(semaphore);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkGetSemaphoreCounterValue(VkDevice device, VkSemaphore semaphore, uint64_t* pValue)
+{
+	std::lock_guard<std::mutex> Lock(GNullMutex);
+	*pValue = GSemaphoreValues[HandleKey(semaphore)];
+	return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkWaitSemaphores(VkDevice device, const VkSemaphoreWaitInfo* pWaitInfo, uint64_t timeout)
+{
+	return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateShaderModule(VkDevice device, const VkShaderModuleCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkShaderModule* pShaderModule)
+{
+	*pShaderModule = NewHandle<VkShaderModule>();
+	return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkDestroyShaderModule(VkDevice device, VkShaderModule shaderModule, const VkAllocationCallbacks* pAllocator)
+{
+	ReleaseHandle(shaderModule);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreatePipelineCache(VkDevice device, const VkPipelineCacheCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkPipelineCache* pPipelineCache)
+{
+	*pPipelineCache = NewHandle<VkPipelineCache>();
+	return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkDestroyPipelineCache(VkDevice device, VkPipelineCache pipelineCache, const VkAllocationCallbacks* pAllocator)
+{
+	ReleaseHandle(pipelineCache);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkGetPipelineCacheData(VkDevice device, VkPipelineCache pipelineCache, size_t* pDataSize, void* pData)
+{
+	// Just a header matching the null device, so a second run takes the warm path.
+	VkPhysicalDeviceProperties Properties;
+	vkGetPhysicalDeviceProperties(VK_NULL_HANDLE, &Properties);
+
+	// Header size, version, vendor and device, followed by the cache UUID.
+	uint8_t Header[4 * sizeof(uint32_t) + VK_UUID_SIZE];
+	const uint32_t HeaderFields[4] = { sizeof(Header), VK_PIPELINE_CACHE_HEADER_VERSION_ONE, Properties.vendorID, Properties.deviceID };
+	memcpy(Header, HeaderFields, sizeof(HeaderFields));
+	memcpy(Header + sizeof(HeaderFields), Properties.pipelineCacheUUID, VK_UUID_SIZE);
+
+	if (pData == nullptr)
+	{
+		*pDataSize = sizeof(Header);
+		return VK_SUCCESS;
+	}
+
+	if (*pDataSize < sizeof(Header))
+	{
+		*pDataSize = 0;
+		return VK_INCOMPLETE;
+	}
+
+	memcpy(pData, Header, sizeof(Header));
+	*pDataSize = sizeof(Header);
+	return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkMergePipelineCaches(VkDevice device, VkPipelineCache dstCache, uint32_t srcCacheCount, const VkPipelineCache* pSrcCaches)
+{
+	return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateGraphicsPipelines(VkDevice device, VkPipelineCache pipelineCache, uint32_t createInfoCount, const VkGraphicsPipelineCreateInfo* pCreateInfos, const VkAllocationCallbacks* pAllocator, VkPipeline* pPipelines)
+{
+	NewHandles(createInfoCount, pPipelines);
+	return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateComputePipelines(VkDevice device, VkPipelineCache pipelineCache, uint32_t createInfoCount, const VkComputePipelineCreateInfo* pCreateInfos, const VkAllocationCallbacks* pAllocator, VkPipeline* pPipelines)
+{
+	NewHandles(createInfoCount, pPipelines);
+	return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkDestroyPipeline(VkDevice device, VkPipeline pipeline, const VkAllocationCallbacks* pAllocator)
+{
+	ReleaseHandle(pipeline);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreatePipelineLayout(VkDevice device, const VkPipelineLayoutCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkPipelineLayout* pPipelineLayout)
+{
+	*pPipelineLayout = NewHandle<VkPipelineLayout>();
+	return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkDestroyPipelineLayout(VkDevice device, VkPipelineLayout pipelineLayout, const VkAllocationCallbacks* pAllocator)
+{
+	ReleaseHandle(pipelineLayout);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateDescriptorSetLayout(VkDevice device, const VkDescriptorSetLayoutCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkDescriptorSetLayout* pSetLayout)
+{
+	*pSetLayout = NewHandle<VkDescriptorSetLayout>();
+	return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkDestroyDescriptorSetLayout(VkDevice device, VkDescriptorSetLayout descriptorSetLayout, const VkAllocationCallbacks* pAllocator)
+{
+	ReleaseHandle(descriptorSetLayout);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateDescriptorPool(VkDevice device, const VkDescriptorPoolCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkDescriptorPool* pDescriptorPool)
+{
+	*pDescriptorPool = NewHandle<VkDescriptorPool>();
+	return VK_SUCCESS;
+}
+
+static void ReleaseDescriptorPoolSets(VkDescriptorPool InDescriptorPool)
+{
+	std::vector<VkDescriptorSet> Sets;
+	{
+		std::lock_guard<std::mutex> Lock(GNullMutex);
+
+		auto Iter = GDescriptorPoolSets.find(HandleKey(InDescriptorPool));
+		if (Iter == GDescriptorPoolSets.end())
+		{
+			return;
+		}
+
+		Sets.swap(Iter->second);
+	}
+
+	ReleaseHandles(static_cast<uint32_t>(Sets.size()), Sets.data());
+}
+
+VKAPI_ATTR void VKAPI_CALL vkDestroyDescriptorPool(VkDevice device, VkDescriptorPool descriptorPool, const VkAllocationCallbacks* pAllocator)
+{
+	ReleaseDescriptorPoolSets(descriptorPool);
+
+	{
+		std::lock_guard<std::mutex> Lock(GNullMutex);
+		GDescriptorPoolSets.erase(HandleKey(descriptorPool));
+	}
+
+	ReleaseHandle(descriptorPool);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkResetDescriptorPool(VkDevice device, VkDescriptorPool descriptorPool, VkDescriptorPoolResetFlags flags)
+{
+	ReleaseDescriptorPoolSets(descriptorPool);
+	return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkAllocateDescriptorSets(VkDevice device, const VkDescriptorSetAllocateInfo* pAllocateInfo, VkDescriptorSet* pDescriptorSets)
+{
+	NewHandles(pAllocateInfo->descriptorSetCount, pDescriptorSets);
+
+	std::lock_guard<std::mutex> Lock(GNullMutex);
+	std::vector<VkDescriptorSet>& Sets = GDescriptorPoolSets[HandleKey(pAllocateInfo->descriptorPool)];
+	Sets.insert(Sets.end(), pDescriptorSets, pDescriptorSets + pAllocateInfo->descriptorSetCount);
+
+	return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkFreeDescriptorSets(VkDevice device, VkDescriptorPool descriptorPool, uint32_t descriptorSetCount, const VkDescriptorSet* pDescriptorSets)
+{
+	{
+		std::lock_guard<std::mutex> Lock(GNullMutex);
+		std::vector<VkDescriptorSet>& Sets = GDescriptorPoolSets[HandleKey(descriptorPool)];
+		for (uint32_t Idx = 0; Idx < descriptorSetCount; ++Idx)
+		{
+			Sets.erase(std::remove(Sets.begin(), Sets.end(), pDescriptorSets[Idx]), Sets.end());
+		}
+	}
+
+	ReleaseHandles(descriptorSetCount, pDescriptorSets);
+	return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkUpdateDescriptorSets(VkDevice device, uint32_t descriptorWriteCount, const VkWriteDescriptorSet* pDescriptorWrites, uint32_t descriptorCopyCount, const VkCopyDescriptorSet* pDescriptorCopies)
+{
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateDescriptorUpdateTemplate(VkDevice device, const VkDescriptorUpdateTemplateCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkDescriptorUpdateTemplate* pDescriptorUpdateTemplate)
+{
+	*pDescriptorUpdateTemplate = NewHandle<VkDescriptorUpdateTemplate>();
+	return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkDestroyDescriptorUpdateTemplate(VkDevice device, VkDescriptorUpdateTemplate descriptorUpdateTemplate, const VkAllocationCallbacks* pAllocator)
+{
+	ReleaseHandle(descriptorUpdateTemplate);
+}
+
+VKAPI_ATTR void VKAPI_CALL vkUpdateDescriptorSetWithTemplate(VkDevice device, VkDescriptorSet descriptorSet, VkDescriptorUpdateTemplate descriptorUpdateTemplate, const void* pData)
+{
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateFramebuffer(VkDevice device, const VkFramebufferCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkFramebuffer* pFramebuffer)
+{
+	*pFramebuffer = NewHandle<VkFramebuffer>();
+	return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkDestroyFramebuffer(VkDevice device, VkFramebuffer framebuffer, const VkAllocationCallbacks* pAllocator)
+{
+	ReleaseHandle(framebuffer);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateRenderPass(VkDevice device, const VkRenderPassCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkRenderPass* pRenderPass)
+{
+	*pRenderPass = NewHandle<VkRenderPass>();
+	return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkDestroyRenderPass(VkDevice device, VkRenderPass renderPass, const VkAllocationCallbacks* pAllocator)
+{
+	ReleaseHandle(renderPass);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateCommandPool(VkDevice device, const VkCommandPoolCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkCommandPool* pCommandPool)
+{
+	*pCommandPool = NewHandle<VkCommandPool>();
+	return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkDestroyCommandPool(VkDevice device, VkCommandPool commandPool, const VkAllocationCallbacks* pAllocator)
+{
+	ReleaseHandle(commandPool);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkResetCommandPool(VkDevice device, VkCommandPool commandPool, VkCommandPoolResetFlags flags)
+{
+	return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkAllocateCommandBuffers(VkDevice device, const VkCommandBufferAllocateInfo* pAllocateInfo, VkCommandBuffer* pCommandBuffers)
+{
+	NewHandles(pAllocateInfo->commandBufferCount, pCommandBuffers);
+	return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkFreeCommandBuffers(VkDevice device, VkCommandPool commandPool, uint32_t commandBufferCount, const VkCommandBuffer* pCommandBuffers)
+{
+	ReleaseHandles(commandBufferCount, pCommandBuffers);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkBeginCommandBuffer(VkCommandBuffer commandBuffer, const VkCommandBufferBeginInfo* pBeginInfo)
+{
+	return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkEndCommandBuffer(VkCommandBuffer commandBuffer)
+{
+	return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkResetCommandBuffer(VkCommandBuffer commandBuffer, VkCommandBufferResetFlags flags)
+{
+	return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdBeginRenderPass(VkCommandBuffer commandBuffer, const VkRenderPassBeginInfo* pRenderPassBegin, VkSubpassContents contents)
+{
+	CountCommand(&FVulkanNullStats::NumRenderPasses);
+}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdEndRenderPass(VkCommandBuffer commandBuffer)
+{
+}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdBindPipeline(VkCommandBuffer commandBuffer, VkPipelineBindPoint pipelineBindPoint, VkPipeline pipeline)
+{
+	CountCommand(&FVulkanNullStats::NumPipelineBinds);
+}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdBindDescriptorSets(VkCommandBuffer commandBuffer, VkPipelineBindPoint pipelineBindPoint, VkPipelineLayout layout, uint32_t firstSet, uint32_t descriptorSetCount, const VkDescriptorSet* pDescriptorSets, uint32_t dynamicOffsetCount, const uint32_t* pDynamicOffsets)
+{
+	CountCommand(&FVulkanNullStats::NumDescriptorSetBinds, descriptorSetCount);
+}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdBindIndexBuffer(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset, VkIndexType indexType)
+{
+}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdBindVertexBuffers(VkCommandBuffer commandBuffer, uint32_t firstBinding, uint32_t bindingCount, const VkBuffer* pBuffers, const VkDeviceSize* pOffsets)
+{
+}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdSetViewport(VkCommandBuffer commandBuffer, uint32_t firstViewport, uint32_t viewportCount, const VkViewport* pViewports)
+{
+}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdSetScissor(VkCommandBuffer commandBuffer, uint32_t firstScissor, uint32_t scissorCount, const VkRect2D* pScissors)
+{
+}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdPushConstants(VkCommandBuffer commandBuffer, VkPipelineLayout layout, VkShaderStageFlags stageFlags, uint32_t offset, uint32_t size, const void* pValues)
+{
+}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdDrawIndexed(VkCommandBuffer commandBuffer, uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t vertexOffset, uint32_t firstInstance)
+{
+	CountCommand(&FVulkanNullStats::NumDraws);
+}
+
+// The arguments live in a GPU buffer that is never written, so only the commands and their slots are counted.
+VKAPI_ATTR void VKAPI_CALL vkCmdDrawIndexedIndirect(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset, uint32_t drawCount, uint32_t stride)
+{
+	std::lock_guard<std::mutex> Lock(GNullMutex);
+	++GNullStats.NumIndirectDraws;
+	GNullStats.NumIndirectDrawSlots += drawCount;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdDispatch(VkCommandBuffer commandBuffer, uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ)
+{
+	CountCommand(&FVulkanNullStats::NumDispatches);
+}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdCopyBuffer(VkCommandBuffer commandBuffer, VkBuffer srcBuffer, VkBuffer dstBuffer, uint32_t regionCount, const VkBufferCopy* pRegions)
+{
+	CountCommand(&FVulkanNullStats::NumCopies);
+}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdCopyBufferToImage(VkCommandBuffer commandBuffer, VkBuffer srcBuffer, VkImage dstImage, VkImageLayout dstImageLayout, uint32_t regionCount, const VkBufferImageCopy* pRegions)
+{
+	CountCommand(&FVulkanNullStats::NumCopies);
+}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdCopyImageToBuffer(VkCommandBuffer commandBuffer, VkImage srcImage, VkImageLayout srcImageLayout, VkBuffer dstBuffer, uint32_t regionCount, const VkBufferImageCopy* pRegions)
+{
+	CountCommand(&FVulkanNullStats::NumCopies);
+}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdResetQueryPool(VkCommandBuffer commandBuffer, VkQueryPool queryPool, uint32_t firstQuery, uint32_t queryCount)
+{
+}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdWriteTimestamp(VkCommandBuffer commandBuffer, VkPipelineStageFlagBits pipelineStage, VkQueryPool queryPool, uint32_t query)
+{
+}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdPipelineBarrier(VkCommandBuffer commandBuffer, VkPipelineStageFlags srcStageMask, VkPipelineStageFlags dstStageMask, VkDependencyFlags dependencyFlags, uint32_t memoryBarrierCount, const VkMemoryBarrier* pMemoryBarriers, uint32_t bufferMemoryBarrierCount, const VkBufferMemoryBarrier* pBufferMemoryBarriers, uint32_t imageMemoryBarrierCount, const VkImageMemoryBarrier* pImageMemoryBarriers)
+{
+	CountCommand(&FVulkanNullStats::NumBarriers);
+}
+
+}
+
+#endif
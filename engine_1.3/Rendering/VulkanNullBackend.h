@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+
+// Building with VK_NULL_BACKEND defined compiles VulkanNullBackend.cpp into a stand-in for the Vulkan loader.
+// Every entry point the engine and the ImGui backend use hands out fake handles, tracks memory and records the
+// submitted work into these counters without ever reaching a driver, so the CPU side of a frame can be profiled
+// on machines without any Vulkan implementation.
+struct FVulkanNullStats
+{
+	uint64_t NumAllocations = 0;
+	uint64_t AllocatedBytes = 0;
+	uint64_t PeakAllocatedBytes = 0;
+	uint64_t NumLiveObjects = 0;
+
+	uint64_t NumSubmits = 0;
+	uint64_t NumCommandBuffers = 0;
+	uint64_t NumRenderPasses = 0;
+	uint64_t NumPipelineBinds = 0;
+	uint64_t NumDescriptorSetBinds = 0;
+	uint64_t NumDraws = 0;
+	uint64_t NumIndirectDraws = 0;
+
+	// Sum of drawCount over indirect draws. The stub never reads the commands, so slots the culling pass left
+	// without instances are counted as well.
+	uint64_t NumIndirectDrawSlots = 0;
+	uint64_t NumDispatches = 0;
+	uint64_t NumCopies = 0;
+	uint64_t NumBarriers = 0;
+};
+
+namespace VkNull
+{
+	constexpr bool IsEnabled()
+	{
+#ifdef VK_NULL_BACKEND
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	// Only meaningful when IsEnabled() is true.
+	FVulkanNullStats GetStats();
+
+	// Clears the command counters. Memory and object tracking keep running.
+	void ResetCommandStats();
+}
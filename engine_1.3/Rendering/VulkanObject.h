@@ -1,5 +1,18 @@
 #pragma once
 
+#include <cstdint>
+
+struct FVulkanObjectHandle
+{
+	uint32_t Index = UINT32_MAX;
+	uint32_t Generation = 0;
+
+	bool IsNull() const { return Index == UINT32_MAX; }
+
+	bool operator==(const FVulkanObjectHandle& RHS) const { return Index == RHS.Index && Generation == RHS.Generation; }
+	bool operator!=(const FVulkanObjectHandle& RHS) const { return (*this == RHS) == false; }
+};
+
 class FVulkanObject
 {
 public:
@@ -8,6 +21,13 @@ public:
 
 	virtual void Destroy() { }
 
+	FVulkanObjectHandle GetObjectHandle() const { return Handle; }
+
 protected:
 	class FVulkanContext* Context;
+
+private:
+	friend class FVulkanObjectRegistry;
+
+	FVulkanObjectHandle Handle;
 };
@@ -0,0 +1,180 @@
+#include "VulkanObjectRegistry.h"
+
+#include <algorithm>
+#include <utility>
+
+FVulkanObjectRegistry::FVulkanObjectRegistry()
+	: NextSerial(0)
+	, NumLiveObjects(0)
+{
+
+}
+
+FVulkanObjectRegistry::~FVulkanObjectRegistry()
+{
+
+}
+
+uint32_t FVulkanObjectRegistry::GetShardIndex(const FVulkanObject* InObject)
+{
+	uintptr_t Address = reinterpret_cast<uintptr_t>(InObject);
+	Address ^= Address >> 17;
+	Address ^= Address >> 7;
+
+	return static_cast<uint32_t>(Address >> 4) & ShardMask;
+}
+
+FVulkanObjectHandle FVulkanObjectRegistry::Register(FVulkanObject* InObject)
+{
+	if (InObject == nullptr)
+	{
+		return FVulkanObjectHandle();
+	}
+
+	uint32_t ShardIndex = GetShardIndex(InObject);
+	FShard& Shard = Shards[ShardIndex];
+
+	std::lock_guard<std::mutex> Lock(Shard.Mutex);
+
+	auto Itr = Shard.SlotLookup.find(InObject);
+	if (Itr != Shard.SlotLookup.end())
+	{
+		return InObject->Handle;
+	}
+
+	uint32_t SlotIndex;
+	if (Shard.FreeSlots.empty() == false)
+	{
+		SlotIndex = Shard.FreeSlots.back();
+		Shard.FreeSlots.pop_back();
+	}
+	else
+	{
+		SlotIndex = static_cast<uint32_t>(Shard.Slots.size());
+		Shard.Slots.emplace_back();
+	}
+
+	FSlot& Slot = Shard.Slots[SlotIndex];
+	Slot.Object = InObject;
+	Slot.Serial = NextSerial.fetch_add(1, std::memory_order_relaxed);
+
+	Shard.SlotLookup[InObject] = SlotIndex;
+
+	InObject->Handle.Index = (SlotIndex << ShardBits) | ShardIndex;
+	InObject->Handle.Generation = Slot.Generation;
+
+	NumLiveObjects.fetch_add(1, std::memory_order_relaxed);
+
+	return InObject->Handle;
+}
+
+bool FVulkanObjectRegistry::Unregister(FVulkanObject* InObject)
+{
+	if (InObject == nullptr)
+	{
+		return false;
+	}
+
+	FShard& Shard = Shards[GetShardIndex(InObject)];
+
+	std::lock_guard<std::mutex> Lock(Shard.Mutex);
+
+	auto Itr = Shard.SlotLookup.find(InObject);
+	if (Itr == Shard.SlotLookup.end())
+	{
+		return false;
+	}
+
+	uint32_t SlotIndex = Itr->second;
+	Shard.SlotLookup.erase(Itr);
+
+	FSlot& Slot = Shard.Slots[SlotIndex];
+	Slot.Object = nullptr;
+	++Slot.Generation;
+
+	Shard.FreeSlots.push_back(SlotIndex);
+
+	InObject->Handle = FVulkanObjectHandle();
+
+	NumLiveObjects.fetch_sub(1, std::memory_order_relaxed);
+
+	return true;
+}
+
+FVulkanObject* FVulkanObjectRegistry::Resolve(FVulkanObjectHandle InHandle) const
+{
+	if (InHandle.IsNull())
+	{
+		return nullptr;
+	}
+
+	const FShard& Shard = Shards[InHandle.Index & ShardMask];
+	uint32_t SlotIndex = InHandle.Index >> ShardBits;
+
+	std::lock_guard<std::mutex> Lock(Shard.Mutex);
+
+	if (SlotIndex >= Shard.Slots.size())
+	{
+		return nullptr;
+	}
+
+	const FSlot& Slot = Shard.Slots[SlotIndex];
+	if (Slot.Generation != InHandle.Generation)
+	{
+		return nullptr;
+	}
+
+	return Slot.Object;
+}
+
+bool FVulkanObjectRegistry::IsValid(FVulkanObjectHandle InHandle) const
+{
+	return Resolve(InHandle) != nullptr;
+}
+
+bool FVulkanObjectRegistry::Contains(FVulkanObject* InObject) const
+{
+	if (InObject == nullptr)
+	{
+		return false;
+	}
+
+	const FShard& Shard = Shards[GetShardIndex(InObject)];
+
+	std::lock_guard<std::mutex> Lock(Shard.Mutex);
+
+	return Shard.SlotLookup.find(InObject) != Shard.SlotLookup.end();
+}
+
+void FVulkanObjectRegistry::GetLiveObjects(std::vector<FVulkanObject*>& OutObjects) const
+{
+	std::vector<std::pair<uint64_t, FVulkanObject*>> SortedObjects;
+	SortedObjects.reserve(GetNumLiveObjects());
+
+	for (const FShard& Shard : Shards)
+	{
+		std::lock_guard<std::mutex> Lock(Shard.Mutex);
+
+		for (const FSlot& Slot : Shard.Slots)
+		{
+			if (Slot.Object != nullptr)
+			{
+				SortedObjects.emplace_back(Slot.Serial, Slot.Object);
+			}
+		}
+	}
+
+	std::sort(SortedObjects.begin(), SortedObjects.end(),
+		[](const std::pair<uint64_t, FVulkanObject*>& A, const std::pair<uint64_t, FVulkanObject*>& B)
+		{
+			return A.first < B.first;
+		});
+
+	OutObjects.clear();
+	OutObjects.reserve(SortedObjects.size());
+
+	for (const std::pair<uint64_t, FVulkanObject*>& Pair : SortedObjects)
+	{
+		OutObjects.push_back(Pair.second);
+	}
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "VulkanObject.h"
+
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <unordered_map>
+
+// Slot map of every live FVulkanObject. Handles carry a generation so stale handles never resolve,
+// and slots are split into independently locked shards so objects can be created from any thread.
+class FVulkanObjectRegistry
+{
+public:
+	FVulkanObjectRegistry();
+	virtual ~FVulkanObjectRegistry();
+
+	FVulkanObjectHandle Register(FVulkanObject* InObject);
+	bool Unregister(FVulkanObject* InObject);
+
+	FVulkanObject* Resolve(FVulkanObjectHandle InHandle) const;
+	bool IsValid(FVulkanObjectHandle InHandle) const;
+	bool Contains(FVulkanObject* InObject) const;
+
+	void GetLiveObjects(std::vector<FVulkanObject*>& OutObjects) const;
+	uint32_t GetNumLiveObjects() const { return NumLiveObjects.load(std::memory_order_relaxed); }
+
+private:
+	static constexpr uint32_t ShardBits = 4;
+	static constexpr uint32_t NumShards = 1 << ShardBits;
+	static constexpr uint32_t ShardMask = NumShards - 1;
+
+	struct FSlot
+	{
+		FVulkanObject* Object = nullptr;
+		uint32_t Generation = 0;
+		uint64_t Serial = 0;
+	};
+
+	struct FShard
+	{
+		mutable std::mutex Mutex;
+		std::vector<FSlot> Slots;
+		std::vector<uint32_t> FreeSlots;
+		std::unordered_map<FVulkanObject*, uint32_t> SlotLookup;
+	};
+
+	static uint32_t GetShardIndex(const FVulkanObject* InObject);
+
+private:
+	std::array<FShard, NumShards> Shards;
+
+	std::atomic<uint64_t> NextSerial;
+	std::atomic<uint32_t> NumLiveObjects;
+};
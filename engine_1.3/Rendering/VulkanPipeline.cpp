@@ -1,14 +1,19 @@
 #include "VulkanPipeline.h"
 #include "VulkanContext.h"
 #include "VulkanHelpers.h"
+#include "VulkanPipelineCache.h"
+
+#include <chrono>
 
 FVulkanPipeline::FVulkanPipeline(FVulkanContext* InContext)
 	: FVulkanObject(InContext)
 	, Layout(VK_NULL_HANDLE)
 	, Pipeline(VK_NULL_HANDLE)
+	, bReady(false)
 	, VS(VK_NULL_HANDLE)
 	, GS(VK_NULL_HANDLE)
 	, FS(VK_NULL_HANDLE)
+	, CS(VK_NULL_HANDLE)
 {
 
 }
@@ -38,6 +43,23 @@ void FVulkanPipeline::CreateLayout(const VkPipelineLayoutCreateInfo& CI)
 void FVulkanPipeline::CreatePipeline(const VkGraphicsPipelineCreateInfo& CI)
 {
 	VkDevice Device = Context->GetDevice();
+	FVulkanPipelineCache* PipelineCache = Context->GetPipelineCache();
+
+	const auto Start = std::chrono::steady_clock::now();
+	VK_ASSERT(vkCreateGraphicsPipelines(Device, PipelineCache->GetCache(), 1, &CI, nullptr, &Pipeline));
+	PipelineCache->RecordPipelineCreation(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - Start).count());
+
+	bReady.store(true, std::memory_order_release);
+}
+
+void FVulkanPipeline::CreatePipeline(const VkComputePipelineCreateInfo& CI)
+{
+	VkDevice Device = Context->GetDevice();
+	FVulkanPipelineCache* PipelineCache = Context->GetPipelineCache();
+
+	const auto Start = std::chrono::steady_clock::now();
+	VK_ASSERT(vkCreateComputePipelines(Device, PipelineCache->GetCache(), 1, &CI, nullptr, &Pipeline));
+	PipelineCache->RecordPipelineCreation(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - Start).count());
 
-	VK_ASSERT(vkCreateGraphicsPipelines(Device, VK_NULL_HANDLE, 1, &CI, nullptr, &Pipeline));
+	bReady.store(true, std::memory_order_release);
 }
@@ -4,6 +4,8 @@
 
 #include "vulkan/vulkan.h"
 
+#include <atomic>
+
 class FVulkanPipeline : public FVulkanObject
 {
 public:
@@ -14,21 +16,29 @@ public:
 	VkPipelineLayout GetLayout() const { return Layout; }
 	VkPipeline GetPipeline() const { return Pipeline; }
 
+	// False while the pipeline is still being compiled on another thread; the handles must not be used until then.
+	bool IsReady() const { return bReady.load(std::memory_order_acquire); }
+
 	FVulkanShader* GetVertexShader() const { return VS; }
 	FVulkanShader* GetGeometryShader() const { return GS; }
 	FVulkanShader* GetFragmentShader() const { return FS; }
+	FVulkanShader* GetComputeShader() const { return CS; }
 	void SetVertexShader(FVulkanShader* InVS) { VS = InVS; }
 	void SetGeometryShader(FVulkanShader* InGS) { GS = InGS; }
 	void SetFragmentShader(FVulkanShader* InFS) { FS = InFS; }
+	void SetComputeShader(FVulkanShader* InCS) { CS = InCS; }
 
 	void CreateLayout(const VkPipelineLayoutCreateInfo& CI);
 	void CreatePipeline(const VkGraphicsPipelineCreateInfo& CI);
+	void CreatePipeline(const VkComputePipelineCreateInfo& CI);
 
 private:
 	VkPipelineLayout Layout;
 	VkPipeline Pipeline;
+	std::atomic<bool> bReady;
 	FVulkanShader* VS;
 	FVulkanShader* GS;
 	FVulkanShader* FS;
+	FVulkanShader* CS;
 };
 
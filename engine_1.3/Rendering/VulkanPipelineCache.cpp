@@ -0,0 +1,153 @@
+#include "VulkanPipelineCache.h"
+#include "VulkanContext.h"
+#include "VulkanHelpers.h"
+
+#include "Config.h"
+#include "Utils.h"
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+// Layout of VkPipelineCacheHeaderVersionOne, which older SDK headers do not declare.
+struct FPipelineCacheHeader
+{
+	uint32_t HeaderSize;
+	uint32_t HeaderVersion;
+	uint32_t VendorID;
+	uint32_t DeviceID;
+	uint8_t PipelineCacheUUID[VK_UUID_SIZE];
+};
+
+FVulkanPipelineCache::FVulkanPipelineCache(FVulkanContext* InContext)
+	: FVulkanObject(InContext)
+	, Cache(VK_NULL_HANDLE)
+	, DeviceProperties{}
+	, bWarm(false)
+	, LoadedBytes(0)
+	, NumPipelines(0)
+	, CreateNanoseconds(0)
+{
+	vkGetPhysicalDeviceProperties(Context->GetPhysicalDevice(), &DeviceProperties);
+
+	GConfig->Get("PipelineCachePath", Path);
+
+	bool bCold = false;
+	GConfig->Get("PipelineCacheCold", bCold);
+
+	std::vector<char> Data;
+	if (Path.empty() == false && bCold == false && ReadFile(Path, Data))
+	{
+		if (IsCompatible(Data))
+		{
+			bWarm = true;
+			LoadedBytes = Data.size();
+		}
+		else
+		{
+			std::cout << "Ignoring pipeline cache " << Path << ", it was written by a different device or driver" << std::endl;
+			Data.clear();
+		}
+	}
+
+	Cache = CreateCache(Data);
+}
+
+void FVulkanPipelineCache::Destroy()
+{
+	Save();
+
+	vkDestroyPipelineCache(Context->GetDevice(), Cache, nullptr);
+	Cache = VK_NULL_HANDLE;
+}
+
+bool FVulkanPipelineCache::IsCompatible(const std::vector<char>& InData) const
+{
+	FPipelineCacheHeader Header;
+	if (InData.size() < sizeof(Header))
+	{
+		return false;
+	}
+
+	memcpy(&Header, InData.data(), sizeof(Header));
+
+	// Drivers reject mismatching data themselves, but some only do so after a crash, so check before handing it over.
+	return Header.HeaderSize >= sizeof(Header)
+		&& Header.HeaderVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+		&& Header.VendorID == DeviceProperties.vendorID
+		&& Header.DeviceID == DeviceProperties.deviceID
+		&& memcmp(Header.PipelineCacheUUID, DeviceProperties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+VkPipelineCache FVulkanPipelineCache::CreateCache(const std::vector<char>& InData) const
+{
+	VkPipelineCacheCreateInfo PipelineCacheCI{};
+	PipelineCacheCI.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+	PipelineCacheCI.initialDataSize = InData.size();
+	PipelineCacheCI.pInitialData = InData.empty() ? nullptr : InData.data();
+
+	VkPipelineCache NewCache = VK_NULL_HANDLE;
+	VK_ASSERT(vkCreatePipelineCache(Context->GetDevice(), &PipelineCacheCI, nullptr, &NewCache));
+
+	return NewCache;
+}
+
+void FVulkanPipelineCache::RecordPipelineCreation(uint64_t InNanoseconds)
+{
+	NumPipelines.fetch_add(1, std::memory_order_relaxed);
+	CreateNanoseconds.fetch_add(InNanoseconds, std::memory_order_relaxed);
+}
+
+bool FVulkanPipelineCache::Save()
+{
+	if (Path.empty() || Cache == VK_NULL_HANDLE)
+	{
+		return false;
+	}
+
+	VkDevice Device = Context->GetDevice();
+
+	// Another instance may have written the file since it was loaded; merge its pipelines in so they are not lost.
+	std::vector<char> DiskData;
+	if (ReadFile(Path, DiskData) && IsCompatible(DiskData))
+	{
+		VkPipelineCache DiskCache = CreateCache(DiskData);
+		VK_ASSERT(vkMergePipelineCaches(Device, Cache, 1, &DiskCache));
+		vkDestroyPipelineCache(Device, DiskCache, nullptr);
+	}
+
+	size_t DataSize = 0;
+	VK_ASSERT(vkGetPipelineCacheData(Device, Cache, &DataSize, nullptr));
+
+	std::vector<char> Data(DataSize);
+	VK_ASSERT(vkGetPipelineCacheData(Device, Cache, &DataSize, Data.data()));
+	Data.resize(DataSize);
+
+	// Write next to the target and swap it in, so a crash mid-write never leaves a truncated cache behind.
+	const std::string TempPath = Path + ".tmp";
+	if (WriteFile(TempPath, Data.data(), Data.size()) == false)
+	{
+		std::cerr << "Failed to write " << TempPath << std::endl;
+		return false;
+	}
+
+	std::remove(Path.c_str());
+	if (std::rename(TempPath.c_str(), Path.c_str()) != 0)
+	{
+		std::cerr << "Failed to write " << Path << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+FPipelineCacheStats FVulkanPipelineCache::GetStats() const
+{
+	FPipelineCacheStats Stats;
+	Stats.bWarm = bWarm;
+	Stats.LoadedBytes = LoadedBytes;
+	Stats.NumPipelines = NumPipelines.load(std::memory_order_relaxed);
+	Stats.CreateMs = static_cast<double>(CreateNanoseconds.load(std::memory_order_relaxed)) / 1000000.0;
+
+	return Stats;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "VulkanObject.h"
+
+#include "vulkan/vulkan.h"
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+struct FPipelineCacheStats
+{
+	// Whether the cache started from a valid file, i.e. pipelines were created warm.
+	bool bWarm = false;
+	size_t LoadedBytes = 0;
+
+	uint32_t NumPipelines = 0;
+	double CreateMs = 0.0;
+};
+
+// Context-wide VkPipelineCache shared by all pipeline creation. It is loaded from disk at startup when the
+// file's header matches this device, and merged with whatever is on disk again and written back at shutdown.
+class FVulkanPipelineCache : public FVulkanObject
+{
+public:
+	FVulkanPipelineCache(class FVulkanContext* InContext);
+
+	virtual void Destroy() override;
+
+	VkPipelineCache GetCache() const { return Cache; }
+
+	// Called by every pipeline creation so startup cost can be compared between cold and warm runs.
+	void RecordPipelineCreation(uint64_t InNanoseconds);
+
+	bool Save();
+
+	FPipelineCacheStats GetStats() const;
+
+protected:
+	bool IsCompatible(const std::vector<char>& InData) const;
+	VkPipelineCache CreateCache(const std::vector<char>& InData) const;
+
+protected:
+	VkPipelineCache Cache;
+
+	std::string Path;
+	VkPhysicalDeviceProperties DeviceProperties;
+
+	bool bWarm;
+	size_t LoadedBytes;
+
+	std::atomic<uint32_t> NumPipelines;
+	std::atomic<uint64_t> CreateNanoseconds;
+};
@@ -0,0 +1,362 @@
+#include "VulkanPipelineLibrary.h"
+#include "VulkanContext.h"
+#include "VulkanHelpers.h"
+#include "VulkanPipeline.h"
+#include "VulkanShader.h"
+#include "VulkanShaderCache.h"
+
+#include "Config.h"
+#include "Utils.h"
+#include "CpuProfiler.h"
+
+#include <array>
+#include <algorithm>
+#include <cstring>
+
+static const int32_t DefaultPipelineCompileThreads = 2;
+
+FGraphicsPipelineDesc::FGraphicsPipelineDesc()
+	: ColorBlendAttachment(Vk::GetColorBlendAttachment())
+{
+}
+
+bool FGraphicsPipelineDesc::operator==(const FGraphicsPipelineDesc& RHS) const
+{
+	auto SameBindings = [](const VkVertexInputBindingDescription& A, const VkVertexInputBindingDescription& B)
+	{
+		return A.binding == B.binding && A.stride == B.stride && A.inputRate == B.inputRate;
+	};
+
+	auto SameAttributes = [](const VkVertexInputAttributeDescription& A, const VkVertexInputAttributeDescription& B)
+	{
+		return A.location == B.location && A.binding == B.binding && A.format == B.format && A.offset == B.offset;
+	};
+
+	return VS == RHS.VS
+		&& GS == RHS.GS
+		&& FS == RHS.FS
+		&& SpecializationConstants == RHS.SpecializationConstants
+		&& std::equal(VertexBindings.begin(), VertexBindings.end(), RHS.VertexBindings.begin(), RHS.VertexBindings.end(), SameBindings)
+		&& std::equal(VertexAttributes.begin(), VertexAttributes.end(), RHS.VertexAttributes.begin(), RHS.VertexAttributes.end(), SameAttributes)
+		&& SetLayouts == RHS.SetLayouts
+		&& RenderPass == RHS.RenderPass
+		&& Subpass == RHS.Subpass
+		&& Topology == RHS.Topology
+		&& PolygonMode == RHS.PolygonMode
+		&& CullMode == RHS.CullMode
+		&& FrontFace == RHS.FrontFace
+		&& bDepthTest == RHS.bDepthTest
+		&& bDepthWrite == RHS.bDepthWrite
+		&& DepthCompareOp == RHS.DepthCompareOp
+		&& memcmp(&ColorBlendAttachment, &RHS.ColorBlendAttachment, sizeof(ColorBlendAttachment)) == 0;
+}
+
+size_t FGraphicsPipelineDesc::GetHash() const
+{
+	size_t Hash = 0;
+
+	CombineHash(Hash, VS);
+	CombineHash(Hash, GS);
+	CombineHash(Hash, FS);
+
+	for (uint32_t Constant : SpecializationConstants)
+	{
+		CombineHash(Hash, Constant);
+	}
+
+	for (const VkVertexInputBindingDescription& Binding : VertexBindings)
+	{
+		CombineHash(Hash, Binding.binding);
+		CombineHash(Hash, Binding.stride);
+		CombineHash(Hash, static_cast<uint32_t>(Binding.inputRate));
+	}
+
+	for (const VkVertexInputAttributeDescription& Attribute : VertexAttributes)
+	{
+		CombineHash(Hash, Attribute.location);
+		CombineHash(Hash, Attribute.binding);
+		CombineHash(Hash, static_cast<uint32_t>(Attribute.format));
+		CombineHash(Hash, Attribute.offset);
+	}
+
+	for (VkDescriptorSetLayout SetLayout : SetLayouts)
+	{
+		CombineHash(Hash, SetLayout);
+	}
+
+	CombineHash(Hash, RenderPass);
+	CombineHash(Hash, Subpass);
+	CombineHash(Hash, static_cast<uint32_t>(Topology));
+	CombineHash(Hash, static_cast<uint32_t>(PolygonMode));
+	CombineHash(Hash, static_cast<uint32_t>(CullMode));
+	CombineHash(Hash, static_cast<uint32_t>(FrontFace));
+	CombineHash(Hash, bDepthTest);
+	CombineHash(Hash, bDepthWrite);
+	CombineHash(Hash, static_cast<uint32_t>(DepthCompareOp));
+	CombineHash(Hash, ColorBlendAttachment.blendEnable);
+	CombineHash(Hash, ColorBlendAttachment.colorWriteMask);
+
+	return Hash;
+}
+
+FVulkanPipelineLibrary::FVulkanPipelineLibrary(FVulkanContext* InContext)
+	: FVulkanObject(InContext)
+	, NumHits(0)
+	, NumMisses(0)
+	, bStopping(false)
+	, NumPending(0)
+{
+	// With no workers, requested pipelines are compiled on the calling thread like GetGraphicsPipeline does.
+	int32_t NumThreads = DefaultPipelineCompileThreads;
+	GConfig->Get("PipelineCompileThreads", NumThreads);
+
+	for (int32_t Idx = 0; Idx < NumThreads; ++Idx)
+	{
+		Workers.emplace_back(&FVulkanPipelineLibrary::Run, this);
+	}
+}
+
+void FVulkanPipelineLibrary::Destroy()
+{
+	{
+		std::lock_guard<std::mutex> Lock(Mutex);
+		bStopping = true;
+
+		// Nothing waits on pipelines that have not started compiling yet, so drop them instead of finishing them.
+		NumPending -= static_cast<uint32_t>(Queue.size());
+		Queue.clear();
+	}
+	Condition.notify_all();
+
+	for (std::thread& Worker : Workers)
+	{
+		Worker.join();
+	}
+	Workers.clear();
+
+	FVulkanShaderCache* ShaderCache = Context->GetShaderCache();
+	for (auto& Pair : GraphicsPipelines)
+	{
+		for (FVulkanShader* Shader : { Pair.first.VS, Pair.first.GS, Pair.first.FS })
+		{
+			ShaderCache->Release(Shader);
+		}
+
+		Context->DestroyObject(Pair.second);
+	}
+	GraphicsPipelines.clear();
+}
+
+FVulkanPipeline* FVulkanPipelineLibrary::FindOrCreate(const FGraphicsPipelineDesc& InDesc, bool& OutbCreated)
+{
+	auto Iter = GraphicsPipelines.find(InDesc);
+	if (Iter != GraphicsPipelines.end())
+	{
+		++NumHits;
+		OutbCreated = false;
+		return Iter->second;
+	}
+
+	++NumMisses;
+
+	FVulkanPipeline* Pipeline = Context->CreateObject<FVulkanPipeline>();
+	Pipeline->SetVertexShader(InDesc.VS);
+	Pipeline->SetGeometryShader(InDesc.GS);
+	Pipeline->SetFragmentShader(InDesc.FS);
+
+	GraphicsPipelines.emplace(InDesc, Pipeline);
+
+	// The shaders have to outlive any compile still running on a worker, and the key compares them by pointer.
+	FVulkanShaderCache* ShaderCache = Context->GetShaderCache();
+	for (FVulkanShader* Shader : { InDesc.VS, InDesc.GS, InDesc.FS })
+	{
+		ShaderCache->AddRef(Shader);
+	}
+
+	OutbCreated = true;
+	return Pipeline;
+}
+
+FVulkanPipeline* FVulkanPipelineLibrary::GetGraphicsPipeline(const FGraphicsPipelineDesc& InDesc)
+{
+	bool bCreated = false;
+	FVulkanPipeline* Pipeline = FindOrCreate(InDesc, bCreated);
+
+	if (bCreated)
+	{
+		Compile(InDesc, Pipeline);
+	}
+	else if (Pipeline->IsReady() == false)
+	{
+		std::unique_lock<std::mutex> Lock(Mutex);
+		CompiledCondition.wait(Lock, [Pipeline]() { return Pipeline->IsReady(); });
+	}
+
+	return Pipeline;
+}
+
+FVulkanPipeline* FVulkanPipelineLibrary::RequestGraphicsPipeline(const FGraphicsPipelineDesc& InDesc)
+{
+	bool bCreated = false;
+	FVulkanPipeline* Pipeline = FindOrCreate(InDesc, bCreated);
+
+	if (bCreated == false)
+	{
+		return Pipeline;
+	}
+
+	if (Workers.empty())
+	{
+		Compile(InDesc, Pipeline);
+		return Pipeline;
+	}
+
+	++NumPending;
+	{
+		std::lock_guard<std::mutex> Lock(Mutex);
+		Queue.push_back({ InDesc, Pipeline });
+	}
+	Condition.notify_one();
+
+	return Pipeline;
+}
+
+void FVulkanPipelineLibrary::Run()
+{
+	CPU_PROFILE_THREAD("Pipeline Compiler");
+
+	while (true)
+	{
+		FCompileJob Job;
+		{
+			std::unique_lock<std::mutex> Lock(Mutex);
+			Condition.wait(Lock, [this]() { return bStopping || Queue.empty() == false; });
+
+			if (bStopping)
+			{
+				return;
+			}
+
+			Job = std::move(Queue.front());
+			Queue.pop_front();
+		}
+
+		Compile(Job.Desc, Job.Pipeline);
+
+		{
+			// Taking the lock orders the notification after a waiter's readiness check.
+			std::lock_guard<std::mutex> Lock(Mutex);
+			--NumPending;
+		}
+		CompiledCondition.notify_all();
+	}
+}
+
+void FVulkanPipelineLibrary::Compile(const FGraphicsPipelineDesc& InDesc, FVulkanPipeline* InPipeline)
+{
+	CPU_PROFILE_SCOPE("FVulkanPipelineLibrary::Compile");
+
+	std::vector<VkSpecializationMapEntry> SpecializationEntries;
+	for (uint32_t Idx = 0; Idx < InDesc.SpecializationConstants.size(); ++Idx)
+	{
+		SpecializationEntries.push_back({ Idx, Idx * static_cast<uint32_t>(sizeof(uint32_t)), sizeof(uint32_t) });
+	}
+
+	VkSpecializationInfo SpecializationInfo{};
+	SpecializationInfo.mapEntryCount = static_cast<uint32_t>(SpecializationEntries.size());
+	SpecializationInfo.pMapEntries = SpecializationEntries.data();
+	SpecializationInfo.dataSize = InDesc.SpecializationConstants.size() * sizeof(uint32_t);
+	SpecializationInfo.pData = InDesc.SpecializationConstants.data();
+
+	std::vector<VkPipelineShaderStageCreateInfo> ShaderStageCIs;
+
+	const std::array<std::pair<FVulkanShader*, VkShaderStageFlagBits>, 3> Stages =
+	{ {
+		{ InDesc.VS, VK_SHADER_STAGE_VERTEX_BIT },
+		{ InDesc.GS, VK_SHADER_STAGE_GEOMETRY_BIT },
+		{ InDesc.FS, VK_SHADER_STAGE_FRAGMENT_BIT },
+	} };
+
+	for (const auto& Stage : Stages)
+	{
+		if (Stage.first == nullptr)
+		{
+			continue;
+		}
+
+		VkPipelineShaderStageCreateInfo ShaderStageCI{};
+		ShaderStageCI.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		ShaderStageCI.stage = Stage.second;
+		ShaderStageCI.module = Stage.first->GetModule();
+		ShaderStageCI.pName = "main";
+		ShaderStageCI.pSpecializationInfo = SpecializationEntries.empty() ? nullptr : &SpecializationInfo;
+
+		ShaderStageCIs.push_back(ShaderStageCI);
+	}
+
+	VkPipelineVertexInputStateCreateInfo VertexInputStateCI = Vk::GetVertexInputStateCI(InDesc.VertexBindings, InDesc.VertexAttributes);
+
+	VkPipelineInputAssemblyStateCreateInfo InputAssemblyStateCI = Vk::GetInputAssemblyStateCI();
+	InputAssemblyStateCI.topology = InDesc.Topology;
+
+	VkPipelineViewportStateCreateInfo ViewportStateCI = Vk::GetViewportStateCI();
+
+	VkPipelineRasterizationStateCreateInfo RasterizerCI = Vk::GetRasterizationStateCI();
+	RasterizerCI.polygonMode = InDesc.PolygonMode;
+	RasterizerCI.cullMode = InDesc.CullMode;
+	RasterizerCI.frontFace = InDesc.FrontFace;
+
+	VkPipelineMultisampleStateCreateInfo MultisampleStateCI = Vk::GetMultisampleStateCI();
+
+	VkPipelineDepthStencilStateCreateInfo DepthStencilStateCI = Vk::GetDepthStencilStateCI();
+	DepthStencilStateCI.depthTestEnable = InDesc.bDepthTest ? VK_TRUE : VK_FALSE;
+	DepthStencilStateCI.depthWriteEnable = InDesc.bDepthWrite ? VK_TRUE : VK_FALSE;
+	DepthStencilStateCI.depthCompareOp = InDesc.DepthCompareOp;
+
+	VkPipelineColorBlendStateCreateInfo ColorBlendStateCI = Vk::GetColorBlendStateCI();
+	ColorBlendStateCI.pAttachments = &InDesc.ColorBlendAttachment;
+
+	std::vector<VkDynamicState> DynamicStates = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+
+	VkPipelineDynamicStateCreateInfo DynamicStateCI{};
+	DynamicStateCI.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+	DynamicStateCI.dynamicStateCount = static_cast<uint32_t>(DynamicStates.size());
+	DynamicStateCI.pDynamicStates = DynamicStates.data();
+
+	VkPipelineLayoutCreateInfo PipelineLayoutCI{};
+	PipelineLayoutCI.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	PipelineLayoutCI.setLayoutCount = static_cast<uint32_t>(InDesc.SetLayouts.size());
+	PipelineLayoutCI.pSetLayouts = InDesc.SetLayouts.data();
+
+	InPipeline->CreateLayout(PipelineLayoutCI);
+
+	VkGraphicsPipelineCreateInfo PipelineCI{};
+	PipelineCI.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+	PipelineCI.stageCount = static_cast<uint32_t>(ShaderStageCIs.size());
+	PipelineCI.pStages = ShaderStageCIs.data();
+	PipelineCI.pVertexInputState = &VertexInputStateCI;
+	PipelineCI.pInputAssemblyState = &InputAssemblyStateCI;
+	PipelineCI.pViewportState = &ViewportStateCI;
+	PipelineCI.pRasterizationState = &RasterizerCI;
+	PipelineCI.pDepthStencilState = &DepthStencilStateCI;
+	PipelineCI.pMultisampleState = &MultisampleStateCI;
+	PipelineCI.pColorBlendState = &ColorBlendStateCI;
+	PipelineCI.pDynamicState = &DynamicStateCI;
+	PipelineCI.layout = InPipeline->GetLayout();
+	PipelineCI.renderPass = InDesc.RenderPass;
+	PipelineCI.subpass = InDesc.Subpass;
+	PipelineCI.basePipelineHandle = VK_NULL_HANDLE;
+
+	InPipeline->CreatePipeline(PipelineCI);
+}
+
+FPipelineLibraryStats FVulkanPipelineLibrary::GetStats() const
+{
+	FPipelineLibraryStats Stats;
+	Stats.NumPipelines = static_cast<uint32_t>(GraphicsPipelines.size());
+	Stats.NumHits = NumHits;
+	Stats.NumMisses = NumMisses;
+	Stats.NumPending = NumPending.load();
+
+	return Stats;
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "VulkanObject.h"
+
+#include "vulkan/vulkan.h"
+
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+#include <condition_variable>
+
+// Everything that goes into a graphics pipeline. Viewport and scissor are always dynamic.
+struct FGraphicsPipelineDesc
+{
+	// Shaders from the context's shader cache, which shares one object per SPIR-V, so they compare by pointer.
+	class FVulkanShader* VS = nullptr;
+	class FVulkanShader* GS = nullptr;
+	class FVulkanShader* FS = nullptr;
+
+	// 32-bit specialization constant values indexed by constant_id, applied to every stage. Stages ignore IDs
+	// they do not declare, so one list covers a whole shader permutation.
+	std::vector<uint32_t> SpecializationConstants;
+
+	std::vector<VkVertexInputBindingDescription> VertexBindings;
+	std::vector<VkVertexInputAttributeDescription> VertexAttributes;
+
+	std::vector<VkDescriptorSetLayout> SetLayouts;
+
+	VkRenderPass RenderPass = VK_NULL_HANDLE;
+	uint32_t Subpass = 0;
+
+	VkPrimitiveTopology Topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+	VkPolygonMode PolygonMode = VK_POLYGON_MODE_FILL;
+	VkCullModeFlags CullMode = VK_CULL_MODE_BACK_BIT;
+	VkFrontFace FrontFace = VK_FRONT_FACE_CLOCKWISE;
+
+	bool bDepthTest = true;
+	bool bDepthWrite = true;
+	VkCompareOp DepthCompareOp = VK_COMPARE_OP_LESS;
+
+	VkPipelineColorBlendAttachmentState ColorBlendAttachment;
+
+	FGraphicsPipelineDesc();
+
+	bool operator==(const FGraphicsPipelineDesc& RHS) const;
+	size_t GetHash() const;
+};
+
+struct FPipelineLibraryStats
+{
+	uint32_t NumPipelines = 0;
+	uint64_t NumHits = 0;
+	uint64_t NumMisses = 0;
+
+	// Requested pipelines still queued or compiling on the workers.
+	uint32_t NumPending = 0;
+};
+
+// Hands out graphics pipelines by description. Identical descriptions share one pipeline, so meshes whose
+// materials only differ in their parameters end up on the same pipeline and draw without rebinding it.
+// The library owns every pipeline it returns.
+//
+// Pipelines can also be requested asynchronously, in which case they compile on worker threads and the caller
+// keeps drawing with something else until IsReady() turns true. The context's VkPipelineCache is internally
+// synchronized, so the workers share it without extra locking.
+class FVulkanPipelineLibrary : public FVulkanObject
+{
+public:
+	FVulkanPipelineLibrary(class FVulkanContext* InContext);
+
+	virtual void Destroy() override;
+
+	// Returns a ready pipeline, compiling it on this thread or waiting for a worker that already started it.
+	class FVulkanPipeline* GetGraphicsPipeline(const FGraphicsPipelineDesc& InDesc);
+
+	// Returns immediately; a new pipeline is not ready until a worker has compiled it.
+	class FVulkanPipeline* RequestGraphicsPipeline(const FGraphicsPipelineDesc& InDesc);
+
+	FPipelineLibraryStats GetStats() const;
+
+protected:
+	class FVulkanPipeline* FindOrCreate(const FGraphicsPipelineDesc& InDesc, bool& OutbCreated);
+	void Compile(const FGraphicsPipelineDesc& InDesc, class FVulkanPipeline* InPipeline);
+
+	void Run();
+
+	struct FCompileJob
+	{
+		FGraphicsPipelineDesc Desc;
+		class FVulkanPipeline* Pipeline = nullptr;
+	};
+
+	struct FDescHasher
+	{
+		size_t operator()(const FGraphicsPipelineDesc& InDesc) const { return InDesc.GetHash(); }
+	};
+
+protected:
+	std::unordered_map<FGraphicsPipelineDesc, class FVulkanPipeline*, FDescHasher> GraphicsPipelines;
+
+	uint64_t NumHits;
+	uint64_t NumMisses;
+
+	std::vector<std::thread> Workers;
+	std::mutex Mutex;
+	std::condition_variable Condition;
+	std::condition_variable CompiledCondition;
+	std::deque<FCompileJob> Queue;
+	bool bStopping;
+
+	std::atomic<uint32_t> NumPending;
+};
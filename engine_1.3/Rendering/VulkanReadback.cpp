@@ -0,0 +1,375 @@
+#include "VulkanReadback.h"
+#include "VulkanContext.h"
+#include "VulkanHelpers.h"
+#include "VulkanBuffer.h"
+#include "VulkanViewport.h"
+#include "VulkanSwapchain.h"
+
+#include "Config.h"
+#include "Utils.h"
+#include "CpuProfiler.h"
+
+#include <iomanip>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+
+static const int32_t MinReadbackSlots = 1;
+static const int32_t DefaultCaptureQueueLimit = 8;
+static const uint32_t ReadbackBytesPerTexel = 4;
+
+static bool HasMemoryType(VkPhysicalDevice InPhysicalDevice, VkMemoryPropertyFlags InProperties)
+{
+	VkPhysicalDeviceMemoryProperties MemoryProperties;
+	vkGetPhysicalDeviceMemoryProperties(InPhysicalDevice, &MemoryProperties);
+
+	for (uint32_t Idx = 0; Idx < MemoryProperties.memoryTypeCount; ++Idx)
+	{
+		if ((MemoryProperties.memoryTypes[Idx].propertyFlags & InProperties) == InProperties)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static bool IsBGRA(VkFormat InFormat)
+{
+	return InFormat == VK_FORMAT_B8G8R8A8_SRGB || InFormat == VK_FORMAT_B8G8R8A8_UNORM;
+}
+
+FReadbackEncoder::FReadbackEncoder(const std::string& InDirectory, EReadbackFileFormat InFileFormat, uint32_t InMaxQueuedImages)
+	: Directory(InDirectory)
+	, FileFormat(InFileFormat)
+	, MaxQueuedImages(std::max(InMaxQueuedImages, 1U))
+	, bStopping(false)
+	, NumWritten(0)
+{
+	if (Directory.empty() == false && Directory.back() != '/' && Directory.back() != '\\')
+	{
+		Directory += '/';
+	}
+
+	Thread = std::thread(&FReadbackEncoder::Run, this);
+}
+
+FReadbackEncoder::~FReadbackEncoder()
+{
+	{
+		std::lock_guard<std::mutex> Lock(Mutex);
+		bStopping = true;
+	}
+	Condition.notify_one();
+
+	// Whatever is still queued gets written before the thread exits.
+	Thread.join();
+}
+
+bool FReadbackEncoder::Enqueue(const std::shared_ptr<const FReadbackImage>& InImage)
+{
+	{
+		std::lock_guard<std::mutex> Lock(Mutex);
+		if (Queue.size() >= MaxQueuedImages)
+		{
+			return false;
+		}
+		Queue.push_back(InImage);
+	}
+	Condition.notify_one();
+
+	return true;
+}
+
+void FReadbackEncoder::Run()
+{
+	CPU_PROFILE_THREAD("Readback Encoder");
+
+	while (true)
+	{
+		std::shared_ptr<const FReadbackImage> Image;
+		{
+			std::unique_lock<std::mutex> Lock(Mutex);
+			Condition.wait(Lock, [this]() { return bStopping || Queue.empty() == false; });
+
+			if (Queue.empty())
+			{
+				return;
+			}
+
+			Image = Queue.front();
+			Queue.pop_front();
+		}
+
+		Write(*Image);
+	}
+}
+
+void FReadbackEncoder::Write(const FReadbackImage& InImage)
+{
+	CPU_PROFILE_SCOPE("FReadbackEncoder::Write");
+
+	std::ostringstream Filename;
+	Filename << Directory << "frame_" << std::setw(6) << std::setfill('0') << InImage.FrameNumber;
+
+	bool bWritten = false;
+	if (FileFormat == EReadbackFileFormat::PNG)
+	{
+		Filename << ".png";
+
+		if (IsBGRA(InImage.Format))
+		{
+			std::vector<uint8_t> RGBA(InImage.Pixels);
+			for (size_t Idx = 0; Idx < RGBA.size(); Idx += ReadbackBytesPerTexel)
+			{
+				std::swap(RGBA[Idx], RGBA[Idx + 2]);
+			}
+			bWritten = WritePNG(Filename.str(), InImage.Width, InImage.Height, RGBA.data());
+		}
+		else
+		{
+			bWritten = WritePNG(Filename.str(), InImage.Width, InImage.Height, InImage.Pixels.data());
+		}
+	}
+	else
+	{
+		Filename << "_" << InImage.Width << "x" << InImage.Height << (IsBGRA(InImage.Format) ? "_bgra" : "_rgba") << ".raw";
+		bWritten = WriteFile(Filename.str(), InImage.Pixels.data(), InImage.Pixels.size());
+	}
+
+	if (bWritten)
+	{
+		++NumWritten;
+	}
+	else
+	{
+		std::cerr << "Failed to write capture " << Filename.str() << std::endl;
+	}
+}
+
+FVulkanReadback::FVulkanReadback(FVulkanContext* InContext)
+	: FVulkanObject(InContext)
+	, NextSlot(0)
+	, MemoryProperties(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)
+	, bEnabled(false)
+	, FrameNumber(0)
+	, NumCaptured(0)
+	, NumDropped(0)
+{
+	// One slot more than frames in flight lets a copy land every frame without waiting on the oldest one.
+	int32_t ConfigSlots = static_cast<int32_t>(Context->GetMaxConcurrentFrames()) + 1;
+	GConfig->Get("ReadbackRingSize", ConfigSlots);
+	Slots.resize(static_cast<size_t>(std::max(ConfigSlots, MinReadbackSlots)));
+
+	// CPU reads of uncached memory are painfully slow, so prefer cached memory and invalidate by hand.
+	const VkMemoryPropertyFlags CachedProperties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+	if (HasMemoryType(Context->GetPhysicalDevice(), CachedProperties))
+	{
+		MemoryProperties = CachedProperties;
+	}
+}
+
+void FVulkanReadback::Destroy()
+{
+	// The device is idle by now, so this flushes the last few frames to the callbacks and the encoder.
+	Poll();
+	StopCapture();
+
+	for (FSlot& Slot : Slots)
+	{
+		Context->DestroyObject(Slot.Buffer);
+		Slot = FSlot();
+	}
+}
+
+void FVulkanReadback::StartCapture(const std::string& InDirectory, EReadbackFileFormat InFileFormat)
+{
+	int32_t QueueLimit = DefaultCaptureQueueLimit;
+	GConfig->Get("CaptureQueueLimit", QueueLimit);
+
+	Encoder = std::make_unique<FReadbackEncoder>(InDirectory, InFileFormat, static_cast<uint32_t>(std::max(QueueLimit, 1)));
+	bEnabled = true;
+}
+
+void FVulkanReadback::StopCapture()
+{
+	Encoder.reset();
+	bEnabled = false;
+}
+
+void FVulkanReadback::Poll()
+{
+	if (std::none_of(Slots.begin(), Slots.end(), [](const FSlot& InSlot) { return InSlot.bPending; }))
+	{
+		return;
+	}
+
+	const uint64_t CompletedValue = Context->GetCompletedTimelineValue();
+
+	// Walk the ring from the oldest slot so frames are delivered in order.
+	for (size_t Offset = 0; Offset < Slots.size(); ++Offset)
+	{
+		FSlot& Slot = Slots[(NextSlot + Offset) % Slots.size()];
+		if (Slot.bPending && Slot.TimelineValue <= CompletedValue)
+		{
+			Deliver(Slot);
+		}
+	}
+}
+
+void FVulkanReadback::Deliver(FSlot& InSlot)
+{
+	InSlot.bPending = false;
+
+	// During context teardown the ring buffers may already be gone.
+	if (Context->IsValidObject(InSlot.BufferHandle) == false)
+	{
+		return;
+	}
+
+	if ((MemoryProperties & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) == 0)
+	{
+		VkMappedMemoryRange Range{};
+		Range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+		Range.memory = InSlot.Buffer->GetMemory();
+		Range.offset = 0;
+		Range.size = VK_WHOLE_SIZE;
+
+		VK_ASSERT(vkInvalidateMappedMemoryRanges(Context->GetDevice(), 1, &Range));
+	}
+
+	std::shared_ptr<FReadbackImage> Image = std::make_shared<FReadbackImage>();
+	Image->FrameNumber = InSlot.FrameNumber;
+	Image->Width = InSlot.Width;
+	Image->Height = InSlot.Height;
+	Image->Format = InSlot.Format;
+
+	const uint8_t* Mapped = static_cast<const uint8_t*>(InSlot.Buffer->GetMappedAddress());
+	Image->Pixels.assign(Mapped, Mapped + static_cast<size_t>(InSlot.Width) * InSlot.Height * ReadbackBytesPerTexel);
+
+	++NumCaptured;
+
+	std::shared_ptr<const FReadbackImage> ConstImage = Image;
+	for (const FReadbackCallback& Callback : Callbacks)
+	{
+		Callback(ConstImage);
+	}
+
+	if (Encoder != nullptr && Encoder->Enqueue(ConstImage) == false)
+	{
+		++NumDropped;
+	}
+}
+
+void FVulkanReadback::RecordCopy(VkCommandBuffer InCommandBuffer)
+{
+	if (bEnabled == false)
+	{
+		return;
+	}
+
+	const uint64_t CurrentFrameNumber = FrameNumber++;
+
+	FVulkanSwapchain* Swapchain = Context->GetViewport()->GetSwapchain();
+	if ((Swapchain->GetImageUsage() & VK_IMAGE_USAGE_TRANSFER_SRC_BIT) == 0)
+	{
+		return;
+	}
+
+	FSlot& Slot = Slots[NextSlot];
+	if (Slot.bPending)
+	{
+		++NumDropped;
+		return;
+	}
+
+	const VkExtent2D Extent = Swapchain->GetExtent();
+	const VkDeviceSize Size = static_cast<VkDeviceSize>(Extent.width) * Extent.height * ReadbackBytesPerTexel;
+
+	if (Slot.Buffer == nullptr || Slot.Buffer->GetAllocatedSize() < Size)
+	{
+		Context->DestroyObject(Slot.Buffer);
+
+		Slot.Buffer = Context->CreateObject<FVulkanBuffer>();
+		Slot.BufferHandle = Slot.Buffer->GetObjectHandle();
+		Slot.Buffer->SetUsage(VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+		Slot.Buffer->SetProperties(MemoryProperties);
+		Slot.Buffer->Allocate(Size);
+		Slot.Buffer->Map();
+	}
+
+	Slot.TimelineValue = Context->GetRecordingTimelineValue();
+	Slot.FrameNumber = CurrentFrameNumber;
+	Slot.Width = Extent.width;
+	Slot.Height = Extent.height;
+	Slot.Format = Swapchain->GetFormat();
+	Slot.bPending = true;
+
+	NextSlot = (NextSlot + 1) % static_cast<uint32_t>(Slots.size());
+
+	VkImage Image = Swapchain->GetImages()[Swapchain->GetCurrentImageIndex()];
+	const VkImageLayout FinalLayout = Swapchain->GetFinalLayout();
+
+	VkImageMemoryBarrier ToTransfer{};
+	ToTransfer.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	ToTransfer.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	ToTransfer.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+	ToTransfer.oldLayout = FinalLayout;
+	ToTransfer.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	ToTransfer.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	ToTransfer.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	ToTransfer.image = Image;
+	ToTransfer.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	ToTransfer.subresourceRange.baseMipLevel = 0;
+	ToTransfer.subresourceRange.levelCount = 1;
+	ToTransfer.subresourceRange.baseArrayLayer = 0;
+	ToTransfer.subresourceRange.layerCount = 1;
+
+	vkCmdPipelineBarrier(
+		InCommandBuffer,
+		VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+		VK_PIPELINE_STAGE_TRANSFER_BIT,
+		0,
+		0, nullptr,
+		0, nullptr,
+		1, &ToTransfer);
+
+	VkBufferImageCopy Region{};
+	Region.bufferOffset = 0;
+	Region.bufferRowLength = 0;
+	Region.bufferImageHeight = 0;
+	Region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	Region.imageSubresource.mipLevel = 0;
+	Region.imageSubresource.baseArrayLayer = 0;
+	Region.imageSubresource.layerCount = 1;
+	Region.imageOffset = { 0, 0, 0 };
+	Region.imageExtent = { Extent.width, Extent.height, 1 };
+
+	vkCmdCopyImageToBuffer(InCommandBuffer, Image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, Slot.Buffer->GetHandle(), 1, &Region);
+
+	// Make the copy visible to the host and hand the image back in the layout present expects.
+	VkBufferMemoryBarrier ToHost{};
+	ToHost.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	ToHost.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	ToHost.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+	ToHost.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	ToHost.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	ToHost.buffer = Slot.Buffer->GetHandle();
+	ToHost.offset = 0;
+	ToHost.size = VK_WHOLE_SIZE;
+
+	VkImageMemoryBarrier ToFinal = ToTransfer;
+	ToFinal.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+	ToFinal.dstAccessMask = 0;
+	ToFinal.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	ToFinal.newLayout = FinalLayout;
+
+	vkCmdPipelineBarrier(
+		InCommandBuffer,
+		VK_PIPELINE_STAGE_TRANSFER_BIT,
+		VK_PIPELINE_STAGE_HOST_BIT | VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+		0,
+		0, nullptr,
+		1, &ToHost,
+		1, &ToFinal);
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include "VulkanObject.h"
+
+#include "vulkan/vulkan.h"
+
+#include <deque>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <memory>
+#include <string>
+#include <vector>
+#include <functional>
+#include <condition_variable>
+
+struct FReadbackImage
+{
+	uint64_t FrameNumber = 0;
+	uint32_t Width = 0;
+	uint32_t Height = 0;
+	VkFormat Format = VK_FORMAT_UNDEFINED;
+
+	// Tightly packed rows, 4 bytes per texel in the swapchain's channel order.
+	std::vector<uint8_t> Pixels;
+};
+
+using FReadbackCallback = std::function<void(const std::shared_ptr<const FReadbackImage>&)>;
+
+enum class EReadbackFileFormat
+{
+	PNG,
+	Raw
+};
+
+// Writes captured frames to disk on its own thread so the render thread only pays for queueing them.
+class FReadbackEncoder
+{
+public:
+	FReadbackEncoder(const std::string& InDirectory, EReadbackFileFormat InFileFormat, uint32_t InMaxQueuedImages);
+	~FReadbackEncoder();
+
+	// Returns false without queueing when the disk has fallen too far behind.
+	bool Enqueue(const std::shared_ptr<const FReadbackImage>& InImage);
+
+	uint64_t GetNumWritten() const { return NumWritten; }
+
+protected:
+	void Run();
+	void Write(const FReadbackImage& InImage);
+
+protected:
+	std::string Directory;
+	EReadbackFileFormat FileFormat;
+	uint32_t MaxQueuedImages;
+
+	std::thread Thread;
+	std::mutex Mutex;
+	std::condition_variable Condition;
+	std::deque<std::shared_ptr<const FReadbackImage>> Queue;
+	bool bStopping;
+
+	std::atomic<uint64_t> NumWritten;
+};
+
+// Copies the final image of every frame into a ring of host-visible buffers and hands the pixels to the
+// callbacks once the frame timeline says the copy is done, which is usually a couple of frames later.
+// The render thread never waits on a capture: if every slot is still in flight the frame is skipped.
+class FVulkanReadback : public FVulkanObject
+{
+public:
+	FVulkanReadback(class FVulkanContext* InContext);
+
+	virtual void Destroy() override;
+
+	void AddCallback(const FReadbackCallback& InCallback) { Callbacks.push_back(InCallback); }
+
+	void SetEnabled(bool InbEnabled) { bEnabled = InbEnabled; }
+	bool IsEnabled() const { return bEnabled; }
+
+	// Enables the readback and streams every captured frame to InDirectory.
+	void StartCapture(const std::string& InDirectory, EReadbackFileFormat InFileFormat);
+	void StopCapture();
+
+	// Delivers every slot whose frame has finished on the GPU. Never blocks.
+	void Poll();
+
+	// Records the copy of the current swapchain image at the end of the frame's command buffer.
+	void RecordCopy(VkCommandBuffer InCommandBuffer);
+
+	uint64_t GetNumCaptured() const { return NumCaptured; }
+	uint64_t GetNumDropped() const { return NumDropped; }
+
+protected:
+	struct FSlot
+	{
+		class FVulkanBuffer* Buffer = nullptr;
+		FVulkanObjectHandle BufferHandle;
+		uint64_t TimelineValue = 0;
+		uint64_t FrameNumber = 0;
+		uint32_t Width = 0;
+		uint32_t Height = 0;
+		VkFormat Format = VK_FORMAT_UNDEFINED;
+		bool bPending = false;
+	};
+
+	void Deliver(FSlot& InSlot);
+
+protected:
+	std::vector<FSlot> Slots;
+	uint32_t NextSlot;
+
+	VkMemoryPropertyFlags MemoryProperties;
+
+	std::vector<FReadbackCallback> Callbacks;
+	std::unique_ptr<FReadbackEncoder> Encoder;
+
+	bool bEnabled;
+
+	uint64_t FrameNumber;
+	uint64_t NumCaptured;
+	uint64_t NumDropped;
+};
@@ -111,7 +111,7 @@ FVulkanRenderPass* FVulkanRenderPass::CreateBasePass_Internal(FVulkanContext* In
 	ColorAttachmentDesc.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 	ColorAttachmentDesc.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
 	ColorAttachmentDesc.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-	ColorAttachmentDesc.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+	ColorAttachmentDesc.finalLayout = Swapchain->GetFinalLayout();
 
 	VkAttachmentDescription DepthAttachmentDesc{};
 	DepthAttachmentDesc.format = Vk::FindDepthFormat(PhysicalDevice);
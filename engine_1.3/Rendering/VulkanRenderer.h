@@ -21,10 +21,17 @@ public:
 	virtual ~FVulkanRenderer();
 
 	void SetScene(class FVulkanScene* InScene) { Scene = InScene; }
+	class FVulkanScene* GetScene() const { return Scene; }
+
+	virtual const char* GetName() const { return "Renderer"; }
 
 	virtual void Render() = 0;
 	virtual void OnRecreateSwapchain() { }
 
+	// Called after recording, right before submit, once the scene camera has been re-sampled. Renderers
+	// rewrite the current frame's view-dependent uniforms here; the command buffer must not be touched.
+	virtual void LatchView() { }
+
 protected:
 	class FVulkanScene* Scene;
 };
@@ -4,30 +4,16 @@
 
 FVulkanSampler::FVulkanSampler(class FVulkanContext* InContext)
 	: FVulkanObject(InContext)
+	, Sampler(VK_NULL_HANDLE)
 {
-	VkPhysicalDevice PhysicalDevice = Context->GetPhysicalDevice();
-	VkDevice Device = Context->GetDevice();
 
-	VkPhysicalDeviceProperties Properties{};
-	vkGetPhysicalDeviceProperties(PhysicalDevice, &Properties);
+}
 
-	VkSamplerCreateInfo SamplerCI{};
-	SamplerCI.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
-	SamplerCI.magFilter = VK_FILTER_LINEAR;
-	SamplerCI.minFilter = VK_FILTER_LINEAR;
-	SamplerCI.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-	SamplerCI.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-	SamplerCI.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-	SamplerCI.mipLodBias = 0.0f;
-	SamplerCI.anisotropyEnable = VK_TRUE;
-	SamplerCI.maxAnisotropy = Properties.limits.maxSamplerAnisotropy;
-	SamplerCI.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
-	SamplerCI.unnormalizedCoordinates = VK_FALSE;
-	SamplerCI.compareEnable = VK_FALSE;
-	SamplerCI.compareOp = VK_COMPARE_OP_ALWAYS;
-	SamplerCI.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+void FVulkanSampler::Create(const VkSamplerCreateInfo& InSamplerCI)
+{
+	VkDevice Device = Context->GetDevice();
 
-	VK_ASSERT(vkCreateSampler(Device, &SamplerCI, nullptr, &Sampler));
+	VK_ASSERT(vkCreateSampler(Device, &InSamplerCI, nullptr, &Sampler));
 }
 
 void FVulkanSampler::Destroy()
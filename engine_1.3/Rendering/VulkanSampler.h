@@ -4,6 +4,7 @@
 
 #include "vulkan/vulkan.h"
 
+// Get samplers from the context's sampler cache rather than creating them directly.
 class FVulkanSampler : public FVulkanObject
 {
 public:
@@ -11,6 +12,8 @@ public:
 
 	virtual void Destroy() override;
 
+	void Create(const VkSamplerCreateInfo& InSamplerCI);
+
 	VkSampler GetSampler() const { return Sampler; }
 
 private:
@@ -0,0 +1,111 @@
+#include "VulkanSamplerCache.h"
+#include "VulkanContext.h"
+#include "VulkanSampler.h"
+
+#include "Utils.h"
+
+#include <algorithm>
+#include <cassert>
+
+FVulkanSamplerCache::FVulkanSamplerCache(FVulkanContext* InContext)
+	: Context(InContext)
+	, MaxAnisotropy(1.0f)
+	, NumHits(0)
+	, NumMisses(0)
+{
+	VkPhysicalDeviceProperties Properties{};
+	vkGetPhysicalDeviceProperties(Context->GetPhysicalDevice(), &Properties);
+
+	if (Context->GetEnabledFeatures().samplerAnisotropy)
+	{
+		MaxAnisotropy = Properties.limits.maxSamplerAnisotropy;
+	}
+}
+
+size_t FVulkanSamplerCache::FSamplerCIHasher::operator()(const VkSamplerCreateInfo& InSamplerCI) const
+{
+	size_t Hash = 0;
+
+	CombineHash(Hash, InSamplerCI.flags);
+	CombineHash(Hash, static_cast<uint32_t>(InSamplerCI.magFilter));
+	CombineHash(Hash, static_cast<uint32_t>(InSamplerCI.minFilter));
+	CombineHash(Hash, static_cast<uint32_t>(InSamplerCI.mipmapMode));
+	CombineHash(Hash, static_cast<uint32_t>(InSamplerCI.addressModeU));
+	CombineHash(Hash, static_cast<uint32_t>(InSamplerCI.addressModeV));
+	CombineHash(Hash, static_cast<uint32_t>(InSamplerCI.addressModeW));
+	CombineHash(Hash, InSamplerCI.mipLodBias);
+	CombineHash(Hash, InSamplerCI.anisotropyEnable);
+	CombineHash(Hash, InSamplerCI.maxAnisotropy);
+	CombineHash(Hash, InSamplerCI.compareEnable);
+	CombineHash(Hash, static_cast<uint32_t>(InSamplerCI.compareOp));
+	CombineHash(Hash, InSamplerCI.minLod);
+	CombineHash(Hash, InSamplerCI.maxLod);
+	CombineHash(Hash, static_cast<uint32_t>(InSamplerCI.borderColor));
+	CombineHash(Hash, InSamplerCI.unnormalizedCoordinates);
+
+	return Hash;
+}
+
+bool FVulkanSamplerCache::FSamplerCIEqual::operator()(const VkSamplerCreateInfo& A, const VkSamplerCreateInfo& B) const
+{
+	return A.flags == B.flags
+		&& A.magFilter == B.magFilter
+		&& A.minFilter == B.minFilter
+		&& A.mipmapMode == B.mipmapMode
+		&& A.addressModeU == B.addressModeU
+		&& A.addressModeV == B.addressModeV
+		&& A.addressModeW == B.addressModeW
+		&& A.mipLodBias == B.mipLodBias
+		&& A.anisotropyEnable == B.anisotropyEnable
+		&& A.maxAnisotropy == B.maxAnisotropy
+		&& A.compareEnable == B.compareEnable
+		&& A.compareOp == B.compareOp
+		&& A.minLod == B.minLod
+		&& A.maxLod == B.maxLod
+		&& A.borderColor == B.borderColor
+		&& A.unnormalizedCoordinates == B.unnormalizedCoordinates;
+}
+
+FVulkanSampler* FVulkanSamplerCache::GetSampler(const VkSamplerCreateInfo& InSamplerCI)
+{
+	// Extension structs would have to be part of the key as well.
+	assert(InSamplerCI.pNext == nullptr);
+
+	VkSamplerCreateInfo SamplerCI = InSamplerCI;
+	if (SamplerCI.anisotropyEnable)
+	{
+		SamplerCI.maxAnisotropy = std::min(SamplerCI.maxAnisotropy, MaxAnisotropy);
+		SamplerCI.anisotropyEnable = SamplerCI.maxAnisotropy > 1.0f ? VK_TRUE : VK_FALSE;
+	}
+
+	if (SamplerCI.anisotropyEnable == VK_FALSE)
+	{
+		SamplerCI.maxAnisotropy = 1.0f;
+	}
+
+	auto Iter = Samplers.find(SamplerCI);
+	if (Iter != Samplers.end())
+	{
+		++NumHits;
+		return Iter->second;
+	}
+
+	++NumMisses;
+
+	FVulkanSampler* Sampler = Context->CreateObject<FVulkanSampler>();
+	Sampler->Create(SamplerCI);
+
+	Samplers[SamplerCI] = Sampler;
+
+	return Sampler;
+}
+
+FSamplerCacheStats FVulkanSamplerCache::GetStats() const
+{
+	FSamplerCacheStats Stats;
+	Stats.NumSamplers = static_cast<uint32_t>(Samplers.size());
+	Stats.NumHits = NumHits;
+	Stats.NumMisses = NumMisses;
+
+	return Stats;
+}
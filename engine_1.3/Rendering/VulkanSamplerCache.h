@@ -0,0 +1,49 @@
+#pragma once
+
+#include "vulkan/vulkan.h"
+
+#include <cstdint>
+#include <unordered_map>
+
+struct FSamplerCacheStats
+{
+	uint32_t NumSamplers = 0;
+	uint64_t NumHits = 0;
+	uint64_t NumMisses = 0;
+};
+
+// Shares one FVulkanSampler between everything that asks for the same sampler state, keyed by the full
+// VkSamplerCreateInfo. Samplers are immutable and live as long as the context, so they can be baked into
+// descriptor set layouts as immutable samplers and the sets using them only need their image views written.
+class FVulkanSamplerCache
+{
+public:
+	FVulkanSamplerCache(class FVulkanContext* InContext);
+
+	// maxAnisotropy is clamped to what the device supports, so callers can simply ask for the most they want.
+	class FVulkanSampler* GetSampler(const VkSamplerCreateInfo& InSamplerCI);
+
+	FSamplerCacheStats GetStats() const;
+
+private:
+	struct FSamplerCIHasher
+	{
+		size_t operator()(const VkSamplerCreateInfo& InSamplerCI) const;
+	};
+
+	struct FSamplerCIEqual
+	{
+		bool operator()(const VkSamplerCreateInfo& A, const VkSamplerCreateInfo& B) const;
+	};
+
+private:
+	class FVulkanContext* Context;
+
+	float MaxAnisotropy;
+
+	// The context owns the samplers like any other object, so nothing here needs to destroy them.
+	std::unordered_map<VkSamplerCreateInfo, class FVulkanSampler*, FSamplerCIHasher, FSamplerCIEqual> Samplers;
+
+	uint64_t NumHits;
+	uint64_t NumMisses;
+};
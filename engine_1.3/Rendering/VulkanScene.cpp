@@ -2,6 +2,8 @@
 #include "VulkanContext.h"
 #include "VulkanModel.h"
 
+#include <algorithm>
+
 FVulkanScene::FVulkanScene(FVulkanContext* InContext)
 	: FVulkanObject(InContext)
 {
@@ -16,6 +18,9 @@ void FVulkanScene::AddModel(FVulkanModel* InModel)
 	}
 
 	Models.push_back(InModel);
+
+	InModel->SetScene(this);
+	MarkModelDirty(InModel);
 }
 
 void FVulkanScene::RemoveModel(FVulkanModel* InModel)
@@ -29,6 +34,11 @@ void FVulkanScene::RemoveModel(FVulkanModel* InModel)
 	{
 		if (*Itr == InModel)
 		{
+			if (InModel->IsDirty())
+			{
+				DirtyModels.erase(std::remove(DirtyModels.begin(), DirtyModels.end(), InModel), DirtyModels.end());
+			}
+
 			Context->DestroyObject(*Itr);
 			Models.erase(Itr);
 			break;
@@ -44,5 +54,27 @@ void FVulkanScene::ClearModels()
 	}
 
 	Models.clear();
+	DirtyModels.clear();
+}
+
+void FVulkanScene::MarkModelDirty(FVulkanModel* InModel)
+{
+	if (InModel == nullptr || InModel->IsDirty())
+	{
+		return;
+	}
+
+	InModel->SetDirty(true);
+	DirtyModels.push_back(InModel);
+}
+
+void FVulkanScene::ClearDirtyModels()
+{
+	for (FVulkanModel* Model : DirtyModels)
+	{
+		Model->SetDirty(false);
+	}
+
+	DirtyModels.clear();
 }
 
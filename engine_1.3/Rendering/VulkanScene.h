@@ -19,6 +19,11 @@ public:
 	void RemoveModel(class FVulkanModel* InModel);
 	void ClearModels();
 
+	// Models whose transform changed since the renderer last consumed the list.
+	const std::vector<class FVulkanModel*>& GetDirtyModels() const { return DirtyModels; }
+	void MarkModelDirty(class FVulkanModel* InModel);
+	void ClearDirtyModels();
+
 	FVulkanModel* GetSky() const { return Sky; }
 	void SetSky(FVulkanModel* InMesh) { Sky = InMesh; }
 
@@ -33,6 +38,7 @@ public:
 
 private:
 	std::vector<class FVulkanModel*> Models;
+	std::vector<class FVulkanModel*> DirtyModels;
 	FVulkanModel* Sky;
 
 	FVulkanCamera Camera;
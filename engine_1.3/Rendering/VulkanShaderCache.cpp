@@ -0,0 +1,102 @@
+#include "VulkanShaderCache.h"
+#include "VulkanContext.h"
+#include "VulkanShader.h"
+
+#include "Utils.h"
+
+#include <vector>
+#include <utility>
+#include <string_view>
+
+FVulkanShaderCache::FVulkanShaderCache(FVulkanContext* InContext)
+	: Context(InContext)
+	, NumHits(0)
+	, NumMisses(0)
+{
+}
+
+FVulkanShader* FVulkanShaderCache::Acquire(const std::string& InFilename)
+{
+	std::vector<char> Bytes;
+	if (ReadFile(InFilename, Bytes) == false)
+	{
+		return nullptr;
+	}
+
+	const size_t Hash = std::hash<std::string_view>()(std::string_view(Bytes.data(), Bytes.size()));
+
+	auto Range = ShadersByHash.equal_range(Hash);
+	for (auto Iter = Range.first; Iter != Range.second; ++Iter)
+	{
+		FEntry& Entry = Entries.at(Iter->second);
+		if (Entry.Code == Bytes)
+		{
+			++NumHits;
+			++Entry.RefCount;
+			return Iter->second;
+		}
+	}
+
+	++NumMisses;
+
+	FVulkanShader* Shader = Context->CreateObject<FVulkanShader>();
+	if (Shader->LoadBytes(Bytes) == false)
+	{
+		Context->DestroyObject(Shader);
+		return nullptr;
+	}
+
+	ShadersByHash.emplace(Hash, Shader);
+	Entries[Shader] = { std::move(Bytes), Hash, 1 };
+
+	return Shader;
+}
+
+void FVulkanShaderCache::AddRef(FVulkanShader* InShader)
+{
+	auto Iter = Entries.find(InShader);
+	if (Iter == Entries.end())
+	{
+		return;
+	}
+
+	++Iter->second.RefCount;
+}
+
+void FVulkanShaderCache::Release(FVulkanShader* InShader)
+{
+	auto Iter = Entries.find(InShader);
+	if (Iter == Entries.end())
+	{
+		return;
+	}
+
+	if (--Iter->second.RefCount > 0)
+	{
+		return;
+	}
+
+	auto Range = ShadersByHash.equal_range(Iter->second.Hash);
+	for (auto HashIter = Range.first; HashIter != Range.second; ++HashIter)
+	{
+		if (HashIter->second == InShader)
+		{
+			ShadersByHash.erase(HashIter);
+			break;
+		}
+	}
+
+	Entries.erase(Iter);
+
+	Context->RetireObject(InShader);
+}
+
+FShaderCacheStats FVulkanShaderCache::GetStats() const
+{
+	FShaderCacheStats Stats;
+	Stats.NumModules = static_cast<uint32_t>(Entries.size());
+	Stats.NumHits = NumHits;
+	Stats.NumMisses = NumMisses;
+
+	return Stats;
+}
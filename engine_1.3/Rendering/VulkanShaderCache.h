@@ -0,0 +1,51 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+
+struct FShaderCacheStats
+{
+	uint32_t NumModules = 0;
+	uint64_t NumHits = 0;
+	uint64_t NumMisses = 0;
+};
+
+// Shares one FVulkanShader between everything that loads the same SPIR-V, found by a hash of the code and
+// confirmed by comparing the bytes, so materials pointing at the same files create their modules once and
+// pipelines can compare shaders by pointer.
+// Shaders are reference counted; the last release retires the shader, so it is only destroyed once the frames
+// submitted before it have finished.
+class FVulkanShaderCache
+{
+public:
+	FVulkanShaderCache(class FVulkanContext* InContext);
+
+	// Returns nullptr if the file cannot be read or is not valid SPIR-V. Every acquire needs a matching Release.
+	class FVulkanShader* Acquire(const std::string& InFilename);
+
+	void AddRef(class FVulkanShader* InShader);
+	void Release(class FVulkanShader* InShader);
+
+	FShaderCacheStats GetStats() const;
+
+private:
+	struct FEntry
+	{
+		std::vector<char> Code;
+		size_t Hash = 0;
+		uint32_t RefCount = 0;
+	};
+
+private:
+	class FVulkanContext* Context;
+
+	// Keyed by pointer, which releases never dereference, since at context teardown the shader may already be gone.
+	std::unordered_map<class FVulkanShader*, FEntry> Entries;
+
+	std::unordered_multimap<size_t, class FVulkanShader*> ShadersByHash;
+
+	uint64_t NumHits;
+	uint64_t NumMisses;
+};
@@ -1,20 +1,25 @@
 #include "VulkanSkyRenderer.h"
 #include "VulkanContext.h"
 #include "VulkanHelpers.h"
+#include "VulkanDescriptorAllocator.h"
 #include "VulkanTexture.h"
 #include "VulkanScene.h"
 #include "VulkanSwapchain.h"
 #include "VulkanRenderPass.h"
 #include "VulkanFramebuffer.h"
 #include "VulkanPipeline.h"
+#include "VulkanPipelineLibrary.h"
 #include "VulkanViewport.h"
 #include "VulkanSampler.h"
+#include "VulkanSamplerCache.h"
 #include "VulkanBuffer.h"
 #include "VulkanMesh.h"
 #include "VulkanShader.h"
+#include "VulkanShaderCache.h"
 #include "VulkanModel.h"
 
 #include "Utils.h"
+#include "CpuProfiler.h"
 #include "Engine.h"
 #include "Config.h"
 #include "Mesh.h"
@@ -28,6 +33,7 @@
 #include <array>
 #include <algorithm>
 #include <execution>
+#include <cstddef>
 
 struct FUniformBufferObject
 {
@@ -35,9 +41,16 @@ struct FUniformBufferObject
 	alignas(16) glm::mat4 Projection;
 };
 
+struct FSkyDescriptorData
+{
+	VkDescriptorBufferInfo UniformBuffer;
+	VkDescriptorImageInfo Cubemap;
+};
+
 FVulkanSkyRenderer::FVulkanSkyRenderer(FVulkanContext* InContext)
 	: FVulkanRenderer(InContext)
 	, DescriptorSetLayout(VK_NULL_HANDLE)
+	, DescriptorUpdateTemplate(VK_NULL_HANDLE)
 	, Sampler(nullptr)
 	, bInitialized(false)
 {
@@ -73,12 +86,6 @@ void FVulkanSkyRenderer::Destroy()
 	}
 	Framebuffers.clear();
 
-	if (Pipeline != nullptr)
-	{
-		Context->DestroyObject(Pipeline);
-		Pipeline = nullptr;
-	}
-
 	for (FVulkanBuffer* UniformBuffer : UniformBuffers)
 	{
 		if (UniformBuffer == nullptr)
@@ -90,12 +97,14 @@ void FVulkanSkyRenderer::Destroy()
 	}
 	UniformBuffers.clear();
 
-	if (Sampler != nullptr)
+	FVulkanDescriptorAllocator* DescriptorAllocator = Context->GetDescriptorAllocator();
+	for (VkDescriptorSet DescriptorSet : DescriptorSets)
 	{
-		Context->DestroyObject(Sampler);
-		Sampler = nullptr;
+		DescriptorAllocator->Free(DescriptorSet);
 	}
+	DescriptorSets.clear();
 
+	vkDestroyDescriptorUpdateTemplate(Device, DescriptorUpdateTemplate, nullptr);
 	vkDestroyDescriptorSetLayout(Device, DescriptorSetLayout, nullptr);
 
 	bInitialized = false;
@@ -134,96 +143,42 @@ void FVulkanSkyRenderer::CreateFramebuffers()
 
 void FVulkanSkyRenderer::CreateGraphicsPipelines()
 {
-	VkDevice Device = Context->GetDevice();
-
 	std::string ShaderDirectory;
 	GConfig->Get("ShaderDirectory", ShaderDirectory);
 
-	FVulkanShader* VS = Context->CreateObject<FVulkanShader>();
-	VS->LoadFile(ShaderDirectory + "sky.vert.spv");
-	FVulkanShader* FS = Context->CreateObject<FVulkanShader>();
-	FS->LoadFile(ShaderDirectory + "sky.frag.spv");
-
-	Pipeline = Context->CreateObject<FVulkanPipeline>();
-	Pipeline->SetVertexShader(VS);
-	Pipeline->SetFragmentShader(FS);
-
-	VkPipelineShaderStageCreateInfo VertexShaderStageCI{};
-	VertexShaderStageCI.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-	VertexShaderStageCI.stage = VK_SHADER_STAGE_VERTEX_BIT;
-	VertexShaderStageCI.module = Pipeline->GetVertexShader()->GetModule();
-	VertexShaderStageCI.pName = "main";
-
-	VkPipelineShaderStageCreateInfo FragmentShaderStageCI{};
-	FragmentShaderStageCI.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-	FragmentShaderStageCI.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-	FragmentShaderStageCI.module = Pipeline->GetFragmentShader()->GetModule();
-	FragmentShaderStageCI.pName = "main";
-
-	std::array<VkPipelineShaderStageCreateInfo, 2> ShaderStageCIs = { VertexShaderStageCI, FragmentShaderStageCI };
-
-	std::vector<VkVertexInputBindingDescription> VertexInputBindingDescs;
-	std::vector<VkVertexInputAttributeDescription> VertexInputAttributeDescs;
-	GetVertexInputBindings(VertexInputBindingDescs);
-	GetVertexInputAttributes(VertexInputAttributeDescs);
-
-	VkPipelineVertexInputStateCreateInfo VertexInputStateCI = Vk::GetVertexInputStateCI(VertexInputBindingDescs, VertexInputAttributeDescs);
-	VkPipelineInputAssemblyStateCreateInfo InputAssemblyStateCI = Vk::GetInputAssemblyStateCI();
-	VkPipelineViewportStateCreateInfo ViewportStateCI = Vk::GetViewportStateCI();
-	VkPipelineRasterizationStateCreateInfo RasterizerCI = Vk::GetRasterizationStateCI();
-	RasterizerCI.cullMode = VK_CULL_MODE_NONE;
-	VkPipelineMultisampleStateCreateInfo MultisampleStateCI = Vk::GetMultisampleStateCI();
-	VkPipelineDepthStencilStateCreateInfo DepthStencilStateCI = Vk::GetDepthStencilStateCI();
-	DepthStencilStateCI.depthTestEnable = VK_FALSE;
-	DepthStencilStateCI.depthWriteEnable = VK_FALSE;
-
-	VkPipelineColorBlendAttachmentState ColorBlendAttachmentState = Vk::GetColorBlendAttachment();
-	VkPipelineColorBlendStateCreateInfo ColorBlendStateCI = Vk::GetColorBlendStateCI();
-	ColorBlendStateCI.pAttachments = &ColorBlendAttachmentState;
-
-	std::vector<VkDynamicState> DynamicStates = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
-
-	VkPipelineDynamicStateCreateInfo DynamicStateCI{};
-	DynamicStateCI.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
-	DynamicStateCI.dynamicStateCount = static_cast<uint32_t>(DynamicStates.size());
-	DynamicStateCI.pDynamicStates = DynamicStates.data();
-
-	VkPipelineLayoutCreateInfo PipelineLayoutCI{};
-	PipelineLayoutCI.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-	PipelineLayoutCI.setLayoutCount = 1;
-	PipelineLayoutCI.pSetLayouts = &DescriptorSetLayout;
-
-	Pipeline->CreateLayout(PipelineLayoutCI);
-
-	VkGraphicsPipelineCreateInfo PipelineCI{};
-	PipelineCI.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-	PipelineCI.stageCount = static_cast<uint32_t>(ShaderStageCIs.size());
-	PipelineCI.pStages = ShaderStageCIs.data();
-	PipelineCI.pVertexInputState = &VertexInputStateCI;
-	PipelineCI.pInputAssemblyState = &InputAssemblyStateCI;
-	PipelineCI.pViewportState = &ViewportStateCI;
-	PipelineCI.pRasterizationState = &RasterizerCI;
-	PipelineCI.pDepthStencilState = &DepthStencilStateCI;
-	PipelineCI.pMultisampleState = &MultisampleStateCI;
-	PipelineCI.pColorBlendState = &ColorBlendStateCI;
-	PipelineCI.pDynamicState = &DynamicStateCI;
-	PipelineCI.layout = Pipeline->GetLayout();
-	PipelineCI.renderPass = RenderPass->GetHandle();
-	PipelineCI.subpass = 0;
-	PipelineCI.basePipelineHandle = VK_NULL_HANDLE;
-
-	Pipeline->CreatePipeline(PipelineCI);
+	FVulkanShaderCache* ShaderCache = Context->GetShaderCache();
+	FVulkanShader* VS = ShaderCache->Acquire(ShaderDirectory + "sky.vert.spv");
+	FVulkanShader* FS = ShaderCache->Acquire(ShaderDirectory + "sky.frag.spv");
+
+	FGraphicsPipelineDesc Desc;
+	Desc.VS = VS;
+	Desc.FS = FS;
+	GetVertexInputBindings(Desc.VertexBindings);
+	GetVertexInputAttributes(Desc.VertexAttributes);
+	Desc.SetLayouts = { DescriptorSetLayout };
+	Desc.RenderPass = RenderPass->GetHandle();
+	Desc.CullMode = VK_CULL_MODE_NONE;
+	Desc.bDepthTest = false;
+	Desc.bDepthWrite = false;
+
+	Pipeline = Context->GetPipelineLibrary()->GetGraphicsPipeline(Desc);
+
+	// The library holds its own references for as long as it keeps the pipeline.
+	ShaderCache->Release(VS);
+	ShaderCache->Release(FS);
 }
 
 void FVulkanSkyRenderer::CreateTextureSampler()
 {
-	Sampler = Context->CreateObject<FVulkanSampler>();
+	Sampler = Context->GetSamplerCache()->GetSampler(Vk::GetSamplerCI());
 }
 
 void FVulkanSkyRenderer::CreateDescriptorSetLayout()
 {
 	VkDevice Device = Context->GetDevice();
 
+	const VkSampler ImmutableSampler = Sampler->GetSampler();
+
 	VkDescriptorSetLayoutBinding UBOBinding{};
 	UBOBinding.binding = 0;
 	UBOBinding.descriptorCount = 1;
@@ -235,7 +190,7 @@ void FVulkanSkyRenderer::CreateDescriptorSetLayout()
 	CubemapSamplerBinding.binding = 1;
 	CubemapSamplerBinding.descriptorCount = 1;
 	CubemapSamplerBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	CubemapSamplerBinding.pImmutableSamplers = nullptr;
+	CubemapSamplerBinding.pImmutableSamplers = &ImmutableSampler;
 	CubemapSamplerBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
 
 	std::vector<VkDescriptorSetLayoutBinding> Bindings =
@@ -250,24 +205,26 @@ void FVulkanSkyRenderer::CreateDescriptorSetLayout()
 	DescriptorSetLayoutCI.pBindings = Bindings.data();
 
 	VK_ASSERT(vkCreateDescriptorSetLayout(Device, &DescriptorSetLayoutCI, nullptr, &DescriptorSetLayout));
+
+	std::vector<VkDescriptorUpdateTemplateEntry> UpdateTemplateEntries =
+	{
+		Vk::GetDescriptorUpdateTemplateEntry(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, offsetof(FSkyDescriptorData, UniformBuffer)),
+		Vk::GetDescriptorUpdateTemplateEntry(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, offsetof(FSkyDescriptorData, Cubemap))
+	};
+	DescriptorUpdateTemplate = Vk::CreateDescriptorUpdateTemplate(Device, DescriptorSetLayout, UpdateTemplateEntries);
 }
 
 void FVulkanSkyRenderer::CreateDescriptorSets()
 {
-	VkDevice Device = Context->GetDevice();
-	VkDescriptorPool DescriptorPool = Context->GetDescriptorPool();
+	FVulkanDescriptorAllocator* DescriptorAllocator = Context->GetDescriptorAllocator();
 
 	const uint32_t MaxConcurrentFrames = Context->GetMaxConcurrentFrames();
 
-	std::vector<VkDescriptorSetLayout> Layouts(MaxConcurrentFrames, DescriptorSetLayout);
-	VkDescriptorSetAllocateInfo DescriptorSetAllocInfo{};
-	DescriptorSetAllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-	DescriptorSetAllocInfo.descriptorPool = DescriptorPool;
-	DescriptorSetAllocInfo.descriptorSetCount = static_cast<uint32_t>(MaxConcurrentFrames);
-	DescriptorSetAllocInfo.pSetLayouts = Layouts.data();
-
 	DescriptorSets.resize(MaxConcurrentFrames);
-	VK_ASSERT(vkAllocateDescriptorSets(Device, &DescriptorSetAllocInfo, DescriptorSets.data()));
+	for (uint32_t Idx = 0; Idx < MaxConcurrentFrames; ++Idx)
+	{
+		DescriptorSets[Idx] = DescriptorAllocator->Allocate(DescriptorSetLayout);
+	}
 
 	UpdateDescriptorSets();
 }
@@ -356,35 +313,12 @@ void FVulkanSkyRenderer::UpdateDescriptorSets()
 
 	for (int32_t Idx = 0; Idx < DescriptorSets.size(); ++Idx)
 	{
-		std::array<VkWriteDescriptorSet, 2> DescriptorWrites{};
-
-		VkDescriptorBufferInfo UniformBufferInfo{};
-		UniformBufferInfo.buffer = UniformBuffers[Idx]->GetHandle();
-		UniformBufferInfo.offset = 0;
-		UniformBufferInfo.range = sizeof(FUniformBufferObject);
-
-		DescriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		DescriptorWrites[0].dstSet = DescriptorSets[Idx];
-		DescriptorWrites[0].dstBinding = 0;
-		DescriptorWrites[0].dstArrayElement = 0;
-		DescriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		DescriptorWrites[0].descriptorCount = 1;
-		DescriptorWrites[0].pBufferInfo = &UniformBufferInfo;
-
-		VkDescriptorImageInfo CubemapImageInfo{};
-		CubemapImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-		CubemapImageInfo.imageView = Texture->GetImage()->GetView();
-		CubemapImageInfo.sampler = Sampler->GetSampler();
-
-		DescriptorWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		DescriptorWrites[1].dstSet = DescriptorSets[Idx];
-		DescriptorWrites[1].dstBinding = 1;
-		DescriptorWrites[1].dstArrayElement = 0;
-		DescriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-		DescriptorWrites[1].descriptorCount = 1;
-		DescriptorWrites[1].pImageInfo = &CubemapImageInfo;
-
-		vkUpdateDescriptorSets(Device, static_cast<uint32_t>(DescriptorWrites.size()), DescriptorWrites.data(), 0, nullptr);
+		FSkyDescriptorData DescriptorData{};
+		DescriptorData.UniformBuffer = { UniformBuffers[Idx]->GetHandle(), 0, sizeof(FUniformBufferObject) };
+		// The sampler is immutable in the set layout.
+		DescriptorData.Cubemap = { VK_NULL_HANDLE, Texture->GetImage()->GetView(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+
+		vkUpdateDescriptorSetWithTemplate(Device, DescriptorSets[Idx], DescriptorUpdateTemplate, &DescriptorData);
 	}
 }
 
@@ -449,6 +383,8 @@ FVulkanMesh* FVulkanSkyRenderer::GetSkyMesh() const
 
 void FVulkanSkyRenderer::Render()
 {	
+	CPU_PROFILE_SCOPE("FVulkanSkyRenderer::Render");
+
 	if (bInitialized == false)
 	{
 		CreateUniformBuffers();
@@ -516,19 +452,25 @@ void FVulkanSkyRenderer::Render()
 
 	vkCmdBindIndexBuffer(CommandBuffer, SkyMesh->GetIndexBuffer()->GetHandle(), 0, VK_INDEX_TYPE_UINT32);
 
-	vkCmdDrawIndexed(CommandBuffer, static_cast<uint32_t>(SkyMesh->GetMeshAsset()->GetIndices().size()), 1, 0, 0, 0);
+	vkCmdDrawIndexed(CommandBuffer, SkyMesh->GetIndexCount(), 1, SkyMesh->GetFirstIndex(), SkyMesh->GetVertexOffset(), 0);
 
 	RenderPass->End(CommandBuffer);
 }
 
+void FVulkanSkyRenderer::LatchView()
+{
+	// The whole uniform buffer is view-dependent, so it is simply rebuilt from the latched camera.
+	if (bInitialized)
+	{
+		UpdateUniformBuffer();
+	}
+}
+
 void FVulkanSkyRenderer::OnRecreateSwapchain()
 {
 	for (FVulkanFramebuffer* Framebuffer : Framebuffers)
 	{
-		if (Context->IsValidObject(Framebuffer))
-		{
-			Context->DestroyObject(Framebuffer);
-		}
+		Context->RetireObject(Framebuffer);
 	}
 	Framebuffers.clear();
 
@@ -19,8 +19,10 @@ public:
 
 	virtual void Destroy() override;
 
+	virtual const char* GetName() const override { return "Sky"; }
 	virtual void Render() override;
 	virtual void OnRecreateSwapchain() override;
+	virtual void LatchView() override;
 
 protected:
 	void CreateRenderPass();
@@ -43,13 +45,16 @@ protected:
 	class FVulkanRenderPass* RenderPass;
 	std::vector<class FVulkanFramebuffer*> Framebuffers;
 
+	// Owned by the context's pipeline library.
 	class FVulkanPipeline* Pipeline;
 
 	VkDescriptorSetLayout DescriptorSetLayout;
+	VkDescriptorUpdateTemplate DescriptorUpdateTemplate;
 	std::vector<VkDescriptorSet> DescriptorSets;
 
 	std::vector<class FVulkanBuffer*> UniformBuffers;
 
+	// Owned by the context's sampler cache and baked into the set layouts as an immutable sampler.
 	class FVulkanSampler* Sampler;
 
 	bool bInitialized;
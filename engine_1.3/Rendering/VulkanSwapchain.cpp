@@ -1,14 +1,17 @@
 #include "VulkanSwapchain.h"
 #include "VulkanContext.h"
 #include "VulkanHelpers.h"
+#include "VulkanImage.h"
 
 FVulkanSwapchain::FVulkanSwapchain(FVulkanContext* InContext)
 	: FVulkanObject(InContext)
 	, Swapchain(VK_NULL_HANDLE)
 	, Format(VK_FORMAT_UNDEFINED)
 	, Extent({})
+	, ImageUsage(0)
 	, ImageCount(0)
 	, CurrentImageIndex(0)
+	, bOffscreen(false)
 {
 }
 
@@ -19,6 +22,7 @@ FVulkanSwapchain* FVulkanSwapchain::Create(
 	FVulkanSwapchain* Swapchain = InContext->CreateObject<FVulkanSwapchain>();
 	Swapchain->Format = InSwapchainCI.imageFormat;
 	Swapchain->Extent = InSwapchainCI.imageExtent;
+	Swapchain->ImageUsage = InSwapchainCI.imageUsage;
 
 	VkDevice Device = InContext->GetDevice();
 	VK_ASSERT(vkCreateSwapchainKHR(Device, &InSwapchainCI, nullptr, &Swapchain->Swapchain));
@@ -52,8 +56,63 @@ FVulkanSwapchain* FVulkanSwapchain::Create(
 	return Swapchain;
 }
 
+FVulkanSwapchain* FVulkanSwapchain::CreateOffscreen(
+	FVulkanContext* InContext,
+	VkFormat InFormat,
+	VkExtent2D InExtent,
+	uint32_t InImageCount)
+{
+	FVulkanSwapchain* Swapchain = InContext->CreateObject<FVulkanSwapchain>();
+	Swapchain->Format = InFormat;
+	Swapchain->Extent = InExtent;
+	Swapchain->ImageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+	Swapchain->ImageCount = InImageCount;
+	Swapchain->bOffscreen = true;
+
+	// Start on the last image so the first acquire hands out image 0.
+	Swapchain->CurrentImageIndex = InImageCount - 1;
+
+	Swapchain->Images.resize(InImageCount);
+	Swapchain->ImageViews.resize(InImageCount);
+	Swapchain->OffscreenImages.resize(InImageCount);
+
+	for (uint32_t Idx = 0; Idx < InImageCount; ++Idx)
+	{
+		FVulkanImage* Image = InContext->CreateObject<FVulkanImage>();
+		Image->CreateImage(
+			{ InExtent.width, InExtent.height, 1 },
+			1,
+			1,
+			InFormat,
+			VK_IMAGE_TYPE_2D,
+			VK_IMAGE_TILING_OPTIMAL,
+			Swapchain->ImageUsage,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		Image->CreateView(VK_IMAGE_VIEW_TYPE_2D, VK_IMAGE_ASPECT_COLOR_BIT);
+
+		Swapchain->OffscreenImages[Idx] = Image;
+		Swapchain->Images[Idx] = Image->GetImage();
+		Swapchain->ImageViews[Idx] = Image->GetView();
+	}
+
+	return Swapchain;
+}
+
 void FVulkanSwapchain::Destroy()
 {	
+	if (bOffscreen)
+	{
+		// The views belong to the offscreen images.
+		for (FVulkanImage* Image : OffscreenImages)
+		{
+			Context->DestroyObject(Image);
+		}
+		OffscreenImages.clear();
+		ImageViews.clear();
+		Images.clear();
+		return;
+	}
+
 	VkDevice Device = Context->GetDevice();
 	if (Swapchain != VK_NULL_HANDLE)
 	{
@@ -72,6 +131,11 @@ void FVulkanSwapchain::Destroy()
 
 VkResult FVulkanSwapchain::Present(VkQueue InGfxQueue, VkQueue InPresentQueue, VkSemaphore InRenderFinishedSemaphore)
 {
+	if (bOffscreen)
+	{
+		return VK_SUCCESS;
+	}
+
 	VkSemaphore SignalSemaphores[] = { InRenderFinishedSemaphore };
 
 	VkSwapchainKHR Swapchains[] = { Swapchain };
@@ -84,13 +148,19 @@ VkResult FVulkanSwapchain::Present(VkQueue InGfxQueue, VkQueue InPresentQueue, V
 	PresentInfo.pSwapchains = Swapchains;
 	PresentInfo.pImageIndices = &CurrentImageIndex;
 
-	VkResult PresentResult = vkQueuePresentKHR(InPresentQueue, &PresentInfo);
-
-	return VK_SUCCESS;
+	return vkQueuePresentKHR(InPresentQueue, &PresentInfo);
 }
 
 VkResult FVulkanSwapchain::AcquireNextImage(VkSemaphore InImageAcquiredSemaphore)
 {
+	if (bOffscreen)
+	{
+		// Images are handed out round-robin. The context keeps at least as many images as frames in flight,
+		// so the frame timeline wait in BeginRender already guarantees the GPU is done with this one.
+		CurrentImageIndex = (CurrentImageIndex + 1) % ImageCount;
+		return VK_SUCCESS;
+	}
+
 	VkDevice Device = Context->GetDevice();
 
 	VkResult AcquireResult = vkAcquireNextImageKHR(
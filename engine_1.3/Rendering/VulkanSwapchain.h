@@ -16,11 +16,19 @@ public:
 		class FVulkanContext* InContext,
 		const VkSwapchainCreateInfoKHR& InSwapchainCI);
 
+	// Creates a virtual swapchain backed by plain color images, used when there is no window to present to.
+	static FVulkanSwapchain* CreateOffscreen(
+		class FVulkanContext* InContext,
+		VkFormat InFormat,
+		VkExtent2D InExtent,
+		uint32_t InImageCount);
+
 	virtual void Destroy() override;
 
 	VkSwapchainKHR GetHandle() const { return Swapchain; }
 	VkFormat GetFormat() const { return Format; }
 	VkExtent2D GetExtent() const { return Extent; }
+	VkImageUsageFlags GetImageUsage() const { return ImageUsage; }
 
 	uint32_t GetImageCount() const { return ImageCount; }
 	const std::vector<VkImage>& GetImages() const { return Images; }
@@ -28,6 +36,10 @@ public:
 
 	uint32_t GetCurrentImageIndex() const { return CurrentImageIndex; }
 
+	bool IsOffscreen() const { return bOffscreen; }
+	class FVulkanImage* GetOffscreenImage(uint32_t InIndex) const { return OffscreenImages[InIndex]; }
+	VkImageLayout GetFinalLayout() const { return bOffscreen ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR; }
+
 	VkResult Present(VkQueue InGfxQueue, VkQueue InPresentQueue, VkSemaphore InRenderFinishedSemaphore);
 	VkResult AcquireNextImage(VkSemaphore InImageAcquiredSemaphore);
 
@@ -35,10 +47,14 @@ private:
 	VkSwapchainKHR Swapchain;
 	VkFormat Format;
 	VkExtent2D Extent;
+	VkImageUsageFlags ImageUsage;
 
 	uint32_t ImageCount;
 	std::vector<VkImage> Images;
 	std::vector<VkImageView> ImageViews;
 
 	uint32_t CurrentImageIndex;
+
+	bool bOffscreen;
+	std::vector<class FVulkanImage*> OffscreenImages;
 };
@@ -7,8 +7,10 @@
 #include "VulkanSwapchain.h"
 #include "VulkanViewport.h"
 #include "VulkanFramebuffer.h"
+#include "VulkanPipelineCache.h"
 
 #include "Utils.h"
+#include "CpuProfiler.h"
 #include "Config.h"
 #include "Widget.h"
 
@@ -21,6 +23,7 @@
 #include <stdexcept>
 #include <cstring>
 #include <array>
+#include <algorithm>
 #include <vector>
 #include <string>
 
@@ -49,7 +52,10 @@ FVulkanUIRenderer::FVulkanUIRenderer(FVulkanContext* InContext)
 	IO.FontGlobalScale = 1.0f;
 	Style.ScaleAllSizes(1.0f);
 
-	ImGui_ImplGlfw_InitForVulkan(Context->GetWindow(), true);
+	if (Context->IsHeadless() == false)
+	{
+		ImGui_ImplGlfw_InitForVulkan(Context->GetWindow(), true);
+	}
 
 	RenderPass = FVulkanRenderPass::CreateUIPass(Context);
 
@@ -58,15 +64,24 @@ FVulkanUIRenderer::FVulkanUIRenderer(FVulkanContext* InContext)
 	VkCommandPool CommandPool = Context->GetCommandPool();
 	VkDescriptorPool DescriptorPool = Context->GetDescriptorPool();
 
+	FVulkanViewport* Viewport = Context->GetViewport();
+	assert(Viewport != nullptr);
+
+	// Same counts the swapchain was created with. ImageCount only sizes ImGui's ring of vertex buffers, which
+	// advances once per frame and cannot be resized after init, so it must also cover every frame in flight.
+	const uint32_t MinImageCount = std::max(Viewport->GetMinImageCount(), 2U);
+	const uint32_t ImageCount = std::max({ MinImageCount, Viewport->GetSwapchain()->GetImageCount(), Context->GetMaxConcurrentFrames() });
+
 	//this initializes imgui for Vulkan
 	ImGui_ImplVulkan_InitInfo init_info = {};
 	init_info.Instance = Context->GetInstance();
 	init_info.PhysicalDevice = Context->GetPhysicalDevice();
 	init_info.Device = Context->GetDevice();
 	init_info.Queue = Context->GetGfxQueue();
+	init_info.PipelineCache = Context->GetPipelineCache()->GetCache();
 	init_info.DescriptorPool = DescriptorPool;
-	init_info.MinImageCount = 3;
-	init_info.ImageCount = 3;
+	init_info.MinImageCount = MinImageCount;
+	init_info.ImageCount = ImageCount;
 	init_info.MSAASamples = VK_SAMPLE_COUNT_1_BIT;
 	init_info.RenderPass = RenderPass->GetHandle();
 
@@ -81,7 +96,10 @@ FVulkanUIRenderer::FVulkanUIRenderer(FVulkanContext* InContext)
 void FVulkanUIRenderer::Destroy()
 {
 	ImGui_ImplVulkan_Shutdown();
-	ImGui_ImplGlfw_Shutdown();
+	if (Context->IsHeadless() == false)
+	{
+		ImGui_ImplGlfw_Shutdown();
+	}
 
 	ImGui::DestroyContext();
 
@@ -130,6 +148,8 @@ void FVulkanUIRenderer::CreateFramebuffers()
 
 void FVulkanUIRenderer::Render()
 {
+	CPU_PROFILE_SCOPE("FVulkanUIRenderer::Render");
+
 	uint32_t CurrentFrame = Context->GetCurrentFrame();
 	VkCommandBuffer CommandBuffer = Context->GetCommandBuffer();
 
@@ -154,7 +174,10 @@ void FVulkanUIRenderer::Render()
 
 	ImGuiIO& IO = ImGui::GetIO();
 
-	ImGui_ImplGlfw_NewFrame();
+	if (Context->IsHeadless() == false)
+	{
+		ImGui_ImplGlfw_NewFrame();
+	}
 	ImGui_ImplVulkan_NewFrame();
 
 	ImGui::NewFrame();
@@ -175,13 +198,12 @@ void FVulkanUIRenderer::OnRecreateSwapchain()
 {
 	for (FVulkanFramebuffer* Framebuffer : Framebuffers)
 	{
-		if (Context->IsValidObject(Framebuffer))
-		{
-			Context->DestroyObject(Framebuffer);
-		}
+		Context->RetireObject(Framebuffer);
 	}
 	Framebuffers.clear();
 
+	// ImGui_ImplVulkan_SetMinImageCount is not called on a profile switch: it waits for the device to go idle,
+	// and the count only matters to ImGui's own platform windows, which are not used here.
 	CreateFramebuffers();
 }
 
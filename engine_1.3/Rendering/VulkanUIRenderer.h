@@ -8,8 +8,6 @@
 #include <memory>
 #include <vector>
 
-#define MAX_CONCURRENT_FRAME 2
-
 class FVulkanUIRenderer : public FVulkanRenderer
 {
 public:
@@ -18,6 +16,7 @@ public:
 
 	void CreateFramebuffers();
 
+	virtual const char* GetName() const override { return "UI"; }
 	virtual void Render() override;
 	virtual void OnRecreateSwapchain() override;
 
@@ -5,13 +5,71 @@
 #include "VulkanFramebuffer.h"
 #include "VulkanSwapchain.h"
 
+#include "Config.h"
+
 #include <algorithm>
+#include <stdexcept>
+
+static const char* PresentProfileNames[] = { "latency", "smooth", "throughput" };
+
+static std::vector<VkPresentModeKHR> GetPreferredPresentModes(EPresentProfile InPresentProfile)
+{
+	switch (InPresentProfile)
+	{
+	case EPresentProfile::LowLatency:
+		return { VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_FIFO_KHR };
+	case EPresentProfile::Throughput:
+		return { VK_PRESENT_MODE_FIFO_RELAXED_KHR, VK_PRESENT_MODE_FIFO_KHR };
+	default:
+		return { VK_PRESENT_MODE_FIFO_KHR };
+	}
+}
+
+static uint32_t GetPreferredImageCount(EPresentProfile InPresentProfile, VkPresentModeKHR InPresentMode, const VkSurfaceCapabilitiesKHR& InCapabilities)
+{
+	uint32_t ImageCount = InCapabilities.minImageCount;
+	switch (InPresentProfile)
+	{
+	case EPresentProfile::LowLatency:
+		// Mailbox needs a spare image to replace, otherwise it degrades into FIFO.
+		if (InPresentMode == VK_PRESENT_MODE_MAILBOX_KHR)
+		{
+			ImageCount = std::max(ImageCount, 3U);
+		}
+		break;
+	case EPresentProfile::Throughput:
+		ImageCount += 2;
+		break;
+	default:
+		ImageCount += 1;
+		break;
+	}
+
+	// A maxImageCount of zero means the surface puts no upper limit on the count.
+	if (InCapabilities.maxImageCount > 0)
+	{
+		ImageCount = std::min(ImageCount, InCapabilities.maxImageCount);
+	}
+
+	return ImageCount;
+}
 
 FVulkanViewport::FVulkanViewport(FVulkanContext* InContext)
 	: FVulkanObject(InContext)
 	, Swapchain(nullptr)
 	, DepthImage(nullptr)
+	, PresentProfile(EPresentProfile::Smooth)
+	, ActivePresentProfile(EPresentProfile::Smooth)
+	, PresentMode(VK_PRESENT_MODE_FIFO_KHR)
+	, MinImageCount(0)
 {
+	std::string PresentProfileName;
+	GConfig->Get("PresentProfile", PresentProfileName);
+	if (PresentProfileName.empty() == false && ParsePresentProfile(PresentProfileName, PresentProfile) == false)
+	{
+		throw std::runtime_error("Unknown present profile " + PresentProfileName);
+	}
+	ActivePresentProfile = PresentProfile;
 }
 
 FVulkanViewport::~FVulkanViewport()
@@ -21,7 +79,14 @@ FVulkanViewport::~FVulkanViewport()
 FVulkanViewport* FVulkanViewport::Create(FVulkanContext* InContext, GLFWwindow* InWindow)
 {
 	FVulkanViewport* Viewport = InContext->CreateObject<FVulkanViewport>();
-	Viewport->CreateSwapchain(InWindow);
+	if (InWindow != nullptr)
+	{
+		Viewport->CreateSwapchain(InWindow);
+	}
+	else
+	{
+		Viewport->CreateOffscreenSwapchain();
+	}
 	Viewport->CreateDepthImage();
 
 	return Viewport;
@@ -32,7 +97,7 @@ void FVulkanViewport::Destroy()
 	Cleanup();
 }
 
-void FVulkanViewport::CreateSwapchain(GLFWwindow* InWindow)
+void FVulkanViewport::CreateSwapchain(GLFWwindow* InWindow, FVulkanSwapchain* InOldSwapchain)
 {	
 	VkPhysicalDevice PhysicalDevice = Context->GetPhysicalDevice();
 	VkSurfaceKHR Surface = Context->GetSurface();
@@ -55,13 +120,22 @@ void FVulkanViewport::CreateSwapchain(GLFWwindow* InWindow)
 		}
 	}
 
+	// Pacing against present needs FIFO, the only mode whose present actually waits for vblank.
+	std::string FramePacing;
+	GConfig->Get("FramePacing", FramePacing);
+	const bool bPaceToPresent = FramePacing == "present";
+
+	// FIFO is the only mode every surface has to support, so it always ends the preference list.
 	VkPresentModeKHR ChoosenPresentMode = VK_PRESENT_MODE_FIFO_KHR;
-	for (VkPresentModeKHR PresentMode : PresentModes)
+	if (bPaceToPresent == false)
 	{
-		if (PresentMode == VK_PRESENT_MODE_MAILBOX_KHR)
+		for (VkPresentModeKHR PreferredPresentMode : GetPreferredPresentModes(PresentProfile))
 		{
-			ChoosenPresentMode = PresentMode;
-			break;
+			if (std::find(PresentModes.begin(), PresentModes.end(), PreferredPresentMode) != PresentModes.end())
+			{
+				ChoosenPresentMode = PreferredPresentMode;
+				break;
+			}
 		}
 	}
 
@@ -91,10 +165,7 @@ void FVulkanViewport::CreateSwapchain(GLFWwindow* InWindow)
 			Capabilities.maxImageExtent.height);
 	}
 
-	uint32_t ChoosenImageCount = std::clamp(
-		Capabilities.minImageCount + 1,
-		1U,
-		Capabilities.maxImageCount);
+	uint32_t ChoosenImageCount = GetPreferredImageCount(PresentProfile, ChoosenPresentMode, Capabilities);
 
 	VkSwapchainCreateInfoKHR SwapchainCI{};
 	SwapchainCI.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
@@ -107,6 +178,12 @@ void FVulkanViewport::CreateSwapchain(GLFWwindow* InWindow)
 	SwapchainCI.imageArrayLayers = 1;
 	SwapchainCI.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
 
+	// Lets the readback copy presented frames out of the swapchain.
+	if (Capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_SRC_BIT)
+	{
+		SwapchainCI.imageUsage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+	}
+
 	uint32_t GraphicsFamily = -1;
 	uint32_t PresentFamily = -1;
 	Vk::FindQueueFamilies(PhysicalDevice, Surface, GraphicsFamily, PresentFamily);
@@ -128,8 +205,47 @@ void FVulkanViewport::CreateSwapchain(GLFWwindow* InWindow)
 	SwapchainCI.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
 	SwapchainCI.presentMode = ChoosenPresentMode;
 	SwapchainCI.clipped = VK_TRUE;
+	SwapchainCI.oldSwapchain = InOldSwapchain != nullptr ? InOldSwapchain->GetHandle() : VK_NULL_HANDLE;
 
 	Swapchain = FVulkanSwapchain::Create(Context, SwapchainCI);
+	SwapchainHandle = Swapchain->GetObjectHandle();
+
+	ActivePresentProfile = PresentProfile;
+	PresentMode = ChoosenPresentMode;
+	MinImageCount = ChoosenImageCount;
+}
+
+void FVulkanViewport::CreateOffscreenSwapchain()
+{
+	VkPhysicalDevice PhysicalDevice = Context->GetPhysicalDevice();
+
+	int32_t Width = 800;
+	int32_t Height = 600;
+	int32_t ImageCount = 3;
+	GConfig->Get("WindowWidth", Width);
+	GConfig->Get("WindowHeight", Height);
+	GConfig->Get("OffscreenImageCount", ImageCount);
+
+	VkExtent2D Extent =
+	{
+		static_cast<uint32_t>(std::max(Width, 1)),
+		static_cast<uint32_t>(std::max(Height, 1))
+	};
+
+	VkFormat Format = Vk::FindSupportedFormat(
+		PhysicalDevice,
+		{ VK_FORMAT_B8G8R8A8_SRGB, VK_FORMAT_R8G8B8A8_SRGB },
+		VK_IMAGE_TILING_OPTIMAL,
+		VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT);
+
+	uint32_t ChoosenImageCount = std::max(static_cast<uint32_t>(std::max(ImageCount, 1)), Context->GetMaxConcurrentFrames());
+
+	Swapchain = FVulkanSwapchain::CreateOffscreen(Context, Format, Extent, ChoosenImageCount);
+	SwapchainHandle = Swapchain->GetObjectHandle();
+
+	// Nothing is presented offscreen, so the profile is only kept to label the latency samples.
+	ActivePresentProfile = PresentProfile;
+	MinImageCount = ChoosenImageCount;
 }
 
 void FVulkanViewport::CreateDepthImage()
@@ -138,15 +254,14 @@ void FVulkanViewport::CreateDepthImage()
 
 	VkFormat DepthFormat = Vk::FindDepthFormat(PhysicalDevice);
 
-	if (Context->IsValidObject(DepthImage))
-	{
-		Context->DestroyObject(DepthImage);
-		DepthImage = nullptr;
-	}
+	// In-flight frames may still be depth testing against the old image.
+	Context->RetireObject(DepthImage);
+	DepthImage = nullptr;
 
 	VkExtent2D SwapchainExtent = Swapchain->GetExtent();
 
 	DepthImage = Context->CreateObject<FVulkanImage>();
+	DepthImageHandle = DepthImage->GetObjectHandle();
 	DepthImage->CreateImage(
 		{ SwapchainExtent.width, SwapchainExtent.height, 1 },
 		1,
@@ -164,22 +279,65 @@ void FVulkanViewport::CreateDepthImage()
 
 void FVulkanViewport::Recreate()
 {
-	Cleanup();
-	CreateSwapchain(Context->GetWindow());
-	CreateDepthImage();
+	FVulkanSwapchain* OldSwapchain = Swapchain;
+	const VkExtent2D OldExtent = OldSwapchain->GetExtent();
+
+	if (Context->IsHeadless())
+	{
+		CreateOffscreenSwapchain();
+	}
+	else
+	{
+		CreateSwapchain(Context->GetWindow(), OldSwapchain);
+	}
+
+	// Images of the old swapchain may still be rendered to or waiting for present.
+	Context->RetireObject(OldSwapchain);
+
+	const VkExtent2D NewExtent = Swapchain->GetExtent();
+	if (NewExtent.width != OldExtent.width || NewExtent.height != OldExtent.height)
+	{
+		CreateDepthImage();
+	}
+}
+
+void FVulkanViewport::SetPresentProfile(EPresentProfile InPresentProfile)
+{
+	PresentProfile = InPresentProfile;
+}
+
+const char* FVulkanViewport::GetPresentProfileName(EPresentProfile InPresentProfile)
+{
+	return PresentProfileNames[static_cast<uint32_t>(InPresentProfile)];
+}
+
+bool FVulkanViewport::ParsePresentProfile(const std::string& InName, EPresentProfile& OutPresentProfile)
+{
+	for (uint32_t Idx = 0; Idx < static_cast<uint32_t>(EPresentProfile::Num); ++Idx)
+	{
+		if (InName == PresentProfileNames[Idx])
+		{
+			OutPresentProfile = static_cast<EPresentProfile>(Idx);
+			return true;
+		}
+	}
+
+	return false;
 }
 
 void FVulkanViewport::Cleanup()
 {
-	if (Context->IsValidObject(DepthImage))
+	if (Context->IsValidObject(DepthImageHandle))
 	{
 		Context->DestroyObject(DepthImage);
-		DepthImage = nullptr;
 	}
+	DepthImage = nullptr;
+	DepthImageHandle = FVulkanObjectHandle();
 
-	if (Context->IsValidObject(Swapchain))
+	if (Context->IsValidObject(SwapchainHandle))
 	{
 		Context->DestroyObject(Swapchain);
-		Swapchain = nullptr;
 	}
+	Swapchain = nullptr;
+	SwapchainHandle = FVulkanObjectHandle();
 }
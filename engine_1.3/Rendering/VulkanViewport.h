@@ -5,8 +5,21 @@
 #include "vulkan/vulkan.h"
 #include "glfw/glfw3.h"
 
+#include <string>
 #include <vector>
 
+// How the swapchain trades latency against smoothness. Each profile picks a present mode preference and an image count.
+enum class EPresentProfile : uint32_t
+{
+	// IMMEDIATE or MAILBOX with as few images as the surface allows.
+	LowLatency,
+	// FIFO, vsynced with one image of slack.
+	Smooth,
+	// FIFO_RELAXED with extra images so a late frame tears instead of stalling the queue.
+	Throughput,
+	Num
+};
+
 class FVulkanViewport : public FVulkanObject
 {
 public:
@@ -17,16 +30,42 @@ public:
 
 	virtual void Destroy() override;
 
-	void CreateSwapchain(GLFWwindow* InWindow);
+	// Passing the swapchain being replaced lets the driver hand its resources over to the new one.
+	void CreateSwapchain(GLFWwindow* InWindow, class FVulkanSwapchain* InOldSwapchain = nullptr);
+	void CreateOffscreenSwapchain();
 	void CreateDepthImage();
 
+	// Builds a new swapchain and retires the old one, recreating the depth image only if the size changed.
 	void Recreate();
 	void Cleanup();
 
 	class FVulkanSwapchain* GetSwapchain() const { return Swapchain; }
 	class FVulkanImage* GetDepthImage() const { return DepthImage; }
 
+	// The profile takes effect at the next swapchain recreation, which the context triggers at the end of the frame.
+	void SetPresentProfile(EPresentProfile InPresentProfile);
+	bool IsPresentProfilePending() const { return PresentProfile != ActivePresentProfile; }
+
+	// The profile the current swapchain was created with.
+	EPresentProfile GetPresentProfile() const { return ActivePresentProfile; }
+	VkPresentModeKHR GetPresentMode() const { return PresentMode; }
+
+	// The image count asked of vkCreateSwapchainKHR; the driver may hand out more.
+	uint32_t GetMinImageCount() const { return MinImageCount; }
+
+	static const char* GetPresentProfileName(EPresentProfile InPresentProfile);
+	static bool ParsePresentProfile(const std::string& InName, EPresentProfile& OutPresentProfile);
+
 private:
 	class FVulkanSwapchain* Swapchain;
 	class FVulkanImage* DepthImage;
+
+	// Checked at cleanup, when the context may already have destroyed the objects and reused their memory.
+	FVulkanObjectHandle SwapchainHandle;
+	FVulkanObjectHandle DepthImageHandle;
+
+	EPresentProfile PresentProfile;
+	EPresentProfile ActivePresentProfile;
+	VkPresentModeKHR PresentMode;
+	uint32_t MinImageCount;
 };
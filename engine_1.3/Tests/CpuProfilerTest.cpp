@@ -0,0 +1,89 @@
+#include "CpuProfiler.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <iostream>
+
+// Fills the recording thread's ring over and over while the main thread copies it out. Every event encodes
+// its sequence number in Start, and Name and Depth are derived from it, so a slot that was overwritten
+// during the copy shows up as an event whose fields disagree.
+
+static const char* const EventNames[] = { "Even", "Odd" };
+static const uint32_t EventDepthModulo = 1000;
+static const uint32_t NumReads = 2000;
+
+static bool IsConsistent(const FCpuProfileEvent& InEvent)
+{
+	return InEvent.Name == EventNames[InEvent.Start % 2] && InEvent.Depth == InEvent.Start % EventDepthModulo;
+}
+
+int main()
+{
+	std::atomic<bool> bStop(false);
+	std::atomic<bool> bStarted(false);
+
+	std::thread Writer([&]()
+	{
+		CpuProfiler::SetThreadName("Writer");
+		for (uint64_t Sequence = 0; bStop.load(std::memory_order_relaxed) == false; ++Sequence)
+		{
+			CpuProfiler::BeginScope();
+			CpuProfiler::EndScope(EventNames[Sequence % 2], Sequence, static_cast<uint32_t>(Sequence % EventDepthModulo));
+			bStarted.store(true, std::memory_order_release);
+		}
+	});
+
+	while (bStarted.load(std::memory_order_acquire) == false)
+	{
+		std::this_thread::yield();
+	}
+
+	uint64_t NumChecked = 0;
+	uint64_t NumTorn = 0;
+	uint64_t NumUnordered = 0;
+	std::vector<FCpuProfileThread> Threads;
+	for (uint32_t ReadIdx = 0; ReadIdx < NumReads; ++ReadIdx)
+	{
+		CpuProfiler::GetEvents(Threads);
+		for (const FCpuProfileThread& Thread : Threads)
+		{
+			if (Thread.ThreadName != "Writer")
+			{
+				continue;
+			}
+
+			for (size_t EventIdx = 0; EventIdx < Thread.Events.size(); ++EventIdx)
+			{
+				const FCpuProfileEvent& Event = Thread.Events[EventIdx];
+				if (IsConsistent(Event) == false)
+				{
+					++NumTorn;
+				}
+				else if (EventIdx > 0 && Event.Start != Thread.Events[EventIdx - 1].Start + 1)
+				{
+					++NumUnordered;
+				}
+			}
+			NumChecked += Thread.Events.size();
+		}
+	}
+
+	bStop.store(true, std::memory_order_relaxed);
+	Writer.join();
+
+	std::cout << "Checked " << NumChecked << " events over " << NumReads << " reads" << std::endl;
+	if (NumChecked == 0)
+	{
+		std::cerr << "Never saw the writer thread's events" << std::endl;
+		return 1;
+	}
+	if (NumTorn > 0 || NumUnordered > 0)
+	{
+		std::cerr << NumTorn << " torn and " << NumUnordered << " out of order events" << std::endl;
+		return 1;
+	}
+	std::cout << "OK" << std::endl;
+	return 0;
+}